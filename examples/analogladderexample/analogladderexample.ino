@@ -0,0 +1,223 @@
+/**
+ * @file    analogladderexample.ino
+ * @brief   Example of the AnalogButtonLadder: the 5 buttons of the LCD keypad shield on one analog pin
+ * @author  Yunhui Fu (yhfudev@gmail.com)
+ * @version 1.0
+ * @date    2016-07-14
+ * @copyright GPL
+ */
+#include "sysport.h"
+#include "analogladder.h"
+
+#ifndef TRACE
+#define TRACE(...)
+#endif
+
+// 0 -- verbose, 1 -- info, 2 -- warning, 3 -- error
+#define TRACE0 TRACE
+#define TRACE1 TRACE
+#define TRACE2 TRACE
+#define TRACE3 TRACE
+
+#if defined(ARDUINO)
+#define PORT_KEYPAD A0
+#else
+#define PORT_KEYPAD 0
+#endif
+
+#define NUM_KEYS 5
+
+// the readings of the keys: right 0, up 145, down 330, left 505, select 740, none 1023,
+// the thresholds are the middle of the readings
+static const uint16_t keypad_thresholds[NUM_KEYS] PROGMEM = { 72, 237, 417, 622, 881 };
+#if DEBUG
+static const char * keypad_names[NUM_KEYS] = { "right", "up", "down", "left", "select" };
+#endif
+
+AnalogButtonLadder<NUM_KEYS> keypad;
+
+void
+keypad_on_click(uint8_t idx, unsigned int times)
+{
+    TRACE1 ("INFO: key %s pressed %d times", keypad_names[idx], times);
+}
+
+void
+keypad_on_longpress(uint8_t idx)
+{
+    TRACE1 ("INFO: key %s long pressed", keypad_names[idx]);
+}
+
+#if ! defined(ARDUINO)
+#include "scriptpin.h"
+
+static const uint16_t keypad_readings[NUM_KEYS + 1] = { 0, 145, 330, 505, 740, 1023 };
+
+static uint32_t g_seed = 1;
+static int
+noise (int amp)
+{
+    g_seed = g_seed * 1103515245 + 12345;
+    return (int)((g_seed >> 8) % (2 * amp + 1)) - amp;
+}
+
+// the band of each reading without the hysteresis is the same as the linear scan
+void
+check_decode (void)
+{
+    AnalogButtonLadder<NUM_KEYS> ladder;
+    uint16_t r;
+    uint8_t i;
+    uint8_t expected;
+    bool idle_low;
+    for (idle_low = false; ; idle_low = true) {
+        ladder.set_ladder (PORT_KEYPAD, keypad_thresholds, idle_low, 0);
+        for (r = 0; r < 1024; r ++) {
+            for (i = 0; (i < NUM_KEYS) && (keypad_thresholds[i] <= r); i ++);
+            if (idle_low) {
+                expected = ((i > 0) ? (i - 1) : ANALOGLADDER_NONE);
+            } else {
+                expected = ((i < NUM_KEYS) ? i : ANALOGLADDER_NONE);
+            }
+            assert (expected == ladder.decode (r));
+        }
+        if (idle_low) {
+            break;
+        }
+    }
+    printf ("decode: the binary search is the same as the linear scan for all of the readings\n");
+}
+
+// the noisy readings around the threshold between up and down
+void
+check_hysteresis (void)
+{
+#define NOISE_SAMPLES 10000
+    AnalogButtonLadder<NUM_KEYS> ladder0;
+    AnalogButtonLadder<NUM_KEYS> ladder8;
+    unsigned int changes0 = 0;
+    unsigned int changes8 = 0;
+    uint8_t last0 = ANALOGLADDER_NONE;
+    uint8_t last8 = ANALOGLADDER_NONE;
+    uint8_t b;
+    unsigned int k;
+    uint16_t r;
+    ladder0.set_ladder (PORT_KEYPAD, keypad_thresholds, false, 0);
+    ladder8.set_ladder (PORT_KEYPAD, keypad_thresholds, false, 8);
+    for (k = 0; k < NOISE_SAMPLES; k ++) {
+        r = keypad_thresholds[1] + noise (4);
+        b = ladder0.decode (r);
+        changes0 += (b != last0);
+        last0 = b;
+        b = ladder8.decode (r);
+        changes8 += (b != last8);
+        last8 = b;
+    }
+    assert (changes8 <= 1);
+    printf ("hysteresis: %u readings of %u +/- 4: %u key changes without hysteresis, %u with 8\n"
+        , NOISE_SAMPLES, keypad_thresholds[1], changes0, changes8);
+}
+
+// the hash of the events of each key
+static uint32_t g_hash_ladder[NUM_KEYS];
+static uint32_t g_hash_bank[NUM_KEYS];
+static unsigned long g_now = 0;
+
+void ladder_hash_click (uint8_t idx, unsigned int times) { HASH_EVENT(g_hash_ladder[idx], 1, times, g_now); }
+void ladder_hash_long (uint8_t idx) { HASH_EVENT(g_hash_ladder[idx], 4, 0, g_now); }
+void bank_hash_click (uint8_t idx, unsigned int times) { HASH_EVENT(g_hash_bank[idx], 1, times, g_now); }
+void bank_hash_long (uint8_t idx) { HASH_EVENT(g_hash_bank[idx], 4, 0, g_now); }
+
+// the scripted presses of the random keys with the noisy readings, the events should be
+// the same as the ButtonBank fed with the pressed keys
+void
+check_clicks (void)
+{
+#define SIM_TIME 600000
+    static const unsigned int press_ms[] = { 80, 150, 1500 };
+    AnalogButtonLadder<NUM_KEYS> ladder;
+    ButtonBank<NUM_KEYS> bank;
+    unsigned long t_next = 0;
+    uint8_t key = NUM_KEYS;
+    uint8_t i;
+    double t0, t1;
+
+    ladder.set_ladder (PORT_KEYPAD, keypad_thresholds);
+    ladder.on_click (Delegate<void(uint8_t, unsigned int)>::from_function<ladder_hash_click>());
+    ladder.on_long_press (Delegate<void(uint8_t)>::from_function<ladder_hash_long>());
+    bank.set_used ((1 << NUM_KEYS) - 1);
+    bank.on_click (Delegate<void(uint8_t, unsigned int)>::from_function<bank_hash_click>());
+    bank.on_long_press (Delegate<void(uint8_t)>::from_function<bank_hash_long>());
+    for (i = 0; i < NUM_KEYS; i ++) {
+        g_hash_ladder[i] = g_hash_bank[i] = 0;
+    }
+    t0 = get_time_ns();
+    for (g_now = 0; g_now < SIM_TIME; g_now ++) {
+        if (g_now >= t_next) {
+            if (key < NUM_KEYS) {
+                // released
+                key = NUM_KEYS;
+                t_next += 200 + noise (100) + 100;
+            } else {
+                key = (g_seed >> 8) % NUM_KEYS;
+                t_next += press_ms[(g_seed >> 16) % 3] + noise (20);
+            }
+        }
+        ladder.update_reading (keypad_readings[key] + ((key < NUM_KEYS) ? 3 + noise (3) : - 3 - noise (3)), g_now);
+        bank.update_bits (((key < NUM_KEYS) ? (1 << key) : 0), g_now);
+    }
+    t1 = get_time_ns();
+    for (i = 0; i < NUM_KEYS; i ++) {
+        assert (0 != g_hash_ladder[i]);
+        assert (g_hash_ladder[i] == g_hash_bank[i]);
+    }
+    printf ("clicks: %u ms of the noisy readings, the same events as the ButtonBank (%5.1f ns/update)\n"
+        , SIM_TIME, (t1 - t0) / SIM_TIME);
+}
+#endif
+
+void
+setup(void)
+{
+#if DEBUG && defined(ARDUINO)
+    Serial.begin(9600);
+    // Wait for USB Serial.
+    while (!Serial) {}
+
+    // Read any input
+    delay(200);
+    while (Serial.read() >= 0) {}
+#endif
+
+    keypad.set_ladder (PORT_KEYPAD, keypad_thresholds);
+    keypad.set_multiple_click (1, true); // up
+    keypad.set_multiple_click (2, true); // down
+    keypad.on_click (Delegate<void(uint8_t, unsigned int)>::from_function<keypad_on_click>());
+    keypad.on_long_press (Delegate<void(uint8_t)>::from_function<keypad_on_longpress>());
+
+#if ! defined(ARDUINO)
+    check_decode ();
+    check_hysteresis ();
+    check_clicks ();
+    exit (0);
+#endif
+}
+
+void
+loop(void)
+{
+    // one conversion for all of the keys
+    keypad.update();
+}
+
+#if ! defined(ARDUINO)
+int
+main(void)
+{
+    setup();
+    while (1) {
+        loop();
+    }
+    return 0;
+}
+#endif
@@ -0,0 +1,222 @@
+/**
+ * @file    basicbuttonexample.ino
+ * @brief   Example of the BasicButton: the buttons with the different policies, compared with the Button
+ * @author  Yunhui Fu (yhfudev@gmail.com)
+ * @version 1.0
+ * @date    2016-07-14
+ * @copyright GPL
+ */
+#include "sysport.h"
+#include "button.h"
+#include "basicbutton.h"
+
+#ifndef TRACE
+#define TRACE(...)
+#endif
+
+// 0 -- verbose, 1 -- info, 2 -- warning, 3 -- error
+#define TRACE0 TRACE
+#define TRACE1 TRACE
+#define TRACE2 TRACE
+#define TRACE3 TRACE
+
+#if defined(ARDUINO)
+#define PORT_POWER 2
+#define PORT_MENU  3
+#else
+// the pin reads HIGH on PC
+#define PORT_POWER 3
+#define PORT_MENU  12
+#endif
+
+// the power button: only the click and the long press, slower long press
+struct PowerButtonPolicy : public ButtonPolicy {
+    static const uint16_t timeout_long = 2000;
+    static const uint8_t events = BUTSW_CB_CLICK | BUTSW_CB_LONG;
+};
+// the menu button: the double clicks
+struct MenuButtonPolicy : public ButtonPolicy {
+    static const bool multiple_click = true;
+    static const uint8_t events = BUTSW_CB_CLICK;
+};
+
+BasicButton<PowerButtonPolicy> butt_power;
+BasicButton<MenuButtonPolicy> butt_menu;
+
+void
+power_on_click(unsigned int times)
+{
+    TRACE1 ("INFO: power pressed %d times", times);
+}
+
+void
+power_on_longpress(void)
+{
+    TRACE1 ("INFO: power long pressed");
+}
+
+void
+menu_on_click(unsigned int times)
+{
+    TRACE1 ("INFO: menu pressed %d times", times);
+}
+
+#if ! defined(ARDUINO)
+#include "scriptpin.h"
+
+// the time of the simulation
+#define SIM_TIME 600000
+
+// the hash of the events: the type, the times and the time
+static uint32_t g_hash_butt = 0;
+static uint32_t g_hash_basic = 0;
+static unsigned long g_now = 0;
+
+void butt_hash_click (unsigned int times) { HASH_EVENT(g_hash_butt, 1, times, g_now); }
+void butt_hash_start (void) { HASH_EVENT(g_hash_butt, 2, 0, g_now); }
+void butt_hash_end (void) { HASH_EVENT(g_hash_butt, 3, 0, g_now); }
+void butt_hash_long (void) { HASH_EVENT(g_hash_butt, 4, 0, g_now); }
+void butt_hash_vlong (void) { HASH_EVENT(g_hash_butt, 5, 0, g_now); }
+void basic_hash_click (unsigned int times) { HASH_EVENT(g_hash_basic, 1, times, g_now); }
+void basic_hash_start (void) { HASH_EVENT(g_hash_basic, 2, 0, g_now); }
+void basic_hash_end (void) { HASH_EVENT(g_hash_basic, 3, 0, g_now); }
+void basic_hash_long (void) { HASH_EVENT(g_hash_basic, 4, 0, g_now); }
+void basic_hash_vlong (void) { HASH_EVENT(g_hash_basic, 5, 0, g_now); }
+
+template <bool MULTI>
+struct CheckPolicy : public ButtonPolicy {
+    static const bool multiple_click = MULTI;
+};
+
+// the same script to the Button and the BasicButton with the default timeouts, the events should be the same
+template <bool MULTI>
+void
+check_basic (void)
+{
+    ScriptButton<MULTI> butt;
+    BasicButton<CheckPolicy<MULTI> > basic;
+    ScriptPin script;
+    double t0, t1, t2;
+
+    butt.set_pin (PORT_POWER, HIGH);
+    butt.on_click (Delegate<void(unsigned int)>::from_function<butt_hash_click>());
+    butt.on_start (Delegate<void()>::from_function<butt_hash_start>());
+    butt.on_end (Delegate<void()>::from_function<butt_hash_end>());
+    butt.on_long_press (Delegate<void()>::from_function<butt_hash_long>());
+    butt.on_vlong_press (Delegate<void()>::from_function<butt_hash_vlong>());
+    basic.set_pin (PORT_POWER, HIGH);
+    basic.on_click (Delegate<void(unsigned int)>::from_function<basic_hash_click>());
+    basic.on_start (Delegate<void()>::from_function<basic_hash_start>());
+    basic.on_end (Delegate<void()>::from_function<basic_hash_end>());
+    basic.on_long_press (Delegate<void()>::from_function<basic_hash_long>());
+    basic.on_vlong_press (Delegate<void()>::from_function<basic_hash_vlong>());
+    g_hash_butt = g_hash_basic = 0;
+
+    script.begin (1);
+    t0 = get_time_ns();
+    for (g_now = 0; g_now < SIM_TIME; g_now ++) {
+        butt.feed (script.get (g_now), g_now);
+    }
+    t1 = get_time_ns();
+    script.begin (1);
+    for (g_now = 0; g_now < SIM_TIME; g_now ++) {
+        basic.update_pin (script.get (g_now), g_now);
+    }
+    t2 = get_time_ns();
+    assert (0 != g_hash_butt);
+    assert (g_hash_butt == g_hash_basic);
+    printf ("%u ms scripted, multiple click %d: Button %5.1f ns/update, BasicButton %5.1f ns/update, same events\n"
+        , SIM_TIME, MULTI, (t1 - t0) / SIM_TIME, (t2 - t1) / SIM_TIME);
+}
+
+// press the button for press_ms, return the events of BasicButton<Policy>: 1 -- click, 4 -- long press
+static uint8_t g_events = 0;
+void power_event_click (unsigned int times) { g_events |= 1; }
+void power_event_long (void) { g_events |= 4; }
+
+template <class Policy>
+uint8_t
+press_basic (unsigned long press_ms)
+{
+    BasicButton<Policy> butt;
+    unsigned long t;
+    g_events = 0;
+    butt.set_pin (PORT_POWER, HIGH);
+    butt.on_click (Delegate<void(unsigned int)>::from_function<power_event_click>());
+    butt.on_long_press (Delegate<void()>::from_function<power_event_long>());
+    for (t = 0; t < press_ms; t ++) {
+        butt.update_pin (HIGH, t);
+    }
+    for (; butt.update_pin (LOW, t); t ++);
+    return g_events;
+}
+
+struct LongButtonPolicy : public ButtonPolicy {
+    static const uint8_t events = BUTSW_CB_CLICK | BUTSW_CB_LONG;
+};
+
+// the long press of the power button is later than the default, and it has no very long press
+void
+check_power (void)
+{
+    assert (1 == press_basic<PowerButtonPolicy> (BUTSW_TIMEOUT_DBOUNCE + BUTSW_TIMEOUT_LONG + 100));
+    assert (4 == press_basic<LongButtonPolicy> (BUTSW_TIMEOUT_DBOUNCE + BUTSW_TIMEOUT_LONG + 100));
+    assert (4 == press_basic<PowerButtonPolicy> (PowerButtonPolicy::timeout_debounce + PowerButtonPolicy::timeout_long + 100));
+    assert (4 == press_basic<PowerButtonPolicy> (PowerButtonPolicy::timeout_debounce + PowerButtonPolicy::timeout_vlong + 100));
+    printf ("power button: long press after %d ms, no very long press\n", PowerButtonPolicy::timeout_long);
+}
+#endif
+
+void
+setup(void)
+{
+#if DEBUG && defined(ARDUINO)
+    Serial.begin(9600);
+    // Wait for USB Serial.
+    while (!Serial) {}
+
+    // Read any input
+    delay(200);
+    while (Serial.read() >= 0) {}
+#endif
+
+    pinMode (PORT_POWER, INPUT_PULLUP);
+    pinMode (PORT_MENU, INPUT_PULLUP);
+    butt_power.set_pin (PORT_POWER, LOW);
+    butt_power.on_click (Delegate<void(unsigned int)>::from_function<power_on_click>());
+    butt_power.on_long_press (Delegate<void()>::from_function<power_on_longpress>());
+    butt_menu.set_pin (PORT_MENU, LOW);
+    butt_menu.on_click (Delegate<void(unsigned int)>::from_function<menu_on_click>());
+
+    TRACE1 ("sizeof: Button %d, BasicButton<> %d, BasicButton<PowerButtonPolicy> %d, BasicButton<MenuButtonPolicy> %d"
+        , (int)sizeof(Button), (int)sizeof(BasicButton<>), (int)sizeof(butt_power), (int)sizeof(butt_menu));
+
+#if ! defined(ARDUINO)
+    printf ("sizeof: Button %d, BasicButton<> %d, BasicButton<PowerButtonPolicy> %d, BasicButton<MenuButtonPolicy> %d\n"
+        , (int)sizeof(Button), (int)sizeof(BasicButton<>), (int)sizeof(butt_power), (int)sizeof(butt_menu));
+    check_basic<false> ();
+    check_basic<true> ();
+    check_power ();
+    exit (0);
+#endif
+}
+
+void
+loop(void)
+{
+    unsigned long now = millis();
+    butt_power.update (now);
+    butt_menu.update (now);
+}
+
+#if ! defined(ARDUINO)
+int
+main(void)
+{
+    setup();
+    while (1) {
+        loop();
+    }
+    return 0;
+}
+#endif
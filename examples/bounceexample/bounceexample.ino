@@ -0,0 +1,148 @@
+/**
+ * @file    bounceexample.ino
+ * @brief   Example of the adaptive debounce of the Button: the window learned from the bounces of the switch
+ * @author  Yunhui Fu (yhfudev@gmail.com)
+ * @version 1.0
+ * @date    2016-07-14
+ * @copyright GPL
+ */
+#include "sysport.h"
+#include "button.h"
+
+#ifndef TRACE
+#define TRACE(...)
+#endif
+
+// 0 -- verbose, 1 -- info, 2 -- warning, 3 -- error
+#define TRACE0 TRACE
+#define TRACE1 TRACE
+#define TRACE2 TRACE
+#define TRACE3 TRACE
+
+#define PORT_SWITCH 3
+
+Button butt(false);
+
+void
+butt_on_click(unsigned int times)
+{
+    TRACE1 ("INFO: switch pressed %d times, debounce %d ms", times, butt.get_debounce());
+}
+
+#if ! defined(ARDUINO)
+#include "scriptpin.h"
+
+// the switch pressed for 100 ms every 500 ms, bouncing for bounce_ms after each edge
+class BouncySwitch {
+public:
+    BouncySwitch (uint8_t bounce_ms1) : bounce_ms(bounce_ms1) {}
+    inline uint8_t get (unsigned long now) {
+        unsigned long t = now % 500;
+        bool pressed = (t < 100);
+        unsigned long since = (pressed ? t : t - 100);
+        if (since < this->bounce_ms) {
+            // the random level in the bounce
+            uint32_t h = (uint32_t)now * 2654435761u;
+            if ((h >> 16) & 0x01) {
+                pressed = ! pressed;
+            }
+        }
+        return (pressed ? HIGH : LOW);
+    }
+private:
+    unsigned long bounce_ms;
+};
+
+static unsigned long g_now = 0;
+static unsigned int g_clicks;
+static unsigned long g_latency; // the sum of the time from the press to the start
+void sim_on_click (unsigned int times) { g_clicks += times; }
+void sim_on_start (void) { g_latency += g_now % 500; }
+
+#define SIM_PRESSES 200
+
+// run the presses of the switch with the debounce (0: fixed), return the false clicks
+static unsigned int
+run_switch (uint8_t bounce_ms, uint8_t min_ms, uint8_t max_ms, unsigned long & latency, unsigned int & window)
+{
+    BouncySwitch sw(bounce_ms);
+    ScriptButton<false> sb;
+    sb.set_pin (PORT_SWITCH, HIGH);
+    sb.set_debounce (min_ms, max_ms);
+    sb.on_click (Delegate<void(unsigned int)>::from_function<sim_on_click>());
+    sb.on_start (Delegate<void()>::from_function<sim_on_start>());
+    g_clicks = 0;
+    g_latency = 0;
+    for (g_now = 0; g_now < SIM_PRESSES * 500; g_now ++) {
+        sb.feed (sw.get (g_now), g_now);
+    }
+    latency = g_latency / SIM_PRESSES;
+    window = sb.get_debounce();
+    return ((g_clicks > SIM_PRESSES) ? (g_clicks - SIM_PRESSES) : (SIM_PRESSES - g_clicks));
+}
+
+void
+check_switches (void)
+{
+    static const uint8_t bounces[] = { 1, 3, 10, 25, 45 };
+    unsigned int i;
+    unsigned int err_fixed, err_adapt;
+    unsigned long lat_fixed, lat_adapt;
+    unsigned int win_fixed, win_adapt;
+    for (i = 0; i < sizeof(bounces) / sizeof(bounces[0]); i ++) {
+        err_fixed = run_switch (bounces[i], 0, 0, lat_fixed, win_fixed);
+        err_adapt = run_switch (bounces[i], 5, 80, lat_adapt, win_adapt);
+        printf ("bounce %2d ms: fixed %2u ms: %3u wrong clicks, latency %2lu ms; adaptive %2u ms: %3u wrong clicks, latency %2lu ms\n"
+            , bounces[i], win_fixed, err_fixed, lat_fixed, win_adapt, err_adapt, lat_adapt);
+        assert (win_fixed == BUTSW_TIMEOUT_DBOUNCE);
+        assert ((win_adapt >= 5) && (win_adapt <= 80));
+        // the window fits the switch after the first presses with the upper bound
+        assert (err_adapt <= 1);
+        if (bounces[i] * 2 < BUTSW_TIMEOUT_DBOUNCE) {
+            assert (lat_adapt < lat_fixed);
+        }
+    }
+}
+#endif
+
+void
+setup(void)
+{
+#if DEBUG && defined(ARDUINO)
+    Serial.begin(9600);
+    // Wait for USB Serial.
+    while (!Serial) {}
+
+    // Read any input
+    delay(200);
+    while (Serial.read() >= 0) {}
+#endif
+
+    pinMode(PORT_SWITCH, INPUT_PULLUP);
+    butt.set_pin (PORT_SWITCH, LOW);
+    butt.set_debounce (5, 80);
+    butt.on_click (Delegate<void(unsigned int)>::from_function<butt_on_click>());
+
+#if ! defined(ARDUINO)
+    check_switches ();
+    exit (0);
+#endif
+}
+
+void
+loop(void)
+{
+    butt.update();
+}
+
+#if ! defined(ARDUINO)
+int
+main(void)
+{
+    setup();
+    while (1) {
+        loop();
+    }
+    return 0;
+}
+#endif
@@ -0,0 +1,212 @@
+/**
+ * @file    buttonbankexample.ino
+ * @brief   Example of the ButtonBank: N buttons updated together, compared with N Button objects
+ * @author  Yunhui Fu (yhfudev@gmail.com)
+ * @version 1.0
+ * @date    2016-07-14
+ * @copyright GPL
+ */
+#include "sysport.h"
+#include "button.h"
+#include "buttonbank.h"
+
+#ifndef TRACE
+#define TRACE(...)
+#endif
+
+// 0 -- verbose, 1 -- info, 2 -- warning, 3 -- error
+#define TRACE0 TRACE
+#define TRACE1 TRACE
+#define TRACE2 TRACE
+#define TRACE3 TRACE
+
+#if defined(ARDUINO)
+#define NUM_BUTTONS  4
+#define PORT_SWITCH  2
+#define PRESSED_STATE LOW
+#else
+#define NUM_BUTTONS 32
+// the pins read LOW on PC
+#define PORT_SWITCH 20
+#define PRESSED_STATE HIGH
+#endif
+
+ButtonBank<NUM_BUTTONS> bank;
+
+void
+bank_on_click(uint8_t idx, unsigned int times)
+{
+    TRACE1 ("INFO: button %d pressed %d times", idx, times);
+}
+
+void
+bank_on_longpress(uint8_t idx)
+{
+    TRACE1 ("INFO: button %d long pressed", idx);
+}
+
+#if ! defined(ARDUINO)
+#include "scriptpin.h"
+
+// the time of the simulation
+#define SIM_TIME 60000
+
+ScriptPin script[NUM_BUTTONS];
+
+// the hash of the events of each button: the type, the times and the time
+static uint32_t g_hash_butt[NUM_BUTTONS];
+static uint32_t g_hash_bank[NUM_BUTTONS];
+static unsigned long g_now = 0;
+
+struct ButtonIndex {
+    uint8_t idx;
+    void on_click (unsigned int times) { HASH_EVENT(g_hash_butt[this->idx], 1, times, g_now); }
+    void on_start (void) { HASH_EVENT(g_hash_butt[this->idx], 2, 0, g_now); }
+    void on_end (void) { HASH_EVENT(g_hash_butt[this->idx], 3, 0, g_now); }
+    void on_long (void) { HASH_EVENT(g_hash_butt[this->idx], 4, 0, g_now); }
+    void on_vlong (void) { HASH_EVENT(g_hash_butt[this->idx], 5, 0, g_now); }
+};
+ButtonIndex butt_idx[NUM_BUTTONS];
+
+void bank_hash_click (uint8_t idx, unsigned int times) { HASH_EVENT(g_hash_bank[idx], 1, times, g_now); }
+void bank_hash_start (uint8_t idx) { HASH_EVENT(g_hash_bank[idx], 2, 0, g_now); }
+void bank_hash_end (uint8_t idx) { HASH_EVENT(g_hash_bank[idx], 3, 0, g_now); }
+void bank_hash_long (uint8_t idx) { HASH_EVENT(g_hash_bank[idx], 4, 0, g_now); }
+void bank_hash_vlong (uint8_t idx) { HASH_EVENT(g_hash_bank[idx], 5, 0, g_now); }
+
+// the same script to the N Buttons and the ButtonBank, the events should be the same
+template <bool MULTI>
+void
+check_bank (void)
+{
+    static ScriptButton<MULTI> butts[NUM_BUTTONS];
+    ButtonBank<NUM_BUTTONS> sbank;
+    typename ButtonBank<NUM_BUTTONS>::mask_t pressed;
+    unsigned int i;
+    double t0, t1, t2;
+
+    for (i = 0; i < NUM_BUTTONS; i ++) {
+        butt_idx[i].idx = i;
+        butts[i].set_pin (PORT_SWITCH + i, HIGH);
+        butts[i].on_click (Delegate<void(unsigned int)>::from_method<ButtonIndex, &ButtonIndex::on_click>(&(butt_idx[i])));
+        butts[i].on_start (Delegate<void()>::from_method<ButtonIndex, &ButtonIndex::on_start>(&(butt_idx[i])));
+        butts[i].on_end (Delegate<void()>::from_method<ButtonIndex, &ButtonIndex::on_end>(&(butt_idx[i])));
+        butts[i].on_long_press (Delegate<void()>::from_method<ButtonIndex, &ButtonIndex::on_long>(&(butt_idx[i])));
+        butts[i].on_vlong_press (Delegate<void()>::from_method<ButtonIndex, &ButtonIndex::on_vlong>(&(butt_idx[i])));
+        sbank.set_pin (i, PORT_SWITCH + i, HIGH);
+        sbank.set_multiple_click (i, MULTI);
+        g_hash_butt[i] = g_hash_bank[i] = 0;
+    }
+    sbank.on_click (Delegate<void(uint8_t, unsigned int)>::from_function<bank_hash_click>());
+    sbank.on_start (Delegate<void(uint8_t)>::from_function<bank_hash_start>());
+    sbank.on_end (Delegate<void(uint8_t)>::from_function<bank_hash_end>());
+    sbank.on_long_press (Delegate<void(uint8_t)>::from_function<bank_hash_long>());
+    sbank.on_vlong_press (Delegate<void(uint8_t)>::from_function<bank_hash_vlong>());
+
+    for (i = 0; i < NUM_BUTTONS; i ++) {
+        script[i].begin (i + 1);
+    }
+    t0 = get_time_ns();
+    for (g_now = 0; g_now < SIM_TIME; g_now ++) {
+        for (i = 0; i < NUM_BUTTONS; i ++) {
+            butts[i].feed (script[i].get (g_now), g_now);
+        }
+    }
+    t1 = get_time_ns();
+    for (i = 0; i < NUM_BUTTONS; i ++) {
+        script[i].begin (i + 1);
+    }
+    for (g_now = 0; g_now < SIM_TIME; g_now ++) {
+        pressed = 0;
+        for (i = 0; i < NUM_BUTTONS; i ++) {
+            if (script[i].get (g_now)) {
+                pressed |= ((typename ButtonBank<NUM_BUTTONS>::mask_t)1) << i;
+            }
+        }
+        sbank.update_bits (pressed, g_now);
+    }
+    t2 = get_time_ns();
+    for (i = 0; i < NUM_BUTTONS; i ++) {
+        assert (0 != g_hash_butt[i]);
+        assert (g_hash_butt[i] == g_hash_bank[i]);
+    }
+    printf ("%u buttons, %u ms scripted, multiple click %d: %d Button %7.1f ns/loop, ButtonBank %7.1f ns/loop, same events\n"
+        , NUM_BUTTONS, SIM_TIME, MULTI, NUM_BUTTONS
+        , (t1 - t0) / SIM_TIME, (t2 - t1) / SIM_TIME);
+}
+
+// the idle loops reading the pins
+void
+bench_idle (void)
+{
+#define BENCH_LOOPS 10000
+    static Button butts[NUM_BUTTONS];
+    unsigned long k;
+    unsigned int i;
+    double t0, t1, t2;
+    for (i = 0; i < NUM_BUTTONS; i ++) {
+        butts[i].set_pin (PORT_SWITCH + i, PRESSED_STATE);
+    }
+    t0 = get_time_ns();
+    for (k = 0; k < BENCH_LOOPS; k ++) {
+        for (i = 0; i < NUM_BUTTONS; i ++) {
+            butts[i].update (k);
+        }
+    }
+    t1 = get_time_ns();
+    for (k = 0; k < BENCH_LOOPS; k ++) {
+        bank.update (k);
+    }
+    t2 = get_time_ns();
+    printf ("%u buttons idle: %d Button %7.1f ns/loop, ButtonBank %7.1f ns/loop\n"
+        , NUM_BUTTONS, NUM_BUTTONS, (t1 - t0) / BENCH_LOOPS, (t2 - t1) / BENCH_LOOPS);
+}
+#endif
+
+void
+setup(void)
+{
+    unsigned int i;
+#if DEBUG && defined(ARDUINO)
+    Serial.begin(9600);
+    // Wait for USB Serial.
+    while (!Serial) {}
+
+    // Read any input
+    delay(200);
+    while (Serial.read() >= 0) {}
+#endif
+
+    for (i = 0; i < NUM_BUTTONS; i ++) {
+        pinMode (PORT_SWITCH + i, INPUT_PULLUP);
+        bank.set_pin (i, PORT_SWITCH + i, PRESSED_STATE);
+    }
+    bank.set_multiple_click (0, true);
+    bank.on_click (Delegate<void(uint8_t, unsigned int)>::from_function<bank_on_click>());
+    bank.on_long_press (Delegate<void(uint8_t)>::from_function<bank_on_longpress>());
+
+#if ! defined(ARDUINO)
+    check_bank<false> ();
+    check_bank<true> ();
+    bench_idle ();
+    exit (0);
+#endif
+}
+
+void
+loop(void)
+{
+    bank.update();
+}
+
+#if ! defined(ARDUINO)
+int
+main(void)
+{
+    setup();
+    while (1) {
+        loop();
+    }
+    return 0;
+}
+#endif
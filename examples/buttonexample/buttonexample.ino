@@ -1,6 +1,18 @@
 
 #include "sysport.h"
 #include "button.h"
+#include "timerint.h"
+#include "frameclock.h"
+
+// 1 -- the timeouts are armed on TimerInt, 0 -- polled by millis() in update()
+#ifndef USE_TIMERINT
+#define USE_TIMERINT 1
+#endif
+
+// 1 -- the pin is bound at compile time by FastButton, 0 -- set at runtime
+#ifndef USE_FASTGPIO
+#define USE_FASTGPIO 0
+#endif
 
 #ifndef TRACE
 #define TRACE(...)
@@ -50,7 +62,20 @@ butt_on_end(void *userdata)
    digitalWrite (PORT_LED_PWM, LOW);
 }
 
+#if USE_FASTGPIO
+#if defined(ARDUINO)
+FastButton<PORT_SWITCH> butt(LOW);
+#else
+// the simulated switch on PC is HIGH when pressed
+FastButton<PORT_SWITCH> butt(HIGH);
+#endif
+#else
 Button butt(false);
+#endif
+FrameClock clk;
+#if USE_TIMERINT
+TimerInt timers;
+#endif
 
 void
 setup(void)
@@ -66,13 +91,19 @@ setup(void)
 #endif
 
     pinMode (PORT_SWITCH, INPUT_PULLUP);
+#if ! USE_FASTGPIO
     butt.set_pin (PORT_SWITCH);
+#endif
     butt.set_user_data ((void *)PORT_SWITCH);
     butt.on_click (butt_on_click);
     butt.on_long_press (butt_on_longpress);
     butt.on_vlong_press (butt_on_vlongpress);
     butt.on_start (butt_on_begin);
     butt.on_end (butt_on_end);
+#if USE_TIMERINT
+    timers.tick (millis());
+    butt.set_timer (&timers);
+#endif
 
     pinMode(LED_BUILTIN, OUTPUT);
     pinMode(PORT_LED_PWM, OUTPUT);
@@ -81,7 +112,12 @@ setup(void)
 void
 loop(void)
 {
-    butt.update();
+    // all of the objects see the same time in one loop
+    unsigned long now = clk.tick();
+#if USE_TIMERINT
+    timers.update (now);
+#endif
+    butt.update (now);
 }
 
 #if ! defined(ARDUINO)
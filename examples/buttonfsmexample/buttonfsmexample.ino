@@ -0,0 +1,336 @@
+/**
+ * @file    buttonfsmexample.ino
+ * @brief   Check the table of the button state machine generated from doc/button.dia against the hand-written switch
+ * @author  Yunhui Fu (yhfudev@gmail.com)
+ * @version 1.0
+ * @date    2016-07-14
+ * @copyright GPL
+ */
+#include "sysport.h"
+#include "buttonfsm.h"
+
+#ifndef TRACE
+#define TRACE(...)
+#endif
+
+// 0 -- verbose, 1 -- info, 2 -- warning, 3 -- error
+#define TRACE0 TRACE
+#define TRACE1 TRACE
+#define TRACE2 TRACE
+#define TRACE3 TRACE
+
+#undef TRACE0
+#define TRACE0(...)
+
+#if ! defined(ARDUINO)
+#include "scriptpin.h"
+
+// the state machine of the hand-written nested switch,
+// not inlined so that both of the benchmarks pay for the call
+static void __attribute__((noinline, noclone))
+buttonfsm_step_switch (buttonfsm_t * fsm, uint8_t event, bool multiple_click, bool debounced)
+{
+    uint8_t next_state = fsm->state;
+    fsm->timer = BUTSW_TIMER_KEEP;
+    fsm->cb = 0;
+    switch (fsm->state) {
+    case BUTSW_STATE_READY:
+        switch (event) {
+        case BUTSW_EVT_TIMEOUT:
+            // the time to merge the clicks passed
+            if (fsm->clicks > 0) {
+                fsm->cb = BUTSW_CB_END | BUTSW_CB_CLICK;
+                fsm->times = fsm->clicks;
+                fsm->clicks = 0;
+            }
+            break;
+        case BUTSW_EVT_PRESSED:
+            fsm->hold = 1;
+            next_state = BUTSW_STATE_DEBOUNCE;
+            fsm->timer = BUTSW_TIMER_DBOUNCE;
+            break;
+        default:
+            TRACE0 ("Button: Unhandled : %s", VAL2CSTR_BUTTSW_EVT(event));
+            break;
+        }
+        break;
+
+    case BUTSW_STATE_DEBOUNCE:
+        switch (event) {
+        case BUTSW_EVT_TIMEOUT:
+            // check the current button status
+            if (fsm->hold) {
+                fsm->timer = BUTSW_TIMER_LONG;
+                next_state = BUTSW_STATE_1CLICK;
+                fsm->cb = BUTSW_CB_START;
+            } else {
+                next_state = BUTSW_STATE_READY;
+            }
+            break;
+        case BUTSW_EVT_PRESSED:
+            fsm->hold = 1;
+            break;
+        case BUTSW_EVT_RELEASED:
+            fsm->hold = 0;
+            break;
+        default:
+            TRACE0 ("Button: Unhandled : %s", VAL2CSTR_BUTTSW_EVT(event));
+            break;
+        }
+        break;
+
+    case BUTSW_STATE_1CLICK:
+        switch (event) {
+        case BUTSW_EVT_TIMEOUT:
+            // check the current button status
+            if (fsm->hold) {
+                fsm->timer = BUTSW_TIMER_VLONG;
+                fsm->clicks = 0;
+                next_state = BUTSW_STATE_LONGPRESS;
+                break;
+            } else {
+                // not possible state
+                TRACE0 ("Button: not possible in 1click with button released");
+            }
+        case BUTSW_EVT_RELEASED:
+            fsm->hold = 0;
+            if (multiple_click) {
+                if (fsm->clicks < 255) {
+                    fsm->clicks ++;
+                }
+            } else {
+                fsm->clicks = 0;
+                fsm->cb = BUTSW_CB_END | BUTSW_CB_CLICK;
+                fsm->times = 1;
+            }
+            fsm->timer = BUTSW_TIMER_DBOUNCE;
+            next_state = BUTSW_STATE_DEBOUNCE2;
+            break;
+        case BUTSW_EVT_PRESSED:
+            fsm->hold = 1;
+            break;
+        default:
+            TRACE0 ("Button: Unhandled : %s", VAL2CSTR_BUTTSW_EVT(event));
+            break;
+        }
+        break;
+
+    case BUTSW_STATE_LONGPRESS:
+        switch (event) {
+        case BUTSW_EVT_TIMEOUT:
+            // check the current button status
+            if (fsm->hold) {
+                fsm->cb = BUTSW_CB_VLONG;
+                //next_state = BUTSW_STATE_VLONGPRESS;
+                fsm->timer = BUTSW_TIMER_DBOUNCE;
+                next_state = BUTSW_STATE_DEBOUNCE2;
+            } else {
+                TRACE0 ("Button: not possible in LONG with button released");
+            }
+            break;
+        case BUTSW_EVT_PRESSED:
+            fsm->hold = 1;
+            break;
+        case BUTSW_EVT_RELEASED:
+            fsm->hold = 0;
+            fsm->clicks = 0;
+            fsm->cb = BUTSW_CB_END | BUTSW_CB_LONG;
+            fsm->timer = BUTSW_TIMER_DBOUNCE;
+            next_state = BUTSW_STATE_DEBOUNCE2;
+            break;
+        default:
+            TRACE0 ("Button: Unhandled : %s", VAL2CSTR_BUTTSW_EVT(event));
+            break;
+        }
+        break;
+
+    case BUTSW_STATE_VLONGPRESS:
+        switch (event) {
+        case BUTSW_EVT_PRESSED:
+            fsm->hold = 1;
+            break;
+        case BUTSW_EVT_RELEASED:
+            fsm->hold = 0;
+            fsm->clicks = 0;
+            fsm->cb = BUTSW_CB_END;
+            fsm->timer = BUTSW_TIMER_DBOUNCE;
+            next_state = BUTSW_STATE_DEBOUNCE2;
+            break;
+        default:
+            TRACE0 ("Button: Unhandled : %s", VAL2CSTR_BUTTSW_EVT(event));
+            break;
+        }
+        break;
+
+    case BUTSW_STATE_DEBOUNCE2:
+        switch (event) {
+        case BUTSW_EVT_TIMEOUT:
+            fsm->hold = 0;
+            fsm->timer = BUTSW_TIMER_CANCEL;
+            if (multiple_click && fsm->clicks > 0) {
+                fsm->timer = BUTSW_TIMER_2CLICK;
+            }
+            next_state = BUTSW_STATE_READY;
+            break;
+        case BUTSW_EVT_PRESSED:
+        case BUTSW_EVT_RELEASED:
+            // ignore the bounces
+            break;
+        default:
+            TRACE0 ("Button: Unhandled : %s", VAL2CSTR_BUTTSW_EVT(event));
+            break;
+        }
+        break;
+    default:
+        TRACE0 ("Error: unknown state: %s", VAL2CSTR_BUTTSW_STATE(fsm->state));
+        break;
+    }
+    if (debounced) {
+        // the input is debounced by the caller, skip the debounce states
+        if (BUTSW_STATE_DEBOUNCE == next_state) {
+            fsm->timer = BUTSW_TIMER_LONG;
+            next_state = BUTSW_STATE_1CLICK;
+            fsm->cb |= BUTSW_CB_START;
+        } else if (BUTSW_STATE_DEBOUNCE2 == next_state) {
+            fsm->hold = 0;
+            fsm->timer = BUTSW_TIMER_CANCEL;
+            if (multiple_click && fsm->clicks > 0) {
+                fsm->timer = BUTSW_TIMER_2CLICK;
+            }
+            next_state = BUTSW_STATE_READY;
+        }
+    }
+    fsm->state = next_state;
+}
+
+// the results of the two state machines are the same
+static bool
+fsm_equal (const buttonfsm_t & a, const buttonfsm_t & b)
+{
+    if ((a.state != b.state) || (a.hold != b.hold) || (a.clicks != b.clicks)
+        || (a.timer != b.timer) || (a.cb != b.cb)) {
+        return false;
+    }
+    if ((a.cb & BUTSW_CB_CLICK) && (a.times != b.times)) {
+        return false;
+    }
+    return true;
+}
+
+// all of the states, the events and the inputs
+void
+check_table (void)
+{
+    static const uint8_t clicks[] = { 0, 1, 2, 3, 254, 255 };
+    unsigned int num = 0;
+    uint8_t state;
+    uint8_t hold;
+    uint8_t c;
+    uint8_t event;
+    uint8_t flags;
+    buttonfsm_t fsm1;
+    buttonfsm_t fsm2;
+
+    for (state = 0; state < BUTSW_NUM_STATES; state ++) {
+        for (hold = 0; hold < 2; hold ++) {
+            for (c = 0; c < sizeof(clicks); c ++) {
+                for (event = BUTSW_EVT_NONE; event <= BUTSW_EVT_TIMEOUT; event ++) {
+                    for (flags = 0; flags < 4; flags ++) {
+                        if ((flags & 2) && ((BUTSW_STATE_DEBOUNCE == state) || (BUTSW_STATE_DEBOUNCE2 == state))) {
+                            // the debounced steps never stay in the debounce states
+                            continue;
+                        }
+                        buttonfsm_init (&fsm1);
+                        fsm1.state = state;
+                        fsm1.hold = hold;
+                        fsm1.clicks = clicks[c];
+                        fsm2 = fsm1;
+                        buttonfsm_step (&fsm1, event, (flags & 1), (flags & 2));
+                        buttonfsm_step_switch (&fsm2, event, (flags & 1), (flags & 2));
+                        if (! fsm_equal (fsm1, fsm2)) {
+                            printf ("Error: state %d hold %d clicks %d event %d flags %d: table (%d %d %d %d %d) != hand-written (%d %d %d %d %d)\n"
+                                , state, hold, clicks[c], event, flags
+                                , fsm1.state, fsm1.hold, fsm1.clicks, fsm1.timer, fsm1.cb
+                                , fsm2.state, fsm2.hold, fsm2.clicks, fsm2.timer, fsm2.cb);
+                            assert (0);
+                        }
+                        num ++;
+                    }
+                }
+            }
+        }
+    }
+    printf ("the table is the same as the hand-written switch for %u (state, hold, clicks, event, flags)\n", num);
+}
+
+// the cost of a step along a random walk of the events
+void
+bench_table (void)
+{
+#define BENCH_STEPS 10000000
+    static const uint8_t events[] = { BUTSW_EVT_PRESSED, BUTSW_EVT_RELEASED, BUTSW_EVT_TIMEOUT };
+    static uint8_t seq[4096];
+    buttonfsm_t fsm1;
+    buttonfsm_t fsm2;
+    unsigned long k;
+    unsigned int sum = 0;
+    double t0, t1, t2;
+
+    for (k = 0; k < sizeof(seq); k ++) {
+        seq[k] = events[rand() % 3];
+    }
+    buttonfsm_init (&fsm1);
+    buttonfsm_init (&fsm2);
+    t0 = get_time_ns();
+    for (k = 0; k < BENCH_STEPS; k ++) {
+        buttonfsm_step_switch (&fsm2, seq[k & (sizeof(seq) - 1)], (k & 0x10000), false);
+        sum += fsm2.cb;
+    }
+    t1 = get_time_ns();
+    for (k = 0; k < BENCH_STEPS; k ++) {
+        buttonfsm_step (&fsm1, seq[k & (sizeof(seq) - 1)], (k & 0x10000), false);
+        sum -= fsm1.cb;
+    }
+    t2 = get_time_ns();
+    assert (fsm_equal (fsm1, fsm2));
+    printf ("step: hand-written switch %5.1f ns, table %5.1f ns (%u)\n"
+        , (t1 - t0) / BENCH_STEPS, (t2 - t1) / BENCH_STEPS, sum);
+}
+#endif
+
+void
+setup(void)
+{
+#if DEBUG && defined(ARDUINO)
+    Serial.begin(9600);
+    // Wait for USB Serial.
+    while (!Serial) {}
+
+    // Read any input
+    delay(200);
+    while (Serial.read() >= 0) {}
+#endif
+
+#if ! defined(ARDUINO)
+    check_table ();
+    bench_table ();
+    exit (0);
+#endif
+}
+
+void
+loop(void)
+{
+}
+
+#if ! defined(ARDUINO)
+int
+main(void)
+{
+    setup();
+    while (1) {
+        loop();
+    }
+    return 0;
+}
+#endif
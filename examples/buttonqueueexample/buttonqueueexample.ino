@@ -0,0 +1,203 @@
+/**
+ * @file    buttonqueueexample.ino
+ * @brief   Example of the ButtonEventQueue: the events of the buttons are drained by the loop() in batches
+ * @author  Yunhui Fu (yhfudev@gmail.com)
+ * @version 1.0
+ * @date    2016-07-14
+ * @copyright GPL
+ */
+#include "sysport.h"
+#include "button.h"
+#include "buttonevent.h"
+
+#ifndef TRACE
+#define TRACE(...)
+#endif
+
+// 0 -- verbose, 1 -- info, 2 -- warning, 3 -- error
+#define TRACE0 TRACE
+#define TRACE1 TRACE
+#define TRACE2 TRACE
+#define TRACE3 TRACE
+
+#if defined(ARDUINO)
+#define NUM_BUTTONS  4
+#define PORT_SWITCH  2
+#define PRESSED_STATE LOW
+#else
+#define NUM_BUTTONS  8
+// the pins read LOW on PC
+#define PORT_SWITCH 20
+#define PRESSED_STATE HIGH
+#endif
+
+// the max events processed in one loop()
+#define EVENTS_BATCH 4
+
+ButtonEventQueue g_events;
+Button butts[NUM_BUTTONS];
+
+// the handlers are called from the loop(), not from Button::update()
+void
+process_event (const buttonevent_t & ev)
+{
+    switch (ev.type) {
+    case BUTEV_CLICK:
+        TRACE1 ("INFO: button %d pressed %d times at %u", ev.id, ev.times, ev.time);
+        break;
+    case BUTEV_LONG:
+        TRACE1 ("INFO: button %d long pressed at %u", ev.id, ev.time);
+        break;
+    case BUTEV_VLONG:
+        TRACE1 ("INFO: button %d very long pressed at %u", ev.id, ev.time);
+        break;
+    }
+}
+
+#if ! defined(ARDUINO)
+#include "scriptpin.h"
+
+// the time of the simulation
+#define SIM_TIME 600000
+
+// the hash of the events: the id, the type, the times and the time
+static uint32_t g_hash_cb = 0;
+static uint32_t g_hash_queue = 0;
+static unsigned long g_now = 0;
+
+struct ButtonIndex {
+    uint8_t idx;
+    void on_click (unsigned int times) { HASH_EVENT(g_hash_cb, (this->idx << 3) | BUTEV_CLICK, times, g_now); }
+    void on_start (void) { HASH_EVENT(g_hash_cb, (this->idx << 3) | BUTEV_START, 0, g_now); }
+    void on_end (void) { HASH_EVENT(g_hash_cb, (this->idx << 3) | BUTEV_END, 0, g_now); }
+    void on_long (void) { HASH_EVENT(g_hash_cb, (this->idx << 3) | BUTEV_LONG, 0, g_now); }
+    void on_vlong (void) { HASH_EVENT(g_hash_cb, (this->idx << 3) | BUTEV_VLONG, 0, g_now); }
+};
+
+// the same script to the Buttons with the callbacks and the Buttons with the queue
+// drained every drain_ms, the events should be the same if the queue is not full
+// return the events popped from the queue
+unsigned long
+check_queue (unsigned long drain_ms)
+{
+    ScriptButton<true> butts_cb[NUM_BUTTONS];
+    ScriptButton<true> butts_queue[NUM_BUTTONS];
+    ButtonIndex idx[NUM_BUTTONS];
+    ScriptPin script[NUM_BUTTONS];
+    ButtonEventQueue queue;
+    buttonevent_t evs[EVENTS_BATCH];
+    unsigned long popped = 0;
+    unsigned int i;
+    unsigned int n;
+
+    for (i = 0; i < NUM_BUTTONS; i ++) {
+        idx[i].idx = i;
+        butts_cb[i].set_pin (PORT_SWITCH + i, HIGH);
+        butts_cb[i].on_click (Delegate<void(unsigned int)>::from_method<ButtonIndex, &ButtonIndex::on_click>(&(idx[i])));
+        butts_cb[i].on_start (Delegate<void()>::from_method<ButtonIndex, &ButtonIndex::on_start>(&(idx[i])));
+        butts_cb[i].on_end (Delegate<void()>::from_method<ButtonIndex, &ButtonIndex::on_end>(&(idx[i])));
+        butts_cb[i].on_long_press (Delegate<void()>::from_method<ButtonIndex, &ButtonIndex::on_long>(&(idx[i])));
+        butts_cb[i].on_vlong_press (Delegate<void()>::from_method<ButtonIndex, &ButtonIndex::on_vlong>(&(idx[i])));
+        butts_queue[i].set_pin (PORT_SWITCH + i, HIGH);
+        // the callbacks are not called
+        butts_queue[i].on_click (Delegate<void(unsigned int)>::from_method<ButtonIndex, &ButtonIndex::on_click>(&(idx[i])));
+        butts_queue[i].set_queue (&queue, i);
+    }
+    g_hash_cb = g_hash_queue = 0;
+
+    for (i = 0; i < NUM_BUTTONS; i ++) {
+        script[i].begin (i + 1);
+    }
+    for (g_now = 0; g_now < SIM_TIME; g_now ++) {
+        for (i = 0; i < NUM_BUTTONS; i ++) {
+            butts_cb[i].feed (script[i].get (g_now), g_now);
+        }
+    }
+    for (i = 0; i < NUM_BUTTONS; i ++) {
+        script[i].begin (i + 1);
+    }
+    for (g_now = 0; g_now < SIM_TIME; g_now ++) {
+        for (i = 0; i < NUM_BUTTONS; i ++) {
+            butts_queue[i].feed (script[i].get (g_now), g_now);
+        }
+        if ((g_now % drain_ms) == 0) {
+            // the handlers run later, in batches
+            while ((n = queue.pop (evs, EVENTS_BATCH)) > 0) {
+                popped += n;
+                for (i = 0; i < n; i ++) {
+                    HASH_EVENT(g_hash_queue, (evs[i].id << 3) | evs[i].type, evs[i].times, evs[i].time);
+                }
+            }
+        }
+    }
+    assert (0 != g_hash_cb);
+    if (queue.get_overflow() < 1) {
+        assert (g_hash_cb == g_hash_queue);
+    }
+    printf ("%d buttons, %u ms scripted, drained every %lu ms: %lu events, %u dropped%s\n"
+        , NUM_BUTTONS, SIM_TIME, drain_ms, popped, queue.get_overflow()
+        , (queue.get_overflow() < 1) ? ", same as the callbacks" : "");
+    return popped;
+}
+#endif
+
+void
+setup(void)
+{
+    unsigned int i;
+#if DEBUG && defined(ARDUINO)
+    Serial.begin(9600);
+    // Wait for USB Serial.
+    while (!Serial) {}
+
+    // Read any input
+    delay(200);
+    while (Serial.read() >= 0) {}
+#endif
+
+    for (i = 0; i < NUM_BUTTONS; i ++) {
+        pinMode (PORT_SWITCH + i, INPUT_PULLUP);
+        butts[i].set_pin (PORT_SWITCH + i, PRESSED_STATE);
+        butts[i].set_queue (&g_events, i);
+    }
+
+#if ! defined(ARDUINO)
+    printf ("sizeof(buttonevent_t) = %d\n", (int)sizeof(buttonevent_t));
+    check_queue (1);
+    check_queue (100);
+    check_queue (60000);
+    exit (0);
+#endif
+}
+
+void
+loop(void)
+{
+    buttonevent_t evs[EVENTS_BATCH];
+    unsigned int i;
+    unsigned int n;
+    for (i = 0; i < NUM_BUTTONS; i ++) {
+        butts[i].update();
+    }
+    // a few events in each loop, the others wait in the queue
+    n = g_events.pop (evs, EVENTS_BATCH);
+    for (i = 0; i < n; i ++) {
+        process_event (evs[i]);
+    }
+    if (g_events.get_overflow() > 0) {
+        TRACE2 ("WARNING: %u button events dropped", g_events.get_overflow());
+        g_events.clear_overflow();
+    }
+}
+
+#if ! defined(ARDUINO)
+int
+main(void)
+{
+    setup();
+    while (1) {
+        loop();
+    }
+    return 0;
+}
+#endif
@@ -0,0 +1,86 @@
+/**
+ * @file    scriptpin.h
+ * @brief   The scripted button presses and the event hash shared by the checks of the examples on PC
+ * @author  Yunhui Fu (yhfudev@gmail.com)
+ * @version 1.0
+ * @date    2016-07-14
+ * @copyright GPL
+ */
+/**
+ * Usage:
+ *   The examples feed the same pseudo random presses to the Button and to the class checked,
+ *   then compare the hashes of the events of both:
+ *     ScriptPin script;
+ *     ScriptButton<false> butt;
+ *     script.begin (1234);
+ *     for (now = 0; now < SIM_TIME; now ++) {
+ *         butt.feed (script.get (now), now);
+ *     }
+ *   HASH_EVENT(h, type, times, now) folds one event into the hash h.
+ *   get_time_ns() is the monotonic clock for the benchmarks.
+ *   Only for PC, the examples include it in #if ! defined(ARDUINO).
+ */
+
+#ifndef _EXAMPLES_SCRIPT_PIN_H
+#define _EXAMPLES_SCRIPT_PIN_H 1
+
+#include <time.h>
+#include "sysport.h"
+#include "button.h"
+
+// fold one event into the hash, the time is cut to 16 bits, the size of the time of ButtonEvent
+#define HASH_EVENT(h, type, times, now) ((h) = ((h) * 31 + (type)) * 31 + (times) * 65599 + (uint16_t)(now))
+
+static inline double
+get_time_ns (void)
+{
+    struct timespec ts;
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// the script of the presses: clicks, double clicks, long and very long presses, with bounces
+class ScriptPin {
+public:
+    ScriptPin () : seed(0), next(0), level(0), bounces(0) {}
+    void begin (uint32_t seed1) { this->seed = seed1; this->next = 0; this->level = 0; this->bounces = 0; }
+    uint8_t get (unsigned long t) {
+        while (t >= this->next) {
+            this->advance ();
+        }
+        return this->level;
+    }
+private:
+    uint32_t seed;
+    unsigned long next; // the time of the next change
+    uint8_t level;
+    uint8_t bounces;
+    uint32_t rand (void) { this->seed = this->seed * 1103515245 + 12345; return (this->seed >> 8); }
+    void advance (void) {
+        this->level = ! this->level;
+        if (this->bounces > 0) {
+            this->bounces --;
+            this->next += 1 + this->rand() % 5;
+            return;
+        }
+        this->bounces = (this->rand() % 3) * 2;
+        if (this->level) {
+            static const unsigned int press_ms[] = { 80, 150, 1500, 5000 };
+            this->next += press_ms[this->rand() % 4] + this->rand() % 50;
+        } else {
+            // the gap between the clicks, the short ones are double clicks
+            static const unsigned int gap_ms[] = { 100, 180, 600, 2000 };
+            this->next += gap_ms[this->rand() % 4] + this->rand() % 50;
+        }
+    }
+};
+
+// the Button fed with the levels of the script
+template <bool MULTI>
+class ScriptButton : public Button {
+public:
+    ScriptButton () : Button(MULTI) {}
+    inline bool feed (uint8_t level, unsigned long now) { return this->update_state (level, tick_from (now)); }
+};
+
+#endif // _EXAMPLES_SCRIPT_PIN_H
@@ -0,0 +1,185 @@
+/**
+ * @file    compactbuttonexample.ino
+ * @brief   Example of the CompactButton: many buttons with one dispatcher, compared with the Button
+ * @author  Yunhui Fu (yhfudev@gmail.com)
+ * @version 1.0
+ * @date    2016-07-14
+ * @copyright GPL
+ */
+#include "sysport.h"
+#include "button.h"
+#include "compactbutton.h"
+
+#ifndef TRACE
+#define TRACE(...)
+#endif
+
+// 0 -- verbose, 1 -- info, 2 -- warning, 3 -- error
+#define TRACE0 TRACE
+#define TRACE1 TRACE
+#define TRACE2 TRACE
+#define TRACE3 TRACE
+
+#if defined(ARDUINO)
+#define NUM_BUTTONS  4
+#define PORT_SWITCH  0
+#define PRESSED_STATE LOW
+#else
+#define NUM_BUTTONS 16
+// the pins read LOW on PC
+#define PORT_SWITCH 20
+#define PRESSED_STATE HIGH
+#endif
+
+CompactButton butts[NUM_BUTTONS];
+
+void
+butt_on_event(uint8_t id, uint8_t type, unsigned int times)
+{
+    switch (type) {
+    case BUTEV_CLICK:
+        TRACE1 ("INFO: button %d pressed %d times", id, times);
+        break;
+    case BUTEV_LONG:
+        TRACE1 ("INFO: button %d long pressed", id);
+        break;
+    }
+}
+
+#if ! defined(ARDUINO)
+#include "scriptpin.h"
+
+// the time of the simulation
+#define SIM_TIME 600000
+
+// the hash of the events of each button: the type, the times and the time
+static uint32_t g_hash_butt[NUM_BUTTONS];
+static uint32_t g_hash_compact[NUM_BUTTONS];
+static unsigned long g_now = 0;
+
+struct ButtonIndex {
+    uint8_t idx;
+    void on_click (unsigned int times) { HASH_EVENT(g_hash_butt[this->idx], BUTEV_CLICK, times, g_now); }
+    void on_start (void) { HASH_EVENT(g_hash_butt[this->idx], BUTEV_START, 0, g_now); }
+    void on_end (void) { HASH_EVENT(g_hash_butt[this->idx], BUTEV_END, 0, g_now); }
+    void on_long (void) { HASH_EVENT(g_hash_butt[this->idx], BUTEV_LONG, 0, g_now); }
+    void on_vlong (void) { HASH_EVENT(g_hash_butt[this->idx], BUTEV_VLONG, 0, g_now); }
+};
+
+void
+compact_hash_event (uint8_t id, uint8_t type, unsigned int times)
+{
+    HASH_EVENT(g_hash_compact[id], type, times, g_now);
+}
+
+// the same script to the Buttons and the CompactButtons, the events should be the same
+template <bool MULTI>
+void
+check_compact (void)
+{
+    ScriptButton<MULTI> sbutts[NUM_BUTTONS];
+    CompactButton cbutts[NUM_BUTTONS];
+    ButtonIndex idx[NUM_BUTTONS];
+    ScriptPin script[NUM_BUTTONS];
+    unsigned int i;
+    double t0, t1, t2;
+
+    for (i = 0; i < NUM_BUTTONS; i ++) {
+        idx[i].idx = i;
+        sbutts[i].set_pin (PORT_SWITCH + i, HIGH);
+        sbutts[i].on_click (Delegate<void(unsigned int)>::from_method<ButtonIndex, &ButtonIndex::on_click>(&(idx[i])));
+        sbutts[i].on_start (Delegate<void()>::from_method<ButtonIndex, &ButtonIndex::on_start>(&(idx[i])));
+        sbutts[i].on_end (Delegate<void()>::from_method<ButtonIndex, &ButtonIndex::on_end>(&(idx[i])));
+        sbutts[i].on_long_press (Delegate<void()>::from_method<ButtonIndex, &ButtonIndex::on_long>(&(idx[i])));
+        sbutts[i].on_vlong_press (Delegate<void()>::from_method<ButtonIndex, &ButtonIndex::on_vlong>(&(idx[i])));
+        cbutts[i].set_pin (PORT_SWITCH + i, HIGH);
+        cbutts[i].set_id (i);
+        cbutts[i].set_multiple_click (MULTI);
+        g_hash_butt[i] = g_hash_compact[i] = 0;
+    }
+    CompactButton::set_dispatcher (Delegate<void(uint8_t, uint8_t, unsigned int)>::from_function<compact_hash_event>());
+
+    for (i = 0; i < NUM_BUTTONS; i ++) {
+        script[i].begin (i + 1);
+    }
+    t0 = get_time_ns();
+    for (g_now = 0; g_now < SIM_TIME; g_now ++) {
+        for (i = 0; i < NUM_BUTTONS; i ++) {
+            sbutts[i].feed (script[i].get (g_now), g_now);
+        }
+    }
+    t1 = get_time_ns();
+    for (i = 0; i < NUM_BUTTONS; i ++) {
+        script[i].begin (i + 1);
+    }
+    for (g_now = 0; g_now < SIM_TIME; g_now ++) {
+        for (i = 0; i < NUM_BUTTONS; i ++) {
+            cbutts[i].update_pin (script[i].get (g_now), g_now);
+        }
+    }
+    t2 = get_time_ns();
+    for (i = 0; i < NUM_BUTTONS; i ++) {
+        assert (0 != g_hash_butt[i]);
+        assert (g_hash_butt[i] == g_hash_compact[i]);
+    }
+    printf ("%u buttons, %u ms scripted, multiple click %d: %d Button %6.1f ns/loop, CompactButton %6.1f ns/loop, same events\n"
+        , NUM_BUTTONS, SIM_TIME, MULTI, NUM_BUTTONS
+        , (t1 - t0) / SIM_TIME, (t2 - t1) / SIM_TIME);
+}
+#endif
+
+void
+setup(void)
+{
+    unsigned int i;
+#if DEBUG && defined(ARDUINO)
+    Serial.begin(9600);
+    // Wait for USB Serial.
+    while (!Serial) {}
+
+    // Read any input
+    delay(200);
+    while (Serial.read() >= 0) {}
+#endif
+
+    TRACE1 ("sizeof: Button %d, CompactButton %d", (int)sizeof(Button), (int)sizeof(CompactButton));
+#if ! defined(ARDUINO)
+    printf ("sizeof: Button %d, CompactButton %d\n", (int)sizeof(Button), (int)sizeof(CompactButton));
+    check_compact<false> ();
+    check_compact<true> ();
+#endif
+
+    for (i = 0; i < NUM_BUTTONS; i ++) {
+        pinMode (PORT_SWITCH + i, INPUT_PULLUP);
+        butts[i].set_pin (PORT_SWITCH + i, PRESSED_STATE);
+        butts[i].set_id (i);
+    }
+    butts[0].set_multiple_click (true);
+    CompactButton::set_dispatcher (Delegate<void(uint8_t, uint8_t, unsigned int)>::from_function<butt_on_event>());
+
+#if ! defined(ARDUINO)
+    exit (0);
+#endif
+}
+
+void
+loop(void)
+{
+    unsigned int i;
+    unsigned long now = millis();
+    for (i = 0; i < NUM_BUTTONS; i ++) {
+        butts[i].update (now);
+    }
+}
+
+#if ! defined(ARDUINO)
+int
+main(void)
+{
+    setup();
+    while (1) {
+        loop();
+    }
+    return 0;
+}
+#endif
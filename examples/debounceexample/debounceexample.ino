@@ -0,0 +1,265 @@
+/**
+ * @file    debounceexample.ino
+ * @brief   Example of the Debouncer: the vertical counters for many inputs, and the ButtonBank without the debounce timers
+ * @author  Yunhui Fu (yhfudev@gmail.com)
+ * @version 1.0
+ * @date    2016-07-14
+ * @copyright GPL
+ */
+#include "sysport.h"
+#include "debounce.h"
+#include "buttonbank.h"
+
+#ifndef TRACE
+#define TRACE(...)
+#endif
+
+// 0 -- verbose, 1 -- info, 2 -- warning, 3 -- error
+#define TRACE0 TRACE
+#define TRACE1 TRACE
+#define TRACE2 TRACE
+#define TRACE3 TRACE
+
+// sample the inputs every 5 ms, 4 samples (2 bits counters) to be stable
+#define SAMPLE_MS 5
+
+#if defined(ARDUINO)
+#define NUM_BUTTONS  4
+#define PORT_SWITCH  2
+#else
+#define NUM_BUTTONS 32
+// the pins read LOW on PC
+#define PORT_SWITCH 20
+#endif
+
+ButtonBank<NUM_BUTTONS> bank;
+
+void
+bank_on_click(uint8_t idx, unsigned int times)
+{
+    TRACE1 ("INFO: button %d pressed %d times", idx, times);
+}
+
+#if ! defined(ARDUINO)
+#include "scriptpin.h"
+
+static uint32_t g_seed = 1;
+static uint32_t
+rand32 (void)
+{
+    g_seed = g_seed * 1103515245 + 12345;
+    return (g_seed >> 16) | (g_seed << 16);
+}
+
+// the noisy inputs: each input flips in 1/8 of the samples
+static uint64_t
+noisy_sample (uint64_t prev)
+{
+    uint64_t flip = ((uint64_t)rand32() << 32) | rand32();
+    flip &= ((uint64_t)rand32() << 32) | rand32();
+    flip &= ((uint64_t)rand32() << 32) | rand32();
+    return prev ^ flip;
+}
+
+// the Debouncer is the same as 64 counters, one for each input
+template <uint8_t BITS>
+void
+check_debouncer (void)
+{
+#define CHECK_SAMPLES 100000
+    Debouncer<uint64_t, BITS> db;
+    uint8_t cnt[64];
+    uint64_t state = 0;
+    uint64_t sample = 0;
+    uint64_t changed;
+    unsigned long k;
+    unsigned int i;
+    unsigned long edges = 0;
+
+    memset (cnt, 0, sizeof(cnt));
+    for (k = 0; k < CHECK_SAMPLES; k ++) {
+        sample = noisy_sample (sample);
+        changed = 0;
+        for (i = 0; i < 64; i ++) {
+            if (((sample ^ state) >> i) & 1) {
+                cnt[i] ++;
+                if (cnt[i] >= (1 << BITS)) {
+                    changed |= ((uint64_t)1) << i;
+                    cnt[i] = 0;
+                }
+            } else {
+                cnt[i] = 0;
+            }
+        }
+        state ^= changed;
+        assert (changed == db.update (sample));
+        assert (state == db.get_state ());
+        assert ((changed & state) == db.get_pressed ());
+        assert ((changed & ~state) == db.get_released ());
+        for (; changed; changed &= changed - 1) {
+            edges ++;
+        }
+    }
+    assert (edges > 0);
+    printf ("Debouncer<uint64_t, %d>: %d samples x 64 inputs, %lu edges, same as the counters\n"
+        , BITS, CHECK_SAMPLES, edges);
+}
+
+// the cost of one sample of 64 inputs
+void
+bench_debouncer (void)
+{
+#define BENCH_SAMPLES 1000000
+    static uint64_t samples[1024];
+    Debouncer<uint64_t, 2> db;
+    uint8_t cnt[64];
+    uint64_t state = 0;
+    uint64_t sum = 0;
+    unsigned long k;
+    unsigned int i;
+    double t0, t1, t2;
+
+    for (i = 0; i < 1024; i ++) {
+        samples[i] = noisy_sample ((i > 0) ? samples[i - 1] : 0);
+    }
+    memset (cnt, 0, sizeof(cnt));
+    t0 = get_time_ns();
+    for (k = 0; k < BENCH_SAMPLES; k ++) {
+        uint64_t sample = samples[k & 1023];
+        for (i = 0; i < 64; i ++) {
+            if (((sample ^ state) >> i) & 1) {
+                if (++ cnt[i] >= 4) {
+                    state ^= ((uint64_t)1) << i;
+                    cnt[i] = 0;
+                }
+            } else {
+                cnt[i] = 0;
+            }
+        }
+        sum += state;
+    }
+    t1 = get_time_ns();
+    for (k = 0; k < BENCH_SAMPLES; k ++) {
+        sum -= db.update (samples[k & 1023]) ^ db.get_state();
+    }
+    t2 = get_time_ns();
+    printf ("64 inputs: 64 counters %6.1f ns/sample, Debouncer %6.1f ns/sample (%d)\n"
+        , (t1 - t0) / BENCH_SAMPLES, (t2 - t1) / BENCH_SAMPLES, (int)(sum & 1));
+}
+
+// the time of the simulation
+#define SIM_TIME 60000
+
+// the events of each button without the time: the debounce delays are different
+static uint32_t g_hash_timer[NUM_BUTTONS];
+static uint32_t g_hash_vcnt[NUM_BUTTONS];
+
+void timer_hash_click (uint8_t idx, unsigned int times) { HASH_EVENT(g_hash_timer[idx], 1, times, 0); }
+void timer_hash_long (uint8_t idx) { HASH_EVENT(g_hash_timer[idx], 2, 0, 0); }
+void timer_hash_vlong (uint8_t idx) { HASH_EVENT(g_hash_timer[idx], 3, 0, 0); }
+void vcnt_hash_click (uint8_t idx, unsigned int times) { HASH_EVENT(g_hash_vcnt[idx], 1, times, 0); }
+void vcnt_hash_long (uint8_t idx) { HASH_EVENT(g_hash_vcnt[idx], 2, 0, 0); }
+void vcnt_hash_vlong (uint8_t idx) { HASH_EVENT(g_hash_vcnt[idx], 3, 0, 0); }
+
+// the ButtonBank debounced by the timers and by the Debouncer report the same clicks
+template <bool MULTI>
+void
+check_bank (void)
+{
+    typedef typename ButtonBank<NUM_BUTTONS>::mask_t mask_t;
+    static ScriptPin script[NUM_BUTTONS];
+    ButtonBank<NUM_BUTTONS> bank_timer;
+    ButtonBank<NUM_BUTTONS> bank_vcnt;
+    Debouncer<mask_t> db;
+    mask_t pressed;
+    unsigned long now;
+    unsigned int i;
+
+    for (i = 0; i < NUM_BUTTONS; i ++) {
+        bank_timer.set_pin (i, PORT_SWITCH + i, HIGH);
+        bank_timer.set_multiple_click (i, MULTI);
+        bank_vcnt.set_pin (i, PORT_SWITCH + i, HIGH);
+        bank_vcnt.set_multiple_click (i, MULTI);
+        script[i].begin (i + 1);
+        g_hash_timer[i] = g_hash_vcnt[i] = 0;
+    }
+    bank_vcnt.set_debounce_sample (SAMPLE_MS);
+    bank_timer.on_click (Delegate<void(uint8_t, unsigned int)>::from_function<timer_hash_click>());
+    bank_timer.on_long_press (Delegate<void(uint8_t)>::from_function<timer_hash_long>());
+    bank_timer.on_vlong_press (Delegate<void(uint8_t)>::from_function<timer_hash_vlong>());
+    bank_vcnt.on_click (Delegate<void(uint8_t, unsigned int)>::from_function<vcnt_hash_click>());
+    bank_vcnt.on_long_press (Delegate<void(uint8_t)>::from_function<vcnt_hash_long>());
+    bank_vcnt.on_vlong_press (Delegate<void(uint8_t)>::from_function<vcnt_hash_vlong>());
+
+    // all of the buttons are released in the last second, for the events delayed by the debounce
+    for (now = 0; now < SIM_TIME + 1000; now ++) {
+        pressed = 0;
+        for (i = 0; (now < SIM_TIME) && (i < NUM_BUTTONS); i ++) {
+            if (script[i].get (now)) {
+                pressed |= ((mask_t)1) << i;
+            }
+        }
+        bank_timer.update_bits (pressed, now);
+        if (0 == (now % SAMPLE_MS)) {
+            db.update (pressed);
+        }
+        bank_vcnt.update_bits (db.get_state(), now);
+    }
+    for (i = 0; i < NUM_BUTTONS; i ++) {
+        assert (0 != g_hash_timer[i]);
+        assert (g_hash_timer[i] == g_hash_vcnt[i]);
+    }
+    printf ("%d buttons, %d ms scripted, multiple click %d: the same clicks by the timers and by the Debouncer\n"
+        , NUM_BUTTONS, SIM_TIME, MULTI);
+}
+#endif
+
+void
+setup(void)
+{
+    unsigned int i;
+#if DEBUG && defined(ARDUINO)
+    Serial.begin(9600);
+    // Wait for USB Serial.
+    while (!Serial) {}
+
+    // Read any input
+    delay(200);
+    while (Serial.read() >= 0) {}
+#endif
+
+    for (i = 0; i < NUM_BUTTONS; i ++) {
+        pinMode (PORT_SWITCH + i, INPUT_PULLUP);
+        bank.set_pin (i, PORT_SWITCH + i, LOW);
+    }
+    bank.set_debounce_sample (SAMPLE_MS);
+    bank.on_click (Delegate<void(uint8_t, unsigned int)>::from_function<bank_on_click>());
+
+#if ! defined(ARDUINO)
+    check_debouncer<2> ();
+    check_debouncer<3> ();
+    check_debouncer<4> ();
+    bench_debouncer ();
+    check_bank<false> ();
+    check_bank<true> ();
+    exit (0);
+#endif
+}
+
+void
+loop(void)
+{
+    bank.update();
+}
+
+#if ! defined(ARDUINO)
+int
+main(void)
+{
+    setup();
+    while (1) {
+        loop();
+    }
+    return 0;
+}
+#endif
@@ -0,0 +1,228 @@
+/**
+ * @file    encoderexample.ino
+ * @brief   Example of the Encoder: a rotary encoder with the push switch
+ * @author  Yunhui Fu (yhfudev@gmail.com)
+ * @version 1.0
+ * @date    2016-07-14
+ * @copyright GPL
+ */
+#include "sysport.h"
+#include "encoder.h"
+#include "button.h"
+
+#ifndef TRACE
+#define TRACE(...)
+#endif
+
+// 0 -- verbose, 1 -- info, 2 -- warning, 3 -- error
+#define TRACE0 TRACE
+#define TRACE1 TRACE
+#define TRACE2 TRACE
+#define TRACE3 TRACE
+
+#define PORT_ENC_A 2
+#define PORT_ENC_B 3
+#define PORT_ENC_SW 12
+
+Encoder enc;
+Button enc_sw(false);
+
+void
+enc_on_change(void)
+{
+    enc.isr_update();
+}
+
+void
+enc_on_rotate(int detents)
+{
+    TRACE1 ("INFO: encoder turned %d, position %ld", detents, enc.get_position());
+}
+
+void
+enc_on_push(unsigned int times)
+{
+    TRACE1 ("INFO: encoder pushed %d times", times);
+    enc.set_position (0);
+}
+
+#if ! defined(ARDUINO)
+// the levels of the gray code position, A: bit 1, B: bit 0
+static const uint8_t gray_levels[4] = { 0x00, 0x02, 0x03, 0x01 };
+
+// the step between two gray code positions, 0 for the jump of 2 (error)
+static int
+gray_step (uint8_t from, uint8_t to)
+{
+    switch ((to + 4 - from) % 4) {
+    case 1: return 1;
+    case 3: return -1;
+    }
+    return 0;
+}
+
+// the table gives the difference of the gray code positions, and the errors for the jumps of 2
+void
+check_table (void)
+{
+    uint8_t from, to;
+    for (from = 0; from < 4; from ++) {
+        for (to = 0; to < 4; to ++) {
+            Encoder e;
+            // one step per detent, the pins read LOW on PC
+            e.set_pins (20, 21, 1);
+            e.set_interrupt (true);
+            e.isr_levels (gray_levels[from]);
+            e.isr_levels (gray_levels[to]);
+            e.update (0);
+            assert (e.get_position() == gray_step (0, from) + gray_step (from, to));
+            assert (e.get_errors() == (2 == from) + (2 == (to + 4 - from) % 4));
+        }
+    }
+    printf ("table: the 16 transitions are the steps of the gray code, the jumps of 2 are the errors\n");
+}
+
+static int g_rotated;
+void sim_on_rotate (int detents) { g_rotated += detents; }
+
+// turn the knob detents with the steps us_per_step apart, one encoder gets every edge as the ISR,
+// the other one is polled every 1 ms
+void
+check_isr_vs_poll (int detents, unsigned long us_per_step)
+{
+    Encoder by_isr;
+    Encoder by_poll;
+    unsigned long t_us;
+    unsigned long end_us;
+    int pos = 0;
+    int dir = ((detents < 0) ? -1 : 1);
+    int steps = detents * ENCODER_STEPS_PER_DETENT;
+    unsigned long t_next_step = 0;
+
+    g_rotated = 0;
+    by_isr.on_rotate (Delegate<void(int)>::from_function<sim_on_rotate>());
+    end_us = (unsigned long)((steps < 0) ? -steps : steps) * us_per_step + 10000;
+    for (t_us = 0; t_us < end_us; t_us ++) {
+        if ((pos != steps) && (t_us >= t_next_step)) {
+            pos += dir;
+            t_next_step += us_per_step;
+            by_isr.isr_levels (gray_levels[pos & 0x03]);
+        }
+        if (0 == t_us % 1000) {
+            by_poll.isr_levels (gray_levels[pos & 0x03]);
+            by_isr.update (t_us / 1000);
+            by_poll.update (t_us / 1000);
+        }
+    }
+    assert (by_isr.get_position() == detents);
+    assert (0 == by_isr.get_errors());
+    assert (g_rotated == detents);
+    printf ("speed: %3d detents at %4lu us/step: by ISR %3ld, polled every 1 ms %3ld (%u errors)\n"
+        , detents, us_per_step, by_isr.get_position(), by_poll.get_position(), by_poll.get_errors());
+}
+
+// the position of the detents ms_per_detent apart with the acceleration
+static long
+turn_accel (int detents, unsigned long ms_per_detent)
+{
+    Encoder e;
+    unsigned long now = 1000;
+    int d;
+    uint8_t i;
+    int p = 0;
+    e.set_acceleration (50, 8);
+    for (d = 0; d < detents; d ++) {
+        for (i = 0; i < ENCODER_STEPS_PER_DETENT; i ++) {
+            p ++;
+            e.isr_levels (gray_levels[p & 0x03]);
+        }
+        now += ms_per_detent;
+        e.update (now);
+    }
+    return e.get_position();
+}
+
+void
+check_acceleration (void)
+{
+    long slow = turn_accel (20, 100);
+    long mid = turn_accel (20, 25);
+    long fast = turn_accel (20, 5);
+    assert (20 == slow);
+    assert ((mid > slow) && (fast > mid) && (fast <= 20 * 8));
+    printf ("acceleration: 20 detents at 100 ms: %ld, at 25 ms: %ld, at 5 ms: %ld\n", slow, mid, fast);
+
+    // the first detent after a pause as long as the wrap of the ticks is not accelerated
+    Encoder e;
+    unsigned long now;
+    uint8_t i;
+    int p = 0;
+    e.set_acceleration (50, 8);
+    for (now = 1; now <= 1000 + 65546; now ++) {
+        if ((1000 == now) || (1000 + 65546 == now)) {
+            for (i = 0; i < ENCODER_STEPS_PER_DETENT; i ++) {
+                p ++;
+                e.isr_levels (gray_levels[p & 0x03]);
+            }
+        }
+        e.update (now);
+    }
+    assert (2 == e.get_position());
+    printf ("acceleration: the detent after a pause of 65546 ms is 1\n");
+}
+#endif
+
+void
+setup(void)
+{
+#if DEBUG && defined(ARDUINO)
+    Serial.begin(9600);
+    // Wait for USB Serial.
+    while (!Serial) {}
+
+    // Read any input
+    delay(200);
+    while (Serial.read() >= 0) {}
+#endif
+
+    enc.set_pins (PORT_ENC_A, PORT_ENC_B);
+    enc.set_acceleration (50, 8);
+    enc.on_rotate (Delegate<void(int)>::from_function<enc_on_rotate>());
+#if defined(ARDUINO)
+    enc.set_interrupt (true);
+    attachInterrupt(digitalPinToInterrupt(PORT_ENC_A), enc_on_change, CHANGE);
+    attachInterrupt(digitalPinToInterrupt(PORT_ENC_B), enc_on_change, CHANGE);
+#endif
+    pinMode(PORT_ENC_SW, INPUT_PULLUP);
+    enc_sw.set_pin (PORT_ENC_SW);
+    enc_sw.on_click (Delegate<void(unsigned int)>::from_function<enc_on_push>());
+    enc.set_switch (&enc_sw);
+
+#if ! defined(ARDUINO)
+    check_table ();
+    check_isr_vs_poll (20, 2000);
+    check_isr_vs_poll (-20, 600);
+    check_isr_vs_poll (40, 300);
+    check_acceleration ();
+    exit (0);
+#endif
+}
+
+void
+loop(void)
+{
+    // the steps are counted by the ISR, the switch is updated with the encoder
+    enc.update();
+}
+
+#if ! defined(ARDUINO)
+int
+main(void)
+{
+    setup();
+    while (1) {
+        loop();
+    }
+    return 0;
+}
+#endif
@@ -0,0 +1,209 @@
+/**
+ * @file    gestureexample.ino
+ * @brief   Example of the GestureRecognizer: more commands by the sequences of the clicks and the holds of one button
+ * @author  Yunhui Fu (yhfudev@gmail.com)
+ * @version 1.0
+ * @date    2016-07-14
+ * @copyright GPL
+ */
+#include "sysport.h"
+#include "debounce.h"
+#include "gesture.h"
+
+#ifndef TRACE
+#define TRACE(...)
+#endif
+
+// 0 -- verbose, 1 -- info, 2 -- warning, 3 -- error
+#define TRACE0 TRACE
+#define TRACE1 TRACE
+#define TRACE2 TRACE
+#define TRACE3 TRACE
+
+#if defined(ARDUINO)
+#define PORT_SWITCH 2
+#define PRESSED_STATE LOW
+#else
+// the pin reads HIGH on PC
+#define PORT_SWITCH 3
+#define PRESSED_STATE HIGH
+#endif
+
+// the period of the samples of the Debouncer, debounce time = 4 x 5 ms
+#define SAMPLE_MS 5
+
+#define CMD_CLICK1           1
+#define CMD_CLICK2           2
+#define CMD_CLICK3           3
+#define CMD_CLICK_CLICK_HOLD 4
+#define CMD_HOLD             5
+#define CMD_CLICK_HOLD       6
+
+GestureRecognizer<12> gestures;
+Debouncer<uint8_t> db;
+unsigned long next_sample = 0;
+
+void
+add_gestures (GestureRecognizer<12> & g)
+{
+    g.add (".", CMD_CLICK1);
+    g.add ("..", CMD_CLICK2);
+    g.add ("...", CMD_CLICK3);
+    g.add ("..-", CMD_CLICK_CLICK_HOLD);
+    g.add ("-", CMD_HOLD);
+    g.add (".-", CMD_CLICK_HOLD);
+}
+
+void
+on_gesture (uint8_t id)
+{
+    TRACE1 ("INFO: gesture %d", id);
+}
+
+#if ! defined(ARDUINO)
+// the gestures and their times reported in the check
+static uint8_t g_ids[8];
+static unsigned long g_times[8];
+static uint8_t g_num = 0;
+static unsigned long g_now = 0;
+
+void
+record_gesture (uint8_t id)
+{
+    if (g_num < 8) {
+        g_ids[g_num] = id;
+        g_times[g_num] = g_now;
+        g_num ++;
+    }
+}
+
+// press the button by the script: the lengths(ms) of the press, the release, the press, ...
+// with bounces if bouncy, return the number of the reported gestures
+uint8_t
+run_script (const unsigned int * script, uint8_t num, bool bouncy)
+{
+    GestureRecognizer<12> g;
+    Debouncer<uint8_t> d;
+    unsigned long t_next = 0;
+    unsigned long t_end = 0;
+    uint8_t i = 0;
+    bool level = false;
+    bool raw;
+
+    add_gestures (g);
+    g.on_gesture (Delegate<void(uint8_t)>::from_function<record_gesture>());
+    g_num = 0;
+    for (i = 0; i < num; i ++) {
+        t_end += script[i];
+    }
+    t_end += 1000;
+    i = 0;
+    t_next = 100;
+    for (g_now = 0; g_now < t_end; g_now ++) {
+        if (g_now >= t_next) {
+            if (i < num) {
+                level = ! level;
+                t_next += script[i ++];
+            } else {
+                // released after the last press
+                level = false;
+            }
+        }
+        raw = level;
+        if (bouncy && (i > 0) && (g_now < t_next) && ((t_next - script[i - 1]) + 8 > g_now) && (g_now & 1)) {
+            // 8 ms of bounces after each edge
+            raw = ! level;
+        }
+        if (! bouncy) {
+            g.update (raw, g_now);
+        } else if (0 == (g_now % SAMPLE_MS)) {
+            d.update (raw ? 1 : 0);
+            g.update (d.get_state() & 0x01, g_now);
+        }
+    }
+    return g_num;
+}
+
+// the edges are delayed by the Debouncer, 2^2 samples and the sample period
+#define DEBOUNCE_DELAY (5 * SAMPLE_MS)
+
+// the gesture id should be reported at the time, or later by the debounce
+#define CHECK_GESTURE(script, bouncy, id, time) do { \
+    assert (1 == run_script (script, sizeof(script) / sizeof(script[0]), bouncy)); \
+    assert ((id) == g_ids[0]); \
+    assert (((time) <= g_times[0]) && (g_times[0] <= (time) + (bouncy ? DEBOUNCE_DELAY : 0))); \
+} while (0)
+
+void
+check_gestures (void)
+{
+    // the clicks, 80 ms pressed, 150 ms released
+    static const unsigned int click1[] = { 80 };
+    static const unsigned int click2[] = { 80, 150, 80 };
+    static const unsigned int click3[] = { 80, 150, 80, 150, 80 };
+    static const unsigned int click4[] = { 80, 150, 80, 150, 80, 150, 80 };
+    static const unsigned int click_click_hold[] = { 80, 150, 80, 150, 3000 };
+    static const unsigned int hold[] = { 3000 };
+    static const unsigned int click_hold[] = { 80, 150, 3000 };
+    uint8_t bouncy;
+
+    for (bouncy = 0; bouncy < 2; bouncy ++) {
+        // the prefix of the others: reported after the gap
+        CHECK_GESTURE (click1, bouncy, CMD_CLICK1, 100 + 80 + BUTSW_TIMEOUT_2CLICK);
+        CHECK_GESTURE (click2, bouncy, CMD_CLICK2, 100 + 310 + BUTSW_TIMEOUT_2CLICK);
+        // the longest ones: reported at once
+        CHECK_GESTURE (click3, bouncy, CMD_CLICK3, 100 + 540);
+        CHECK_GESTURE (click4, bouncy, CMD_CLICK3, 100 + 540);
+        CHECK_GESTURE (click_click_hold, bouncy, CMD_CLICK_CLICK_HOLD, 100 + 460 + BUTSW_TIMEOUT_LONG);
+        CHECK_GESTURE (hold, bouncy, CMD_HOLD, 100 + BUTSW_TIMEOUT_LONG);
+        CHECK_GESTURE (click_hold, bouncy, CMD_CLICK_HOLD, 100 + 230 + BUTSW_TIMEOUT_LONG);
+    }
+    printf ("gestures: the patterns are reported at the expected times, with and without the bounces\n");
+}
+#endif
+
+void
+setup(void)
+{
+#if DEBUG && defined(ARDUINO)
+    Serial.begin(9600);
+    // Wait for USB Serial.
+    while (!Serial) {}
+
+    // Read any input
+    delay(200);
+    while (Serial.read() >= 0) {}
+#endif
+
+#if ! defined(ARDUINO)
+    check_gestures ();
+    exit (0);
+#endif
+
+    pinMode (PORT_SWITCH, INPUT_PULLUP);
+    add_gestures (gestures);
+    gestures.on_gesture (Delegate<void(uint8_t)>::from_function<on_gesture>());
+}
+
+void
+loop(void)
+{
+    unsigned long now = millis();
+    if (tick_reached (tick_from (now), tick_from (next_sample))) {
+        next_sample = now + SAMPLE_MS;
+        db.update ((digitalRead (PORT_SWITCH) == PRESSED_STATE) ? 1 : 0);
+        gestures.update (db.get_state() & 0x01, now);
+    }
+}
+
+#if ! defined(ARDUINO)
+int
+main(void)
+{
+    setup();
+    while (1) {
+        loop();
+    }
+    return 0;
+}
+#endif
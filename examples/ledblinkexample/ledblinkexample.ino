@@ -1,6 +1,13 @@
 
 #include "sysport.h"
 #include "ledblink.h"
+#include "timerint.h"
+#include "scheduler.h"
+
+// 1 -- the timeouts are armed on TimerInt, 0 -- polled by millis() in update()
+#ifndef USE_TIMERINT
+#define USE_TIMERINT 1
+#endif
 
 #ifndef TRACE
 #define TRACE(...)
@@ -39,7 +46,7 @@ fading_up_down_update (LEDBlink *plf, int * p_direction)
     if (NULL == plf) {
         return;
     }
-    plf->update();
+    // the LED is updated by sched.run()
     if (! plf->is_blinking()) {
         if (NULL == p_direction) {
             return;
@@ -61,6 +68,10 @@ fading_up_down_update (LEDBlink *plf, int * p_direction)
 
 LEDBlink led_pwm;
 LEDBlink led_nopwm;
+#if USE_TIMERINT
+TimerInt timers;
+#endif
+Scheduler sched;
 
 void
 setup(void)
@@ -75,6 +86,14 @@ setup(void)
     while (Serial.read() >= 0) {}
 #endif
 
+#if USE_TIMERINT
+    timers.tick (millis());
+    led_pwm.set_timer (&timers);
+    led_nopwm.set_timer (&timers);
+    sched.add_task (&timers, true);
+#endif
+    led_pwm.set_scheduler (&sched);
+    led_nopwm.set_scheduler (&sched);
     pinMode(PORT_LED_PWM, OUTPUT);
     led_pwm.set_pin(PORT_LED_PWM);
     led_pwm.start_fade(FADE_TIME, LED_V_FADE1, LED_V_FADE2);
@@ -88,8 +107,11 @@ setup(void)
 void
 loop(void)
 {
+    // only the LEDs blinking or fading are updated
+    sched.run();
     fading_up_down_update(&led_pwm, &g_led_direction);
-    led_nopwm.update();
+    // sleep until the next step of the LEDs
+    sched.idle (500);
 }
 
 #if ! defined(ARDUINO)
@@ -99,7 +121,6 @@ main(void)
     setup();
     while (1) {
         loop();
-        delay(500);
     }
     return 0;
 }
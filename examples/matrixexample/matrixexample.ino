@@ -0,0 +1,273 @@
+/**
+ * @file    matrixexample.ino
+ * @brief   Example of the ButtonMatrix: a 4x4 keypad scanned one row per update()
+ * @author  Yunhui Fu (yhfudev@gmail.com)
+ * @version 1.0
+ * @date    2016-07-14
+ * @copyright GPL
+ */
+#include "sysport.h"
+#include "buttonmatrix.h"
+
+#ifndef TRACE
+#define TRACE(...)
+#endif
+
+// 0 -- verbose, 1 -- info, 2 -- warning, 3 -- error
+#define TRACE0 TRACE
+#define TRACE1 TRACE
+#define TRACE2 TRACE
+#define TRACE3 TRACE
+
+#define NUM_ROWS 4
+#define NUM_COLS 4
+#define KEY(r, c) ((r) * NUM_COLS + (c))
+
+static const uint8_t keypad_rows[NUM_ROWS] = { 2, 3, 4, 5 };
+static const uint8_t keypad_cols[NUM_COLS] = { 6, 7, 8, 9 };
+#if DEBUG
+static const char keypad_names[NUM_ROWS * NUM_COLS + 1] = "123A456B789C*0#D";
+#endif
+
+ButtonMatrix<NUM_ROWS, NUM_COLS> keypad;
+
+void
+keypad_on_click(uint8_t key, unsigned int times)
+{
+    TRACE1 ("INFO: key %c pressed %d times", keypad_names[key], times);
+}
+
+void
+keypad_on_longpress(uint8_t key)
+{
+    TRACE1 ("INFO: key %c long pressed", keypad_names[key]);
+}
+
+#if ! defined(ARDUINO)
+#include "scriptpin.h"
+
+static uint32_t g_seed = 1;
+static int
+noise (int amp)
+{
+    g_seed = g_seed * 1103515245 + 12345;
+    return (int)((g_seed >> 8) % (2 * amp + 1)) - amp;
+}
+
+// the columns read LOW when the row is driven, through all of the paths of the pressed keys
+// of the keypad without the diodes, so the ghost keys show up
+static uint8_t
+sim_read_row (const uint8_t * pressed, uint8_t row)
+{
+    uint8_t rows = (1 << row);
+    uint8_t cols = 0;
+    uint8_t last;
+    uint8_t r;
+    do {
+        last = rows;
+        for (r = 0; r < NUM_ROWS; r ++) {
+            if (rows & (1 << r)) {
+                cols |= pressed[r];
+            }
+        }
+        for (r = 0; r < NUM_ROWS; r ++) {
+            if (pressed[r] & cols) {
+                rows |= (1 << r);
+            }
+        }
+    } while (rows != last);
+    return cols;
+}
+
+// the hash of the events of each key
+static uint32_t g_hash_matrix[NUM_ROWS * NUM_COLS];
+static uint32_t g_hash_bank[NUM_ROWS * NUM_COLS];
+static uint16_t g_started;
+static unsigned long g_now = 0;
+
+void matrix_hash_click (uint8_t key, unsigned int times) { HASH_EVENT(g_hash_matrix[key], 1, times, g_now); }
+void matrix_hash_long (uint8_t key) { HASH_EVENT(g_hash_matrix[key], 4, 0, g_now); }
+void matrix_hash_start (uint8_t key) { HASH_EVENT(g_hash_matrix[key], 2, 0, g_now); g_started |= (1 << key); }
+void bank_hash_click (uint8_t key, unsigned int times) { HASH_EVENT(g_hash_bank[key], 1, times, g_now); }
+void bank_hash_long (uint8_t key) { HASH_EVENT(g_hash_bank[key], 4, 0, g_now); }
+void bank_hash_start (uint8_t key) { HASH_EVENT(g_hash_bank[key], 2, 0, g_now); }
+
+// the scripted presses of the random keys, the events should be the same as the ButtonBank
+// with one state machine for each key, fed with the keys scanned by the matrix
+void
+check_clicks (void)
+{
+#define SIM_TIME 600000
+    static const unsigned int press_ms[] = { 80, 150, 1500 };
+    ButtonMatrix<NUM_ROWS, NUM_COLS> matrix;
+    ButtonBank<NUM_ROWS * NUM_COLS> bank;
+    uint8_t pressed[NUM_ROWS];
+    unsigned long t_next = 0;
+    uint8_t key = NUM_ROWS * NUM_COLS;
+    uint8_t row = 0;
+    uint16_t scanned;
+    uint8_t i;
+    double t0, t1, t_matrix = 0;
+
+    matrix.on_click (Delegate<void(uint8_t, unsigned int)>::from_function<matrix_hash_click>());
+    matrix.on_long_press (Delegate<void(uint8_t)>::from_function<matrix_hash_long>());
+    matrix.on_start (Delegate<void(uint8_t)>::from_function<matrix_hash_start>());
+    bank.set_used (0xFFFF);
+    bank.on_click (Delegate<void(uint8_t, unsigned int)>::from_function<bank_hash_click>());
+    bank.on_long_press (Delegate<void(uint8_t)>::from_function<bank_hash_long>());
+    bank.on_start (Delegate<void(uint8_t)>::from_function<bank_hash_start>());
+    for (i = 0; i < NUM_ROWS * NUM_COLS; i ++) {
+        g_hash_matrix[i] = g_hash_bank[i] = 0;
+    }
+    for (i = 0; i < NUM_ROWS; i ++) {
+        pressed[i] = 0;
+    }
+    for (g_now = 0; g_now < SIM_TIME; g_now ++) {
+        if (g_now >= t_next) {
+            if (key < NUM_ROWS * NUM_COLS) {
+                // released
+                pressed[key / NUM_COLS] = 0;
+                key = NUM_ROWS * NUM_COLS;
+                t_next += 200 + noise (100) + 100;
+            } else {
+                key = (g_seed >> 8) % (NUM_ROWS * NUM_COLS);
+                pressed[key / NUM_COLS] = (1 << (key % NUM_COLS));
+                t_next += press_ms[(g_seed >> 16) % 3] + noise (20);
+            }
+        }
+        // one row per ms
+        t0 = get_time_ns();
+        matrix.update_row (row, sim_read_row (pressed, row), g_now);
+        t1 = get_time_ns();
+        t_matrix += t1 - t0;
+        row = (row + 1) % NUM_ROWS;
+        for (scanned = 0, i = 0; i < NUM_ROWS; i ++) {
+            scanned |= ((uint16_t)matrix.get_row (i) << (i * NUM_COLS));
+        }
+        bank.update_bits (scanned, g_now);
+    }
+    assert (0 == matrix.get_overflow());
+    for (i = 0; i < NUM_ROWS * NUM_COLS; i ++) {
+        assert (0 != g_hash_matrix[i]);
+        assert (g_hash_matrix[i] == g_hash_bank[i]);
+    }
+    printf ("clicks: %u ms of the random keys, the same events as the ButtonBank (%5.1f ns/row)\n"
+        , SIM_TIME, t_matrix / SIM_TIME);
+}
+
+// run the matrix for ms with the pressed keys
+static void
+run_matrix (ButtonMatrix<NUM_ROWS, NUM_COLS> & matrix, const uint8_t * pressed, unsigned long ms)
+{
+    unsigned long end = g_now + ms;
+    for (; g_now < end; g_now ++) {
+        matrix.update_row (g_now % NUM_ROWS, sim_read_row (pressed, g_now % NUM_ROWS), g_now);
+    }
+}
+
+// 3 corners of a rectangle pressed, the 4th corner (1,1) should never start
+void
+check_ghost (void)
+{
+    ButtonMatrix<NUM_ROWS, NUM_COLS> matrix;
+    uint8_t pressed[NUM_ROWS] = { 0, 0, 0, 0 };
+
+    matrix.on_start (Delegate<void(uint8_t)>::from_function<matrix_hash_start>());
+    g_started = 0;
+    g_now = 0;
+    pressed[0] = (1 << 0);
+    run_matrix (matrix, pressed, 100);
+    pressed[0] |= (1 << 1);
+    run_matrix (matrix, pressed, 100);
+    assert (g_started == ((1 << KEY(0, 0)) | (1 << KEY(0, 1))));
+    // (1,0) closes the rectangle
+    pressed[1] = (1 << 0);
+    run_matrix (matrix, pressed, 500);
+    assert (0 == (g_started & (1 << KEY(1, 1))));
+    assert (matrix.get_ghosts() > 0);
+    // (0,1) released, (1,0) is not ambiguous any more
+    pressed[0] = (1 << 0);
+    run_matrix (matrix, pressed, 100);
+    assert (g_started == ((1 << KEY(0, 0)) | (1 << KEY(0, 1)) | (1 << KEY(1, 0))));
+    pressed[0] = pressed[1] = 0;
+    run_matrix (matrix, pressed, 1000);
+    assert (0 == (g_started & (1 << KEY(1, 1))));
+    printf ("ghost: the 4th corner of the rectangle is never pressed, %u scans filtered\n", matrix.get_ghosts());
+}
+
+static uint16_t g_long_pressed;
+void matrix_set_long (uint8_t key) { g_long_pressed |= (1 << key); }
+
+// pressed again in DEBOUNCE2 and hold: the press ignored by the state machine is fed again
+// after the timeout, the long press and the release should be reported
+void
+check_repress (void)
+{
+    ButtonMatrix<NUM_ROWS, NUM_COLS> matrix;
+    uint8_t pressed[NUM_ROWS] = { 0, 0, 0, 0 };
+
+    matrix.on_long_press (Delegate<void(uint8_t)>::from_function<matrix_set_long>());
+    g_long_pressed = 0;
+    g_now = 0;
+    pressed[2] = (1 << 3);
+    run_matrix (matrix, pressed, 100);
+    pressed[2] = 0;
+    run_matrix (matrix, pressed, BUTSW_TIMEOUT_DBOUNCE / 2);
+    pressed[2] = (1 << 3);
+    run_matrix (matrix, pressed, BUTSW_TIMEOUT_DBOUNCE + BUTSW_TIMEOUT_LONG + 100);
+    pressed[2] = 0;
+    run_matrix (matrix, pressed, 1000);
+    // the long press is reported at the release, and the slot is given back
+    assert (g_long_pressed == (1 << KEY(2, 3)));
+    assert (false == matrix.update_row (0, 0, g_now));
+    printf ("repress: the key pressed again in DEBOUNCE2 is long pressed and released\n");
+}
+#endif
+
+void
+setup(void)
+{
+#if DEBUG && defined(ARDUINO)
+    Serial.begin(9600);
+    // Wait for USB Serial.
+    while (!Serial) {}
+
+    // Read any input
+    delay(200);
+    while (Serial.read() >= 0) {}
+#endif
+
+    keypad.set_pins (keypad_rows, keypad_cols);
+    keypad.set_multiple_click (true);
+    keypad.on_click (Delegate<void(uint8_t, unsigned int)>::from_function<keypad_on_click>());
+    keypad.on_long_press (Delegate<void(uint8_t)>::from_function<keypad_on_longpress>());
+
+#if ! defined(ARDUINO)
+    check_clicks ();
+    check_ghost ();
+    check_repress ();
+    printf ("size: ButtonMatrix<4,4> %u bytes, ButtonBank<16> %u bytes; ButtonMatrix<8,8> %u bytes, ButtonBank<64> %u bytes\n"
+        , (unsigned)sizeof(ButtonMatrix<4, 4>), (unsigned)sizeof(ButtonBank<16>)
+        , (unsigned)sizeof(ButtonMatrix<8, 8>), (unsigned)sizeof(ButtonBank<64>));
+    exit (0);
+#endif
+}
+
+void
+loop(void)
+{
+    // one row for each call
+    keypad.update();
+}
+
+#if ! defined(ARDUINO)
+int
+main(void)
+{
+    setup();
+    while (1) {
+        loop();
+    }
+    return 0;
+}
+#endif
@@ -0,0 +1,272 @@
+/**
+ * @file    pinedgeexample.ino
+ * @brief   Example of the Button driven by the time stamped edges from the pin change interrupt
+ * @author  Yunhui Fu (yhfudev@gmail.com)
+ * @version 1.0
+ * @date    2016-07-14
+ * @copyright GPL
+ */
+#include "sysport.h"
+#include "pinedge.h"
+#include "button.h"
+
+#ifndef TRACE
+#define TRACE(...)
+#endif
+
+// 0 -- verbose, 1 -- info, 2 -- warning, 3 -- error
+#define TRACE0 TRACE
+#define TRACE1 TRACE
+#define TRACE2 TRACE
+#define TRACE3 TRACE
+
+#define PORT_SWITCH 8
+
+PinEdges edges;
+Button butt;
+
+#if defined(__AVR__) && ! PINEDGE_DEFINE_ISR
+// the pin change group of PORT_SWITCH
+ISR(PCINT0_vect)
+{
+    edges.isr_group (0);
+}
+#endif
+
+static unsigned int g_clicks = 0;
+static unsigned int g_longs = 0;
+
+void
+butt_on_click(void * userdata, unsigned int times)
+{
+    TRACE1 ("INFO: switch pin %d pressed %d times", PORT_SWITCH, times);
+    g_clicks ++;
+}
+
+void
+butt_on_longpress(void * userdata)
+{
+    TRACE1 ("INFO: switch pin %d long pressed", PORT_SWITCH);
+    g_longs ++;
+}
+
+#if ! defined(ARDUINO)
+#include <pthread.h>
+
+// the loop is slower than the clicks and the bounces
+#define LOOP_MS 250
+
+// the presses of the script: the time pressed (ms), and the time released after it
+static const unsigned int g_press_ms[] = { 80, 60, 1500, 100, 80, 1600, 70, };
+#define NUM_PRESSES (sizeof(g_press_ms) / sizeof(g_press_ms[0]))
+#define GAP_MS 450
+
+// the level of the pin, read by the polled Button
+static volatile uint8_t g_level = HIGH;
+static volatile bool g_script_done = false;
+
+static void
+set_level (uint8_t level)
+{
+    g_level = level;
+    edges.isr_push (PORT_SWITCH, level);
+}
+
+// the bounces of the contact: the level toggles 4 times in 1-3 ms
+static void
+bounce (uint8_t level)
+{
+    unsigned int i;
+    for (i = 0; i < 4; i ++) {
+        set_level ((i & 1) ? ((level == HIGH) ? LOW : HIGH) : level);
+        usleep (1000 + (rand() % 2000));
+    }
+    set_level (level);
+}
+
+// the thread stands in for the pin change interrupt on PC
+static void *
+pin_thread (void * arg)
+{
+    unsigned int i;
+    usleep (100 * 1000);
+    for (i = 0; i < NUM_PRESSES; i ++) {
+        // the button pulls the pin LOW
+        bounce (LOW);
+        usleep (g_press_ms[i] * 1000);
+        bounce (HIGH);
+        usleep (GAP_MS * 1000);
+    }
+    g_script_done = true;
+    return NULL;
+}
+
+// the same button read at each loop
+class PolledButton : public Button {
+public:
+    inline bool feed (uint8_t level, unsigned long now) { return this->update_state (level, tick_from (now)); }
+};
+
+static unsigned int g_poll_clicks = 0;
+static unsigned int g_poll_longs = 0;
+void poll_on_click (unsigned int times) { g_poll_clicks ++; }
+void poll_on_long (void) { g_poll_longs ++; }
+
+void
+check_edges (void)
+{
+    PolledButton polled;
+    pthread_t thr;
+    unsigned int i;
+    unsigned int exp_clicks = 0;
+    unsigned int exp_longs = 0;
+    unsigned int num_edges = 0;
+    unsigned long t0 = micros();
+    unsigned long now;
+
+    for (i = 0; i < NUM_PRESSES; i ++) {
+        if (g_press_ms[i] > BUTSW_TIMEOUT_DBOUNCE + BUTSW_TIMEOUT_LONG) {
+            exp_longs ++;
+        } else {
+            exp_clicks ++;
+        }
+    }
+    polled.set_pin (PORT_SWITCH, LOW);
+    polled.on_click (Delegate<void(unsigned int)>::from_function<poll_on_click>());
+    polled.on_long_press (Delegate<void()>::from_function<poll_on_long>());
+
+    pthread_create (&thr, NULL, pin_thread, NULL);
+    while (1) {
+        // the clock of the loop is micros() on PC, the simulated millis() is not used
+        unsigned long now_us = micros();
+        now = (now_us - t0) / 1000;
+        num_edges += edges.dispatch (now, now_us);
+        butt.update (now);
+        polled.feed (g_level, now);
+        if (g_script_done && edges.empty() && ! butt.update (now)) {
+            break;
+        }
+        usleep (LOOP_MS * 1000);
+    }
+    pthread_join (thr, NULL);
+
+    printf ("loop %d ms, %u edges (%u dropped): edges %u clicks %u long presses, polled %u clicks %u long presses, expected %u clicks %u long presses\n"
+        , LOOP_MS, num_edges, edges.get_overflow(), g_clicks, g_longs, g_poll_clicks, g_poll_longs, exp_clicks, exp_longs);
+    assert (0 == edges.get_overflow());
+    assert (exp_clicks == g_clicks);
+    assert (exp_longs == g_longs);
+}
+
+static unsigned int g_times = 0;
+static unsigned int g_vlongs = 0;
+void level_on_click (unsigned int times) { g_times += times; }
+void level_on_vlong (void) { g_vlongs ++; }
+
+// the press in the time of the debounce after the release is reported by no edge once the timer expires
+void
+check_edge_debounce (void)
+{
+    PinEdges e2;
+    Button b2;
+    unsigned long t;
+    // the times (ms) of the edges: press, release, press in the debounce, release
+    static const unsigned int edge_ms[] = { 10, 110, 125, 310, };
+    const unsigned long base_us = 1000000UL;
+
+    b2.set_pin (PORT_SWITCH, LOW);
+    b2.on_click (Delegate<void(unsigned int)>::from_function<level_on_click>());
+    b2.set_edges (&e2);
+    g_times = 0;
+    for (t = 0; t < 1000; t ++) {
+        unsigned int i;
+        for (i = 0; i < sizeof(edge_ms) / sizeof(edge_ms[0]); i ++) {
+            if (edge_ms[i] == t) {
+                e2.isr_push (PORT_SWITCH, ((i & 1) ? HIGH : LOW), base_us + t * 1000);
+            }
+        }
+        e2.dispatch (t, base_us + t * 1000);
+        b2.update (t);
+    }
+    printf ("press in the debounce: %u clicks, expected 2\n", g_times);
+    assert (2 == g_times);
+    assert (! b2.update (t));
+}
+
+// the release dropped by the full ring is read from the pin
+void
+check_edge_overflow (void)
+{
+    PinEdges e3;
+    Button b3;
+    unsigned long t;
+    unsigned int i;
+    const unsigned long base_us = 1000000UL;
+    // the pin reads LOW on PC, the button is released
+    const uint8_t pin = 20;
+
+    b3.set_pin (pin, HIGH);
+    b3.on_vlong_press (Delegate<void()>::from_function<level_on_vlong>());
+    b3.set_edges (&e3);
+    g_vlongs = 0;
+    // the ring keeps the first edges, the last kept is a press and the release after it is dropped
+    for (i = 0; i < PINEDGE_QUEUE_SIZE + 3; i ++) {
+        e3.isr_push (pin, ((i & 1) ? LOW : HIGH), base_us + i * 10);
+    }
+    assert (e3.get_overflow() > 0);
+    for (t = 10; t < 10000; t ++) {
+        e3.dispatch (t, base_us + t * 1000);
+        b3.update (t);
+    }
+    printf ("edges dropped %u: %u very long presses, expected 0\n", e3.get_overflow(), g_vlongs);
+    assert (0 == g_vlongs);
+    assert (! b3.update (t));
+}
+#endif
+
+void
+setup(void)
+{
+#if DEBUG && defined(ARDUINO)
+    Serial.begin(9600);
+    // Wait for USB Serial.
+    while (!Serial) {}
+
+    // Read any input
+    delay(200);
+    while (Serial.read() >= 0) {}
+#endif
+
+    pinMode (PORT_SWITCH, INPUT_PULLUP);
+    butt.set_pin (PORT_SWITCH, LOW);
+    butt.on_click (butt_on_click);
+    butt.on_long_press (butt_on_longpress);
+    butt.set_edges (&edges);
+    edges.attach_hw ();
+
+#if ! defined(ARDUINO)
+    check_edges ();
+    check_edge_debounce ();
+    check_edge_overflow ();
+    exit (0);
+#endif
+}
+
+void
+loop(void)
+{
+    // no pin is read in the loop
+    edges.dispatch ();
+    butt.update ();
+}
+
+#if ! defined(ARDUINO)
+int
+main(void)
+{
+    setup();
+    while (1) {
+        loop();
+    }
+    return 0;
+}
+#endif
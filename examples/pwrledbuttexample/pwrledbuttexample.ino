@@ -9,6 +9,7 @@
 #include "sysport.h"
 #include "ledblink.h"
 #include "pwrledbutt.h"
+#include "scheduler.h"
 
 #ifdef __AVR_ATtiny85__
 #define PORT_SW_ONOFF  5
@@ -44,6 +45,8 @@
 #endif
 
 
+Scheduler sched;
+
 #if defined(__AVR__)
 #include <avr/sleep.h>
 
@@ -53,6 +56,7 @@ void sleep_on_wakeup()
     // timers and code using timers (serial.print and more...) will not work here.
     // we don't really need to execute any special functions here, since we
     // just want the thing to wake up
+    sched.wake();
 }
 
 void sleep_setup()
@@ -163,6 +167,9 @@ setup(void)
     pinMode(LED_BUILTIN, OUTPUT);
     led_nopwm.set_pin(LED_BUILTIN); // digital pin 13.
 
+    sched.add (&butt);
+    sched.add (&led_nopwm);
+
     sleep_setup();
 }
 
@@ -172,6 +179,8 @@ loop(void)
     ledkey_updates();
     update_signal ();
     automaton.run();
+    // idle until the next action, the button wakes it up by the interrupt
+    sched.idle (500);
 }
 
 #if ! defined(ARDUINO)
@@ -181,7 +190,6 @@ main(void)
     setup();
     while (1) {
         loop();
-        delay(500);
     }
     return 0;
 }
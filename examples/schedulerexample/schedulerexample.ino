@@ -0,0 +1,137 @@
+/**
+ * @file    schedulerexample.ino
+ * @brief   Example of the Scheduler: a panel of buttons and LEDs, only the active ones are updated
+ * @author  Yunhui Fu (yhfudev@gmail.com)
+ * @version 1.0
+ * @date    2016-07-14
+ * @copyright GPL
+ */
+#include "sysport.h"
+#include "button.h"
+#include "ledblink.h"
+#include "scheduler.h"
+
+#ifndef TRACE
+#define TRACE(...)
+#endif
+
+// 0 -- verbose, 1 -- info, 2 -- warning, 3 -- error
+#define TRACE0 TRACE
+#define TRACE1 TRACE
+#define TRACE2 TRACE
+#define TRACE3 TRACE
+
+#define PORT_SWITCH 3
+#define BLINK_TIME  200
+
+#if defined(ARDUINO)
+#define NUM_PANEL   4
+#else
+#define NUM_PANEL  24
+#endif
+
+// the first button is polled, the others are notified by the pin change interrupts
+Button butts[NUM_PANEL];
+LEDBlink leds[NUM_PANEL];
+Scheduler sched;
+
+// blink the LED of the panel for the clicks of its button
+class ClickBlink {
+public:
+    LEDBlink * pled;
+    void on_click(unsigned int times) { this->pled->start_blink (BLINK_TIME, times); }
+};
+ClickBlink clicks[NUM_PANEL];
+
+#if ! defined(ARDUINO)
+#include "scriptpin.h"
+
+// the loop cost of updating all of the objects vs. the active ones, with one LED blinking
+void
+bench_run (void)
+{
+#define BENCH_LOOPS 500
+    unsigned long i;
+    unsigned int j;
+    double t0, t1, t2, t3;
+
+    leds[1].start_blink (BLINK_TIME, 60000);
+    t0 = get_time_ns();
+    for (i = 0; i < BENCH_LOOPS; i ++) {
+        for (j = 0; j < NUM_PANEL; j ++) {
+            butts[j].update();
+            leds[j].update();
+        }
+    }
+    t1 = get_time_ns();
+    for (i = 0; i < BENCH_LOOPS; i ++) {
+        // millis() once in the loop
+        unsigned long now = millis();
+        for (j = 0; j < NUM_PANEL; j ++) {
+            butts[j].update(now);
+            leds[j].update(now);
+        }
+    }
+    t2 = get_time_ns();
+    for (i = 0; i < BENCH_LOOPS; i ++) {
+        sched.run();
+    }
+    t3 = get_time_ns();
+    printf ("%u buttons + %u LEDs, %u active: update all %7.1f ns, update all(now) %7.1f ns, Scheduler::run() %7.1f ns\n"
+        , NUM_PANEL, NUM_PANEL, sched.num_active()
+        , (t1 - t0) / BENCH_LOOPS, (t2 - t1) / BENCH_LOOPS, (t3 - t2) / BENCH_LOOPS);
+    leds[1].stop();
+}
+#endif
+
+void
+setup(void)
+{
+    unsigned int i;
+#if DEBUG && defined(ARDUINO)
+    Serial.begin(9600);
+    // Wait for USB Serial.
+    while (!Serial) {}
+
+    // Read any input
+    delay(200);
+    while (Serial.read() >= 0) {}
+#endif
+
+    for (i = 0; i < NUM_PANEL; i ++) {
+        pinMode (PORT_SWITCH + i, INPUT_PULLUP);
+        butts[i].set_pin (PORT_SWITCH + i);
+        clicks[i].pled = &(leds[i]);
+        butts[i].on_click (Delegate<void(unsigned int)>::from_method<ClickBlink, &ClickBlink::on_click>(&(clicks[i])));
+        butts[i].set_scheduler (&sched, (i > 0));
+
+        pinMode (PORT_SWITCH + NUM_PANEL + i, OUTPUT);
+        leds[i].set_pin (PORT_SWITCH + NUM_PANEL + i);
+        leds[i].set_scheduler (&sched);
+    }
+    // the pin change interrupts of the other buttons should call butts[i].on_pin_change()
+
+#if ! defined(ARDUINO)
+    bench_run ();
+#endif
+}
+
+void
+loop(void)
+{
+    sched.run();
+    sched.idle (1000);
+}
+
+#if ! defined(ARDUINO)
+int
+main(void)
+{
+    setup();
+    while (1) {
+        loop();
+    }
+    return 0;
+}
+#endif
+
@@ -1,78 +1,211 @@
 
 /**
  * @file    stlexample.cpp
- * @brief   Test STL library
+ * @brief   Test the fixed capacity containers, and compare them with STL on PC
  * @author  Yunhui Fu (yhfudev@gmail.com)
  * @version 1.0
  * @date    2016-07-14
  * @copyright GPL
  */
 
-#if defined(ARDUINO)
-// https://github.com/andysworkshop/avr-stl.git
-//#include <avr_config.h> // compile error
-//https://github.com/vancegroup/stlport-avr.git
-//#include <stlport.h> // compile error
-
-// uclibc
-// https://github.com/maniacbug/StandardCplusplus.git
-#include <StandardCplusplus.h>
-#endif
+#include "sysport.h"
+#include "staticvector.h"
+#include "ringbuffer.h"
+#include "intrusiveheap.h"
 
+#if ! defined(ARDUINO)
+#include "scriptpin.h"
 #include <algorithm>    // std::make_heap, std::pop_heap, std::push_heap, std::sort_heap
 #include <vector>       // std::vector
+#include <queue>        // std::queue
+#endif
 
-#include "sysport.h"
+#define NUM_ITEMS 50
+
+struct HeapItem {
+    int val;
+    uint8_t heap_idx;
+};
+struct HeapItemLess {
+    bool operator() (const HeapItem * a, const HeapItem * b) const { return a->val < b->val; }
+};
 
 struct TestVector {
     static void RunTest() {
-        //std::ohserialstream serial(Serial);
-        std::vector<int> vec;
-        std::vector<int>::const_iterator it;
+        static_vector<int, NUM_ITEMS> vec;
+        static_vector<int, NUM_ITEMS>::const_iterator it;
         int i;
 
-        vec.reserve(50);
-        for(i=0;i<50;i++)
+        for(i=0;i<NUM_ITEMS;i++)
           vec.push_back(i);
+        assert (! vec.push_back(i));
 
         for(it=vec.begin();it!=vec.end();it++)
-          //serial << *it << std::endl;
-          ;
+          TRACE ("%d", *it);
     }
 };
 
 struct TestHeap {
     static void RunTest()
     {
-        //std::ohserialstream serial(Serial);
         int myints[] = {10,20,30,5,15};
-        std::vector<int> v(myints,myints+5);
+        static HeapItem items[6];
+        intrusive_heap<HeapItem, 6, HeapItemLess> h;
+        unsigned int i;
 
-        std::make_heap (v.begin(),v.end());
-        //serial << "initial max heap   : " << v.front() << '\n';
-        TRACE ("initial max heap : %d", v.front());
+        for (i = 0; i < 5; i ++) {
+            items[i].val = myints[i];
+            h.push (&(items[i]));
+        }
+        TRACE ("initial min heap : %d", h.top()->val);
 
-        std::pop_heap (v.begin(),v.end()); v.pop_back();
-        //serial << "max heap after pop : " << v.front() << '\n';
-        TRACE ("max heap after pop : %d", v.front());
+        h.pop();
+        TRACE ("min heap after pop : %d", h.top()->val);
 
-        v.push_back(99); std::push_heap (v.begin(),v.end());
-        //serial << "max heap after push: " << v.front() << '\n';
-        TRACE ("max heap after push: %d", v.front());
+        items[5].val = 1;
+        h.push (&(items[5]));
+        TRACE ("min heap after push: %d", h.top()->val);
 
-        std::sort_heap (v.begin(),v.end());
+        items[5].val = 99;
+        h.update (&(items[5]));
+        TRACE ("min heap after update: %d", h.top()->val);
 
-        //serial << "final sorted range :";
-        for (unsigned i=0; i<v.size(); i++) {
-            //serial << ' ' << v[i];
-            TRACE ("%d", v[i]);
+        int prev = 0;
+        while (! h.empty()) {
+            HeapItem * p = h.pop();
+            assert (prev <= p->val);
+            prev = p->val;
+            TRACE ("%d", p->val);
         }
+    }
+};
 
-        //serial << '\n';
-        //return 0;
+struct TestRing {
+    static void RunTest()
+    {
+        ring_buffer<uint8_t, 16> q;
+        uint8_t i;
+        uint8_t val;
+
+        for (i = 0; q.push (i); i ++) {
+        }
+        assert (q.full());
+        while (q.pop (val)) {
+            TRACE ("%d", val);
+        }
     }
 };
 
+#if ! defined(ARDUINO)
+#define BENCH_LOOPS 200000
+
+static volatile long g_sum = 0;
+
+static void
+bench_vector (void)
+{
+    double t0, t1, t2;
+    unsigned long i;
+    int j;
+
+    t0 = get_time_ns();
+    for (i = 0; i < BENCH_LOOPS; i ++) {
+        std::vector<int> vec;
+        vec.reserve (NUM_ITEMS);
+        for (j = 0; j < NUM_ITEMS; j ++) {
+            vec.push_back (j);
+        }
+        for (std::vector<int>::iterator it = vec.begin(); it != vec.end(); it ++) {
+            g_sum += *it;
+        }
+    }
+    t1 = get_time_ns();
+    for (i = 0; i < BENCH_LOOPS; i ++) {
+        static_vector<int, NUM_ITEMS> vec;
+        for (j = 0; j < NUM_ITEMS; j ++) {
+            vec.push_back (j);
+        }
+        for (static_vector<int, NUM_ITEMS>::iterator it = vec.begin(); it != vec.end(); it ++) {
+            g_sum += *it;
+        }
+    }
+    t2 = get_time_ns();
+    printf ("vector %d push_back+iterate:  std::vector %7.1f ns, static_vector %7.1f ns\n", NUM_ITEMS, (t1 - t0) / BENCH_LOOPS, (t2 - t1) / BENCH_LOOPS);
+}
+
+static void
+bench_heap (void)
+{
+    static HeapItem items[NUM_ITEMS];
+    double t0, t1, t2;
+    unsigned long i;
+    int j;
+
+    for (j = 0; j < NUM_ITEMS; j ++) {
+        items[j].val = rand();
+    }
+    t0 = get_time_ns();
+    for (i = 0; i < BENCH_LOOPS / 10; i ++) {
+        std::vector<int> v;
+        v.reserve (NUM_ITEMS);
+        for (j = 0; j < NUM_ITEMS; j ++) {
+            v.push_back (items[j].val);
+            std::push_heap (v.begin(), v.end());
+        }
+        while (! v.empty()) {
+            g_sum += v.front();
+            std::pop_heap (v.begin(), v.end());
+            v.pop_back();
+        }
+    }
+    t1 = get_time_ns();
+    for (i = 0; i < BENCH_LOOPS / 10; i ++) {
+        intrusive_heap<HeapItem, NUM_ITEMS, HeapItemLess> h;
+        for (j = 0; j < NUM_ITEMS; j ++) {
+            h.push (&(items[j]));
+        }
+        while (! h.empty()) {
+            g_sum += h.pop()->val;
+        }
+    }
+    t2 = get_time_ns();
+    printf ("heap %d push+pop:             std::push_heap %6.1f ns, intrusive_heap %6.1f ns\n", NUM_ITEMS, (t1 - t0) / (BENCH_LOOPS / 10), (t2 - t1) / (BENCH_LOOPS / 10));
+}
+
+static void
+bench_queue (void)
+{
+    double t0, t1, t2;
+    unsigned long i;
+    int j;
+    int val;
+
+    t0 = get_time_ns();
+    std::queue<int> q1;
+    for (i = 0; i < BENCH_LOOPS; i ++) {
+        for (j = 0; j < 8; j ++) {
+            q1.push (j);
+        }
+        while (! q1.empty()) {
+            g_sum += q1.front();
+            q1.pop();
+        }
+    }
+    t1 = get_time_ns();
+    ring_buffer<int, 8> q2;
+    for (i = 0; i < BENCH_LOOPS; i ++) {
+        for (j = 0; j < 8; j ++) {
+            q2.push (j);
+        }
+        while (q2.pop (val)) {
+            g_sum += val;
+        }
+    }
+    t2 = get_time_ns();
+    printf ("queue 8 push+pop:              std::queue %10.1f ns, ring_buffer %9.1f ns\n", (t1 - t0) / BENCH_LOOPS, (t2 - t1) / BENCH_LOOPS);
+}
+#endif
+
 void setup(void) {
     TRACE ("setup");
 #if USE_DEBUG && defined(ARDUINO)
@@ -87,6 +220,13 @@ void setup(void) {
 
     TestVector::RunTest();
     TestHeap::RunTest();
+    TestRing::RunTest();
+
+#if ! defined(ARDUINO)
+    bench_vector();
+    bench_heap();
+    bench_queue();
+#endif
 }
 
 void loop(void) {
@@ -106,4 +246,3 @@ main(void)
 }
 
 #endif
-
@@ -0,0 +1,135 @@
+/**
+ * @file    taskexample.ino
+ * @brief   Example of the Task: the sequence of the power LED written as the straight-line code
+ * @author  Yunhui Fu (yhfudev@gmail.com)
+ * @version 1.0
+ * @date    2016-07-14
+ * @copyright GPL
+ */
+#include "sysport.h"
+#include "button.h"
+#include "ledblink.h"
+#include "frameclock.h"
+#include "task.h"
+
+#ifndef TRACE
+#define TRACE(...)
+#endif
+
+// 0 -- verbose, 1 -- info, 2 -- warning, 3 -- error
+#define TRACE0 TRACE
+#define TRACE1 TRACE
+#define TRACE2 TRACE
+#define TRACE3 TRACE
+
+#define PORT_SWITCH   3
+#define PORT_LED_PWM  6
+
+// the time waiting the host
+#define TIMEOUT_READY 180000
+
+Button butt;
+LEDBlink led;
+FrameClock clk;
+TaskSignal sig_click; // set by the clicks of the button
+
+// blink 6 times, fade in, wait for the click with the timeout, then fade out
+class PowerSequence : public Task {
+public:
+    bool update(unsigned long now) {
+        TASK_BEGIN();
+        TRACE1 ("seq: blink");
+        led.start_blink (200, 6, now);
+        TASK_WAIT_UNTIL(! led.is_busy());
+        TRACE1 ("seq: fade in");
+        led.start_fade (1000, 0, 255, now);
+        TASK_WAIT_UNTIL(! led.is_busy());
+        TRACE1 ("seq: wait for the click");
+        TASK_WAIT_UNTIL_TIMEOUT(sig_click.take(), TIMEOUT_READY, now);
+        if (this->task_timed_out()) {
+            TRACE1 ("seq: timeout");
+            TASK_EXIT();
+        }
+        TRACE1 ("seq: clicked, fade out in 500 ms");
+        TASK_DELAY(500, now);
+        led.start_fade (1000, 255, 0, now);
+        TASK_WAIT_UNTIL(! led.is_busy());
+        TRACE1 ("seq: done");
+        TASK_END();
+    }
+};
+PowerSequence seq;
+
+#if TASK_USE_COROUTINE
+// the same sequence by the coroutine
+CoTask
+power_sequence(void)
+{
+    TRACE1 ("coro: blink");
+    led.start_blink (200, 6, clk.now());
+    co_await task_until ([]{ return ! led.is_busy(); });
+    TRACE1 ("coro: fade in");
+    led.start_fade (1000, 0, 255, clk.now());
+    co_await task_until ([]{ return ! led.is_busy(); });
+    TRACE1 ("coro: wait for the click");
+    if (! co_await task_wait (sig_click, TIMEOUT_READY)) {
+        TRACE1 ("coro: timeout");
+        co_return;
+    }
+    TRACE1 ("coro: clicked, fade out in 500 ms");
+    co_await task_sleep (500);
+    led.start_fade (1000, 255, 0, clk.now());
+    co_await task_until ([]{ return ! led.is_busy(); });
+    TRACE1 ("coro: done");
+}
+CoTask coro;
+#endif
+
+void
+setup(void)
+{
+#if DEBUG && defined(ARDUINO)
+    Serial.begin(9600);
+    // Wait for USB Serial.
+    while (!Serial) {}
+
+    // Read any input
+    delay(200);
+    while (Serial.read() >= 0) {}
+#endif
+
+    pinMode (PORT_SWITCH, INPUT_PULLUP);
+    butt.set_pin (PORT_SWITCH);
+    butt.on_click (Delegate<void(unsigned int)>::from_method<TaskSignal, &TaskSignal::signal_times>(&sig_click));
+
+    pinMode (PORT_LED_PWM, OUTPUT);
+    led.set_pin (PORT_LED_PWM);
+#if TASK_USE_COROUTINE
+    coro = power_sequence();
+#endif
+}
+
+void
+loop(void)
+{
+    unsigned long now = clk.tick();
+    butt.update (now);
+    led.update (now);
+#if TASK_USE_COROUTINE
+    coro.update (now);
+#else
+    seq.update (now);
+#endif
+}
+
+#if ! defined(ARDUINO)
+int
+main(void)
+{
+    setup();
+    while (1) {
+        loop();
+    }
+    return 0;
+}
+#endif
@@ -0,0 +1,147 @@
+/**
+ * @file    tickexample.ino
+ * @brief   Check the timing of Button and LEDBlink across the wrap around of the ticks
+ * @author  Yunhui Fu (yhfudev@gmail.com)
+ * @version 1.0
+ * @date    2016-07-14
+ * @copyright GPL
+ */
+#include "sysport.h"
+#include "tick.h"
+#include "button.h"
+#include "ledblink.h"
+
+#ifndef TRACE
+#define TRACE(...)
+#endif
+
+// 0 -- verbose, 1 -- info, 2 -- warning, 3 -- error
+#define TRACE0 TRACE
+#define TRACE1 TRACE
+#define TRACE2 TRACE
+#define TRACE3 TRACE
+
+// the pin reads LOW on PC
+#define PORT_SWITCH 7
+#define PORT_LED    9
+
+#define FADE_TIME 1000
+
+// the start time of the checks: normal, the wrap of 16-bit ticks, the wrap of 32-bit millis()
+static const unsigned long g_starts[] = {
+    1000,
+    0xFFFFUL - 2000,
+    0xFFFFFFFFUL - 2000,
+};
+
+static unsigned long g_now = 0;
+static unsigned long g_time_vlong = 0;
+
+void
+butt_on_vlongpress(void * userdata)
+{
+    if (0 == g_time_vlong) {
+        g_time_vlong = g_now;
+    }
+}
+
+// the modular helpers
+void
+check_tick (void)
+{
+    unsigned int i;
+    for (i = 0; i < sizeof(g_starts) / sizeof(g_starts[0]); i ++) {
+        unsigned long now = g_starts[i];
+        tick_t t = tick_from (now);
+        tick_t deadline = t + 3000;
+        assert (! tick_reached (t, deadline));
+        assert (! tick_reached (tick_from (now + 2999), deadline));
+        assert (tick_reached (tick_from (now + 3000), deadline));
+        assert (tick_reached (tick_from (now + 3001), deadline));
+        assert (tick_before (t, deadline));
+        assert (3000 == tick_elapsed (tick_from (now + 3000), t));
+        assert (now + 3000 == tick_to_ms (deadline, now));
+        assert (now + 3000 == tick_to_ms (deadline, now + 2000));
+    }
+    assert (TICK_MAX_SPAN == tick_span (0xFFFFFFFFUL));
+    assert (100 == tick_span (100));
+}
+
+// a button held down: the very long press is reported after debounce + long + very long
+void
+check_button (unsigned long start)
+{
+    Button butt;
+    butt.set_pin (PORT_SWITCH, LOW);
+    butt.on_vlong_press (butt_on_vlongpress);
+    g_time_vlong = 0;
+    for (g_now = start; g_now - start < 6000; g_now ++) {
+        butt.update (g_now);
+    }
+    assert (g_time_vlong - start == BUTSW_TIMEOUT_DBOUNCE + BUTSW_TIMEOUT_LONG + BUTSW_TIMEOUT_VLONG);
+}
+
+// the fade is finished at the exact time
+template <class LED>
+void
+check_led (LED & led, unsigned long start)
+{
+    led.start_fade (FADE_TIME, 0, 100, start);
+    for (g_now = start + 1; g_now - start < FADE_TIME * 2; g_now ++) {
+        led.update (g_now);
+        if (! led.is_busy ()) {
+            break;
+        }
+    }
+    assert (g_now - start == FADE_TIME);
+}
+
+void
+setup(void)
+{
+    unsigned int i;
+#if DEBUG && defined(ARDUINO)
+    Serial.begin(9600);
+    // Wait for USB Serial.
+    while (!Serial) {}
+
+    // Read any input
+    delay(200);
+    while (Serial.read() >= 0) {}
+#endif
+
+#if ! defined(ARDUINO)
+    check_tick ();
+    for (i = 0; i < sizeof(g_starts) / sizeof(g_starts[0]); i ++) {
+        check_button (g_starts[i]);
+        LEDBlink led;
+        FastLEDBlink<PORT_LED> fled;
+        led.set_pin (PORT_LED);
+        check_led (led, g_starts[i]);
+        check_led (fled, g_starts[i]);
+    }
+    // the pin of FastLEDBlink is written without any pointer in the object
+    assert (sizeof(FastLEDBlink<PORT_LED>) == sizeof(LEDBlink));
+    printf ("tick_t %d bits: sizeof(Button)=%d, sizeof(LEDBlink)=%d, wrap checks ok\n"
+        , (int)sizeof(tick_t) * 8, (int)sizeof(Button), (int)sizeof(LEDBlink));
+    exit (0);
+#endif
+}
+
+void
+loop(void)
+{
+}
+
+#if ! defined(ARDUINO)
+int
+main(void)
+{
+    setup();
+    while (1) {
+        loop();
+    }
+    return 0;
+}
+#endif
+
@@ -0,0 +1,404 @@
+/**
+ * @file    timerintexample.ino
+ * @brief   Example and benchmark of the timing wheel TimerInt
+ * @author  Yunhui Fu (yhfudev@gmail.com)
+ * @version 1.0
+ * @date    2016-07-14
+ * @copyright GPL
+ */
+#include "sysport.h"
+#include "timerint.h"
+#include "button.h"
+
+#ifndef TRACE
+#define TRACE(...)
+#endif
+
+// 0 -- verbose, 1 -- info, 2 -- warning, 3 -- error
+#define TRACE0 TRACE
+#define TRACE1 TRACE
+#define TRACE2 TRACE
+#define TRACE3 TRACE
+
+#define BLINK_TIME 500
+
+TimerInt timers;
+uint8_t g_led_val = LOW;
+
+void
+cb_blink(void * userdata)
+{
+    g_led_val = (g_led_val == LOW)?HIGH:LOW;
+    digitalWrite (LED_BUILTIN, g_led_val);
+    timers.start (BLINK_TIME, userdata, cb_blink);
+}
+
+#if ! defined(ARDUINO)
+#include "scriptpin.h"
+
+static TimerInt * g_ptm = nullptr;
+static unsigned long g_num_fired = 0;
+static bool g_fire_late = false;
+
+struct TestItem {
+    int id;
+    unsigned long expires;
+};
+
+void
+cb_check(void * userdata)
+{
+    TestItem * pit = (TestItem *)userdata;
+    if (pit->expires != g_ptm->get_time()) {
+        printf ("Error: timer fired at %lu, expected %lu\n", g_ptm->get_time(), pit->expires);
+        g_fire_late = true;
+    }
+    pit->id = -1;
+    g_num_fired ++;
+}
+
+void
+cb_nothing(void * userdata)
+{
+}
+
+// check the timers fired at the exact tick, with random start, cancel and restart
+void
+check_timers (void)
+{
+    static TestItem lst[TIMERINT_MAX_ITEMS];
+    TimerInt * ptm = new TimerInt();
+    unsigned int i;
+    unsigned long num_canceled = 0;
+    unsigned long now = 123456;
+
+    g_ptm = ptm;
+    g_num_fired = 0;
+    ptm->tick (now);
+    for (i = 0; i < TIMERINT_MAX_ITEMS; i ++) {
+        // from 1 tick up to beyond the range of the wheel
+        unsigned long tm = 1 + (rand() % 5 ? rand() % 5000 : rand() % (3L << (TIMERINT_WHEEL_BITS * TIMERINT_WHEEL_LEVELS)));
+        lst[i].expires = now + tm;
+        lst[i].id = ptm->start (tm, &(lst[i]), cb_check);
+        assert (lst[i].id >= 0);
+    }
+    assert (ptm->start (1, nullptr, cb_nothing) < 0);
+    for (i = 0; i < TIMERINT_MAX_ITEMS; i += 3) {
+        assert (0 == ptm->cancel (lst[i].id));
+        assert (ptm->cancel (lst[i].id) < 0);
+        lst[i].id = -1;
+        num_canceled ++;
+    }
+    for (i = 1; i < TIMERINT_MAX_ITEMS; i += 3) {
+        unsigned long tm = 1 + rand() % 10000;
+        lst[i].expires = now + tm;
+        assert (lst[i].id == ptm->restart (lst[i].id, tm));
+    }
+    while (ptm->size() > 0) {
+        now += 1 + rand() % 300;
+        ptm->tick (now);
+    }
+    assert (! g_fire_late);
+    assert (g_num_fired + num_canceled == TIMERINT_MAX_ITEMS);
+    delete ptm;
+    printf ("TimerInt check: %lu fired, %lu canceled, ok\n", g_num_fired, num_canceled);
+}
+
+struct IsrItem {
+    int id;
+    unsigned long expires;
+    bool active;
+};
+static unsigned long g_isr_fired = 0;
+static unsigned long g_isr_late_max = 0;
+static bool g_isr_error = false;
+
+void
+cb_isr_check(void * userdata)
+{
+    IsrItem * pit = (IsrItem *)userdata;
+    unsigned long now = g_ptm->get_time();
+    if ((! pit->active) || ((long)(now - pit->expires) < 0)) {
+        g_isr_error = true;
+    }
+    if (now - pit->expires > g_isr_late_max) {
+        g_isr_late_max = now - pit->expires;
+    }
+    pit->active = false;
+    g_isr_fired ++;
+}
+
+// stress the queue between the timer thread (ISR) and the loop
+void
+check_isr (void)
+{
+#define NUM_ISR_ITEMS 64
+    static IsrItem lst[NUM_ISR_ITEMS];
+    TimerInt * ptm = new TimerInt();
+    unsigned long num_started = 0;
+    unsigned long num_canceled = 0;
+    unsigned int i;
+
+    g_ptm = ptm;
+    for (i = 0; i < NUM_ISR_ITEMS; i ++) {
+        lst[i].active = false;
+    }
+    assert (0 == ptm->attach_hw());
+    while (ptm->get_time() < 1000) {
+        i = rand() % NUM_ISR_ITEMS;
+        if (! lst[i].active) {
+            unsigned long tm = 1 + rand() % 50;
+            lst[i].expires = ptm->get_time() + tm;
+            lst[i].active = true;
+            lst[i].id = ptm->start (tm, &(lst[i]), cb_isr_check);
+            assert (lst[i].id >= 0);
+            num_started ++;
+        } else if (rand() % 4 == 0) {
+            // may be expired and waiting in the queue, but not called yet
+            assert (0 == ptm->cancel (lst[i].id));
+            lst[i].active = false;
+            num_canceled ++;
+        }
+        if (rand() % 100 == 0) {
+            // a slow loop
+            usleep (rand() % 5000);
+        }
+        ptm->expire();
+    }
+    // wait for the rest of the timers
+    for (i = 0; i < NUM_ISR_ITEMS; i ++) {
+        while (lst[i].active) {
+            usleep (1000);
+            ptm->expire();
+        }
+    }
+    ptm->detach_hw();
+    assert (! g_isr_error);
+    assert (g_isr_fired + num_canceled == num_started);
+    delete ptm;
+    printf ("TimerInt ISR check: %lu started, %lu fired, %lu canceled, max late %lu ms, ok\n", num_started, g_isr_fired, num_canceled, g_isr_late_max);
+}
+
+struct PeriodicItem {
+    unsigned long calls;
+    unsigned long overrun;
+    unsigned long last;
+    int id;
+};
+
+void
+cb_periodic(void * userdata)
+{
+    PeriodicItem * pit = (PeriodicItem *)userdata;
+    pit->calls ++;
+    pit->overrun += g_ptm->get_overrun (pit->id);
+    pit->last = g_ptm->get_time();
+}
+
+// a periodic timer of 10 ms stalled 45 ms by a slow loop, for each of the catch-up policies
+void
+check_periodic (void)
+{
+    static const char * names[] = { "burst", "skip", "coalesce" };
+    // the calls from 1000 to 1300, 4 periods dropped or merged by the stall
+    static const unsigned long expected[] = { 30, 26, 26 };
+    PeriodicItem pi;
+    uint8_t catchup;
+    unsigned long now;
+
+    for (catchup = TIMERINT_CATCHUP_BURST; catchup <= TIMERINT_CATCHUP_COALESCE; catchup ++) {
+        TimerInt * ptm = new TimerInt();
+        g_ptm = ptm;
+        memset (&pi, 0, sizeof(pi));
+        ptm->tick (1000);
+        pi.id = ptm->start_periodic (10, &pi, cb_periodic, catchup);
+        assert (pi.id >= 0);
+        for (now = 1001; now <= 1300; now ++) {
+            if ((now > 1105) && (now < 1150)) {
+                continue;
+            }
+            ptm->tick (now);
+        }
+        // the phase is kept, no drift after the stall
+        assert (0 == pi.last % 10);
+        assert (expected[catchup] == pi.calls);
+        assert (((TIMERINT_CATCHUP_COALESCE == catchup)?4:0) == pi.overrun);
+#if TIMERINT_JITTER
+        TimerInt::Jitter jt;
+        assert (0 == ptm->get_jitter (pi.id, jt));
+        printf ("TimerInt periodic %-8s: %2lu calls, overrun %lu, late avg %.2f max %lu ms, missed %lu\n"
+            , names[catchup], pi.calls, pi.overrun, (double)jt.late_sum / jt.count, jt.late_max, jt.missed);
+#endif
+        assert (0 == ptm->cancel (pi.id));
+        assert (0 == ptm->size());
+        delete ptm;
+    }
+}
+
+static unsigned int g_butt_clicks = 0;
+void cb_butt_click (unsigned int times) { g_butt_clicks += times; }
+
+// all of the timers are taken, the timeouts of the Button are polled instead
+void
+check_button_no_timer (void)
+{
+    TimerInt * ptm = new TimerInt();
+    ScriptButton<false> butt;
+    unsigned long t0;
+    unsigned long now;
+    unsigned int i;
+    ptm->tick (millis());
+    for (i = 0; i < TIMERINT_MAX_ITEMS; i ++) {
+        assert (ptm->start (100000, nullptr, cb_nothing) >= 0);
+    }
+    assert (ptm->start (100000, nullptr, cb_nothing) < 0);
+    butt.set_pin (20, HIGH);
+    butt.set_timer (ptm);
+    butt.on_click (Delegate<void(unsigned int)>::from_function<cb_butt_click>());
+    g_butt_clicks = 0;
+    t0 = millis();
+    // pressed for 200 ms
+    for (now = t0; now - t0 < 1000; now = millis()) {
+        ptm->tick (now);
+        butt.feed (((now - t0 < 200) ? HIGH : LOW), now);
+    }
+    assert (1 == g_butt_clicks);
+    printf ("TimerInt full: the Button polls its timeouts, %u click\n", g_butt_clicks);
+    delete ptm;
+}
+
+struct SlackItem {
+    TimerInt * ptm;
+    unsigned long period;
+    unsigned long slack;
+};
+
+void
+cb_slack(void * userdata)
+{
+    SlackItem * pit = (SlackItem *)userdata;
+    pit->ptm->start (pit->period, pit, cb_slack, pit->slack);
+}
+
+// the timeouts of the buttons and LEDs re-armed again and again,
+// count the wakeups with and without slack
+void
+bench_slack (void)
+{
+#define NUM_SLACK_ITEMS 24
+    static SlackItem lst[NUM_SLACK_ITEMS];
+    static const unsigned long periods[] = { 30, 250, 20 }; // debounce, double click, LED step
+    unsigned int pct;
+    unsigned int i;
+
+    for (pct = 0; pct <= 25; pct += 5) {
+        TimerInt * ptm = new TimerInt();
+        ptm->tick (1000);
+        srand (1);
+        for (i = 0; i < NUM_SLACK_ITEMS; i ++) {
+            lst[i].ptm = ptm;
+            lst[i].period = periods[i % 3];
+            lst[i].slack = lst[i].period * pct / 100;
+            ptm->start (1 + rand() % lst[i].period, &(lst[i]), cb_slack, lst[i].slack);
+        }
+        ptm->tick (1000 + 60000);
+        printf ("slack %2u%%: %6lu expired in %6lu wakeups, %6lu wakeups saved\n"
+            , pct, ptm->get_num_expired(), ptm->get_num_wakeups(), ptm->get_wakeups_saved());
+        delete ptm;
+    }
+}
+
+// the cost of start + cancel, restart and tick with n pending timers
+void
+bench_timers (unsigned int n)
+{
+#define BENCH_LOOPS 200000
+    static int ids[TIMERINT_MAX_ITEMS];
+    TimerInt * ptm = new TimerInt();
+    unsigned long i;
+    double t0, t1, t2, t3;
+    unsigned long now = 1000;
+
+    ptm->tick (now);
+    for (i = 0; i < n - 1; i ++) {
+        ids[i] = ptm->start (1 + rand() % 60000, nullptr, cb_nothing);
+    }
+
+    t0 = get_time_ns();
+    for (i = 0; i < BENCH_LOOPS; i ++) {
+        int id = ptm->start (1 + (i * 7919) % 60000, nullptr, cb_nothing);
+        ptm->cancel (id);
+    }
+    t1 = get_time_ns();
+    for (i = 0; i < BENCH_LOOPS; i ++) {
+        ptm->restart (ids[i % (n - 1)], 1 + (i * 7919) % 60000);
+    }
+    t2 = get_time_ns();
+    for (i = 0; i < BENCH_LOOPS; i ++) {
+        // keep the number of the pending timers
+        now ++;
+        ptm->tick (now);
+        while (ptm->size() < n - 1) {
+            ptm->start (1 + rand() % 60000, nullptr, cb_nothing);
+        }
+    }
+    t3 = get_time_ns();
+    printf ("%8u pending: start+cancel %6.1f ns, restart %6.1f ns, tick(1ms) %6.1f ns\n"
+        , n
+        , (t1 - t0) / BENCH_LOOPS
+        , (t2 - t1) / BENCH_LOOPS
+        , (t3 - t2) / BENCH_LOOPS
+        );
+    delete ptm;
+}
+#endif
+
+void
+setup(void)
+{
+#if DEBUG && defined(ARDUINO)
+    Serial.begin(9600);
+    // Wait for USB Serial.
+    while (!Serial) {}
+
+    // Read any input
+    delay(200);
+    while (Serial.read() >= 0) {}
+#endif
+
+#if ! defined(ARDUINO)
+    unsigned int n;
+    check_timers ();
+    check_isr ();
+    check_periodic ();
+    check_button_no_timer ();
+    bench_slack ();
+    for (n = 16; n <= TIMERINT_MAX_ITEMS; n *= 2) {
+        bench_timers (n);
+    }
+#endif
+
+    pinMode(LED_BUILTIN, OUTPUT);
+    timers.tick (millis());
+    timers.start (BLINK_TIME, nullptr, cb_blink);
+}
+
+void
+loop(void)
+{
+    timers.expire();
+}
+
+#if ! defined(ARDUINO)
+int
+main(void)
+{
+    setup();
+    while (1) {
+        loop();
+        delay(1);
+    }
+    return 0;
+}
+#endif
+
@@ -0,0 +1,159 @@
+/**
+ * @file    analogladder.h
+ * @brief   Many buttons on one ADC pin by a resistor ladder, decoded by a threshold table in PROGMEM
+ * @author  Yunhui Fu (yhfudev@gmail.com)
+ * @version 1.0
+ * @date    2016-07-14
+ * @copyright GPL
+ */
+/**
+ * Usage:
+ *   The buttons of a resistor ladder pull one analog pin to different voltages.
+ *   The AnalogButtonLadder<N> reads the pin once in each update(), finds the band of the reading
+ *   by the binary search in the N sorted thresholds (in PROGMEM), and passes the button of the band
+ *   to the state machines of the ButtonBank<N> by update_bits(), so each button has the clicks,
+ *   the long press and the callbacks of the ButtonBank.
+ *   The readings between thresholds[i-1] and thresholds[i] are the button i, and the readings
+ *   not below thresholds[N-1] are released (the pin is pulled up when no button is pressed).
+ *   If idle_low is set, the readings below thresholds[0] are released, and the readings between
+ *   thresholds[i] and thresholds[i+1] are the button i.
+ *   The band changes only if the reading is at least the hysteresis away from the thresholds,
+ *   so the noise around a threshold doesn't toggle the buttons.
+ *   Only one button can be pressed at a time.
+ *
+ *   Example:
+ *     // the keypad of the LCD shield: right 0, up 145, down 330, left 505, select 740, none 1023
+ *     static const uint16_t keypad_thresholds[5] PROGMEM = { 72, 237, 417, 622, 881 };
+ *     AnalogButtonLadder<5> keypad;
+ *     void keypad_on_click(uint8_t idx, unsigned int times) { ... }
+ *     void setup(void) {
+ *         keypad.set_ladder (A0, keypad_thresholds);
+ *         keypad.on_click (Delegate<void(uint8_t, unsigned int)>::from_function<keypad_on_click>());
+ *     }
+ *     void loop(void) {
+ *         keypad.update();
+ *     }
+ */
+
+#ifndef _ANALOG_LADDER_H
+#define _ANALOG_LADDER_H 1
+
+#include "sysport.h"
+#include "buttonbank.h"
+
+// the default hysteresis, in the units of analogRead()
+#ifndef ANALOGLADDER_HYSTERESIS
+#define ANALOGLADDER_HYSTERESIS 8
+#endif
+
+// no button is pressed
+#define ANALOGLADDER_NONE 0xFF
+
+template <uint8_t N>
+class AnalogButtonLadder : public ButtonBank<N> {
+public:
+    typedef typename ButtonBank<N>::mask_t mask_t;
+
+    AnalogButtonLadder () : pin(0), thresholds(nullptr), idle_low(false), hysteresis(ANALOGLADDER_HYSTERESIS), band(N) {}
+
+    // thresholds: N values in ascending order in PROGMEM, return -1 on error
+    int set_ladder (uint8_t analog_pin, const uint16_t * thresholds1, bool idle_low1 = false, uint8_t hysteresis1 = ANALOGLADDER_HYSTERESIS);
+
+    // read the pin and update all of the buttons, return true if any button is busy
+    inline bool update (void) { return this->update (millis()); }
+    inline bool update (unsigned long now) { return this->update_reading (analogRead (this->pin), now); }
+    // same as above, with the reading of the pin by the caller
+    bool update_reading (uint16_t reading, unsigned long now);
+
+    // the button of the reading with the hysteresis, ANALOGLADDER_NONE if released
+    uint8_t decode (uint16_t reading);
+    // the button of the last reading, ANALOGLADDER_NONE if released
+    inline uint8_t get_pressed (void) const { return this->band_to_button (this->band); }
+
+private:
+    // the number of the thresholds not above the reading
+    uint8_t search (uint16_t reading) const;
+    inline uint8_t band_to_button (uint8_t band1) const {
+        if (this->idle_low) {
+            return ((band1 > 0) ? (band1 - 1) : ANALOGLADDER_NONE);
+        }
+        return ((band1 < N) ? band1 : ANALOGLADDER_NONE);
+    }
+
+    uint8_t pin;
+    const uint16_t * thresholds; // in PROGMEM
+    bool idle_low;      // released if the reading is below thresholds[0]
+    uint8_t hysteresis;
+    uint8_t band;       // the band of the last reading, 0 to N
+};
+
+template <uint8_t N>
+int
+AnalogButtonLadder<N>::set_ladder (uint8_t analog_pin, const uint16_t * thresholds1, bool idle_low1, uint8_t hysteresis1)
+{
+    if (nullptr == thresholds1) {
+        return -1;
+    }
+    this->pin = analog_pin;
+    this->thresholds = thresholds1;
+    this->idle_low = idle_low1;
+    this->hysteresis = hysteresis1;
+    this->band = (idle_low1 ? 0 : N);
+    // all of the buttons are fed by update_bits()
+    this->set_used ((mask_t)((mask_t)(~(mask_t)0) >> (sizeof(mask_t) * 8 - N)));
+    return 0;
+}
+
+template <uint8_t N>
+uint8_t
+AnalogButtonLadder<N>::search (uint16_t reading) const
+{
+    uint8_t lo = 0;
+    uint8_t hi = N;
+    uint8_t mid;
+    // the first threshold above the reading
+    while (lo < hi) {
+        mid = (lo + hi) >> 1;
+        if (pgm_read_word_near (&(this->thresholds[mid])) <= reading) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+template <uint8_t N>
+uint8_t
+AnalogButtonLadder<N>::decode (uint16_t reading)
+{
+    uint8_t b;
+    if (nullptr == this->thresholds) {
+        return ANALOGLADDER_NONE;
+    }
+    b = this->search (reading);
+    if ((b != this->band) && (this->hysteresis > 0)) {
+        // change the band only if the reading is away from the thresholds
+        if ((this->search ((reading > this->hysteresis) ? (reading - this->hysteresis) : 0) == b)
+            && (this->search (reading + this->hysteresis) == b)) {
+            this->band = b;
+        }
+    } else {
+        this->band = b;
+    }
+    return this->band_to_button (this->band);
+}
+
+template <uint8_t N>
+bool
+AnalogButtonLadder<N>::update_reading (uint16_t reading, unsigned long now)
+{
+    uint8_t b = this->decode (reading);
+    mask_t pressed = 0;
+    if (ANALOGLADDER_NONE != b) {
+        pressed = ((mask_t)1) << b;
+    }
+    return this->update_bits (pressed, now);
+}
+
+#endif // _ANALOG_LADDER_H
@@ -0,0 +1,252 @@
+/**
+ * @file    basicbutton.h
+ * @brief   The Button with the timeouts, the multiple clicks and the callbacks fixed at compile time by a policy
+ * @author  Yunhui Fu (yhfudev@gmail.com)
+ * @version 1.0
+ * @date    2016-07-14
+ * @copyright GPL
+ */
+/**
+ * Usage:
+ *   The Button reads the timeouts from the global BUTSW_TIMEOUT_xxx by buttonfsm_timeout(),
+ *   checks multiple_click at run time, and keeps the five callbacks even if only on_click() is used.
+ *   The BasicButton<Policy> takes them from the policy at compile time:
+ *     1) the timeouts are constants, and only the deadline of the running timer is kept in RAM,
+ *     2) the multiple clicks are enabled or disabled for all of the buttons of the policy,
+ *     3) only the callbacks in Policy::events are stored and called, the others take no RAM,
+ *        setting a disabled callback fails to compile,
+ *     4) without BUTSW_CB_VLONG the very long press timer is not started, and the presses longer
+ *        than timeout_vlong are reported as the long press.
+ *   The state machine is the same as the Button (buttonfsm_step()), so the events are the same
+ *   with the same timeouts. The BasicButton polls the pin and its timer in update(), the TimerInt,
+ *   the Scheduler and the PinEdges are only supported by the Button.
+ *   Define a policy by deriving ButtonPolicy and hiding the members to be changed.
+ *
+ *   Example:
+ *     // the power button: only the click and the long press, slower long press
+ *     struct PowerButtonPolicy : public ButtonPolicy {
+ *         static const uint16_t timeout_long = 2000;
+ *         static const uint8_t events = BUTSW_CB_CLICK | BUTSW_CB_LONG;
+ *     };
+ *     // the menu button: the double clicks
+ *     struct MenuButtonPolicy : public ButtonPolicy {
+ *         static const bool multiple_click = true;
+ *         static const uint8_t events = BUTSW_CB_CLICK;
+ *     };
+ *     BasicButton<PowerButtonPolicy> butt_power;
+ *     BasicButton<MenuButtonPolicy> butt_menu;
+ *     void power_on_long(void) { ... }
+ *     void menu_on_click(unsigned int times) { ... }
+ *     void setup(void) {
+ *         pinMode (2, INPUT_PULLUP);
+ *         pinMode (3, INPUT_PULLUP);
+ *         butt_power.set_pin (2, LOW);
+ *         butt_power.on_long_press (Delegate<void()>::from_function<power_on_long>());
+ *         butt_menu.set_pin (3, LOW);
+ *         butt_menu.on_click (Delegate<void(unsigned int)>::from_function<menu_on_click>());
+ *     }
+ *     void loop(void) {
+ *         unsigned long now = millis();
+ *         butt_power.update (now);
+ *         butt_menu.update (now);
+ *     }
+ */
+
+#ifndef _BASIC_BUTTON_H
+#define _BASIC_BUTTON_H 1
+
+#include "sysport.h"
+#include "tick.h"
+#include "delegate.h"
+#include "buttonfsm.h"
+
+// the default policy, same as the Button
+struct ButtonPolicy {
+    // the timeouts(ms)
+    static const uint16_t timeout_debounce = BUTSW_TIMEOUT_DBOUNCE;
+    static const uint16_t timeout_long = BUTSW_TIMEOUT_LONG;
+    static const uint16_t timeout_vlong = BUTSW_TIMEOUT_VLONG;
+    static const uint16_t timeout_2click = BUTSW_TIMEOUT_2CLICK;
+    // signal the multiple clicks as one event
+    static const bool multiple_click = false;
+    // the callbacks, BUTSW_CB_xxx
+    static const uint8_t events = BUTSW_CB_START | BUTSW_CB_END | BUTSW_CB_CLICK | BUTSW_CB_LONG | BUTSW_CB_VLONG;
+};
+
+// the callback CB of the BasicButton, empty if it's not enabled
+template <uint8_t CB, bool ENABLED, typename... Args>
+class BasicButtonSlot {
+public:
+    inline void set (const Delegate<void(Args...)> & dg1) { this->dg = dg1; }
+    inline void call (Args... args) {
+        if (this->dg.is_set()) {
+            this->dg (args...);
+        }
+    }
+private:
+    Delegate<void(Args...)> dg;
+};
+
+template <uint8_t CB, typename... Args>
+class BasicButtonSlot<CB, false, Args...> {
+public:
+    inline void call (Args...) {}
+};
+
+template <class Policy = ButtonPolicy>
+class BasicButton
+    : private BasicButtonSlot<BUTSW_CB_START, ((Policy::events & BUTSW_CB_START) != 0)>
+    , private BasicButtonSlot<BUTSW_CB_END, ((Policy::events & BUTSW_CB_END) != 0)>
+    , private BasicButtonSlot<BUTSW_CB_CLICK, ((Policy::events & BUTSW_CB_CLICK) != 0), unsigned int>
+    , private BasicButtonSlot<BUTSW_CB_LONG, ((Policy::events & BUTSW_CB_LONG) != 0)>
+    , private BasicButtonSlot<BUTSW_CB_VLONG, ((Policy::events & BUTSW_CB_VLONG) != 0)>
+{
+    typedef BasicButtonSlot<BUTSW_CB_START, ((Policy::events & BUTSW_CB_START) != 0)> slot_start_t;
+    typedef BasicButtonSlot<BUTSW_CB_END, ((Policy::events & BUTSW_CB_END) != 0)> slot_end_t;
+    typedef BasicButtonSlot<BUTSW_CB_CLICK, ((Policy::events & BUTSW_CB_CLICK) != 0), unsigned int> slot_click_t;
+    typedef BasicButtonSlot<BUTSW_CB_LONG, ((Policy::events & BUTSW_CB_LONG) != 0)> slot_long_t;
+    typedef BasicButtonSlot<BUTSW_CB_VLONG, ((Policy::events & BUTSW_CB_VLONG) != 0)> slot_vlong_t;
+
+public:
+    static_assert ((Policy::timeout_debounce > 0) && (Policy::timeout_debounce <= TICK_MAX_SPAN)
+        && (Policy::timeout_long > 0) && (Policy::timeout_long <= TICK_MAX_SPAN)
+        && (Policy::timeout_vlong > 0) && (Policy::timeout_vlong <= TICK_MAX_SPAN)
+        && (Policy::timeout_2click > 0) && (Policy::timeout_2click <= TICK_MAX_SPAN), "BasicButton: the timeouts should be 1 to TICK_MAX_SPAN ms");
+
+    BasicButton () : pin(0), flags(0), state(BUTSW_STATE_READY), clicks(0), deadline(0) {}
+
+    // pressed_state: the state of the input when the button pressed, HIGH or LOW
+    inline void set_pin (uint8_t digital_pin, uint8_t pressed_state = LOW) {
+        this->pin = digital_pin;
+        if (pressed_state) {
+            this->flags &= ~FLAG_RELEASED_HIGH;
+        } else {
+            this->flags |= FLAG_RELEASED_HIGH;
+        }
+    }
+    inline uint8_t get_pin (void) const { return this->pin; }
+
+    // only the callbacks enabled in Policy::events can be set
+    inline void on_click (const Delegate<void(unsigned int)> & dg) {
+        static_assert ((Policy::events & BUTSW_CB_CLICK) != 0, "BasicButton: BUTSW_CB_CLICK is not in Policy::events");
+        this->slot_click_t::set (dg);
+    }
+    inline void on_start (const Delegate<void()> & dg) {
+        static_assert ((Policy::events & BUTSW_CB_START) != 0, "BasicButton: BUTSW_CB_START is not in Policy::events");
+        this->slot_start_t::set (dg);
+    }
+    inline void on_end (const Delegate<void()> & dg) {
+        static_assert ((Policy::events & BUTSW_CB_END) != 0, "BasicButton: BUTSW_CB_END is not in Policy::events");
+        this->slot_end_t::set (dg);
+    }
+    inline void on_long_press (const Delegate<void()> & dg) {
+        static_assert ((Policy::events & BUTSW_CB_LONG) != 0, "BasicButton: BUTSW_CB_LONG is not in Policy::events");
+        this->slot_long_t::set (dg);
+    }
+    inline void on_vlong_press (const Delegate<void()> & dg) {
+        static_assert ((Policy::events & BUTSW_CB_VLONG) != 0, "BasicButton: BUTSW_CB_VLONG is not in Policy::events");
+        this->slot_vlong_t::set (dg);
+    }
+
+    // read the pin and check the timer, return true if the button is busy
+    inline bool update (void) { return this->update (millis()); }
+    inline bool update (unsigned long now) { return this->update_pin (digitalRead (this->pin), now); }
+    // same as above, with the state of the pin read by the caller
+    bool update_pin (uint8_t pin_state, unsigned long now);
+    // the time(millis) of the next timeout, return false if nothing to wait
+    inline bool next_deadline (unsigned long & deadline1) {
+        if (! (this->flags & FLAG_TIMER)) {
+            return false;
+        }
+        deadline1 = tick_to_ms (this->deadline, millis());
+        return true;
+    }
+
+    inline uint8_t get_state (void) const { return this->state; }
+    inline bool is_hold (void) const { return (this->flags & FLAG_HOLD) != 0; }
+
+private:
+    static const uint8_t FLAG_HOLD = 0x01;          // the button pressed and hold
+    static const uint8_t FLAG_TIMER = 0x02;         // the timer is started
+    static const uint8_t FLAG_RELEASED_HIGH = 0x04; // the input is HIGH when the button released
+
+    // the time(ms) of the timer action, constant folded
+    static inline uint16_t timeout (uint8_t timer) {
+        switch (timer) {
+        case BUTSW_TIMER_DBOUNCE:
+            return Policy::timeout_debounce;
+        case BUTSW_TIMER_LONG:
+            return Policy::timeout_long;
+        case BUTSW_TIMER_VLONG:
+            return Policy::timeout_vlong;
+        }
+        return Policy::timeout_2click;
+    }
+    void process_event (uint8_t event, tick_t now);
+
+    uint8_t pin;
+    uint8_t flags;  // FLAG_xxx
+    uint8_t state;  // BUTSW_STATE_xxx
+    uint8_t clicks; // the adjacent clicks
+    tick_t deadline; // the time of the timeout if FLAG_TIMER is set
+};
+
+template <class Policy>
+void
+BasicButton<Policy>::process_event (uint8_t event, tick_t now)
+{
+    struct Sink {
+        BasicButton & b;
+        inline void timer_start (uint8_t timer, tick_t now1) {
+            if ((BUTSW_TIMER_VLONG == timer) && (! (Policy::events & BUTSW_CB_VLONG))) {
+                // nobody waits for the very long press, stay in LONGPRESS until released
+                this->timer_cancel ();
+                return;
+            }
+            this->b.deadline = now1 + BasicButton::timeout (timer);
+            this->b.flags |= FLAG_TIMER;
+        }
+        inline void timer_cancel (void) { this->b.flags &= ~FLAG_TIMER; }
+        // the disabled callbacks are removed by the compiler
+        inline void event (uint8_t type, unsigned int times) {
+            switch (type) {
+            case BUTEV_START: this->b.slot_start_t::call (); break;
+            case BUTEV_END:   this->b.slot_end_t::call (); break;
+            case BUTEV_CLICK: this->b.slot_click_t::call (times); break;
+            case BUTEV_LONG:  this->b.slot_long_t::call (); break;
+            case BUTEV_VLONG: this->b.slot_vlong_t::call (); break;
+            }
+        }
+    } sink = { *this };
+    buttonfsm_t fsm;
+    fsm.state = this->state;
+    fsm.hold = ((this->flags & FLAG_HOLD) ? 1 : 0);
+    fsm.clicks = this->clicks;
+    buttonfsm_run (fsm, event, Policy::multiple_click, false, now, sink);
+    if (fsm.hold) {
+        this->flags |= FLAG_HOLD;
+    } else {
+        this->flags &= ~FLAG_HOLD;
+    }
+    this->clicks = fsm.clicks;
+    this->state = fsm.state;
+}
+
+template <class Policy>
+bool
+BasicButton<Policy>::update_pin (uint8_t pin_state, unsigned long now)
+{
+    tick_t t = tick_from (now);
+    bool pressed = ((pin_state ? 1 : 0) != ((this->flags & FLAG_RELEASED_HIGH) ? 1 : 0));
+    // the pin first, then the timer, same as Button
+    if (pressed != ((this->flags & FLAG_HOLD) != 0)) {
+        this->process_event ((pressed ? BUTSW_EVT_PRESSED : BUTSW_EVT_RELEASED), t);
+    }
+    if ((this->flags & FLAG_TIMER) && tick_reached (t, this->deadline)) {
+        this->flags &= ~FLAG_TIMER;
+        this->process_event (BUTSW_EVT_TIMEOUT, t);
+    }
+    return ((this->flags & FLAG_TIMER) || (BUTSW_STATE_READY != this->state));
+}
+
+#endif // _BASIC_BUTTON_H
@@ -9,6 +9,10 @@
 
 #include "sysport.h"
 #include "button.h"
+#include "timerint.h"
+#include "scheduler.h"
+#include "pinedge.h"
+#include "buttonevent.h"
 
 /**
 TODO:
@@ -89,59 +93,6 @@ https://github.com/PaulStoffregen/TimerThree.git
 //#define TRACE3(...)
 #endif
 
-// internal states
-#define BUTSW_STATE_READY      0
-#define BUTSW_STATE_DEBOUNCE   1
-#define BUTSW_STATE_1CLICK     2
-#define BUTSW_STATE_LONGPRESS  3
-#define BUTSW_STATE_VLONGPRESS 4
-#define BUTSW_STATE_DEBOUNCE2  5
-
-// event types
-#define BUTSW_EVT_NONE          0
-#define BUTSW_EVT_PRESSED       1
-#define BUTSW_EVT_RELEASED      2
-#define BUTSW_EVT_TIMEOUT_DB1   3
-#define BUTSW_EVT_TIMEOUT_DB2   4
-#define BUTSW_EVT_TIMEOUT_CLICK 5
-#define BUTSW_EVT_TIMEOUT_LONG  6
-#define BUTSW_EVT_TIMEOUT_READY 7
-#define BUTSW_EVT_TIMEOUT       8 /* temp */
-
-#if DEBUG
-char * val2cstr_buttsw_state(int val)
-{
-#define CASESTATE(v) case BUTSW_STATE_ ##v: return "STATE_" #v
-    switch (val) {
-        CASESTATE(READY);
-        CASESTATE(DEBOUNCE);
-        CASESTATE(1CLICK);
-        CASESTATE(LONGPRESS);
-        CASESTATE(VLONGPRESS);
-        CASESTATE(DEBOUNCE2);
-    }
-    return "STATE_(unknow)";
-#undef CASESTATE
-}
-char * val2cstr_buttsw_evt(int val)
-{
-#define CASEEVT(v) case BUTSW_EVT_ ##v: return "EVT_" #v
-    switch (val) {
-        CASEEVT(NONE);
-        CASEEVT(TIMEOUT);
-        CASEEVT(PRESSED);
-        CASEEVT(RELEASED);
-    }
-    return "EVT_(unknow)";
-#undef CASEEVT
-}
-#define VAL2CSTR_BUTTSW_STATE(v) val2cstr_buttsw_state(v)
-#define VAL2CSTR_BUTTSW_EVT(v) val2cstr_buttsw_evt(v)
-#else
-#define VAL2CSTR_BUTTSW_STATE(v) "val2cstr_buttsw_state unimplemented"
-#define VAL2CSTR_BUTTSW_EVT(v) "val2cstr_buttsw_evt unimplemented"
-#endif // DEBUG
-
 Button::Button(bool multiple_click1)
 {
     this->pin = 0;
@@ -149,7 +100,23 @@ Button::Button(bool multiple_click1)
     this->button_hold = false;
     this->released_state = HIGH;
     this->clicks = 0;
+    this->db_start = 0;
+    this->db_bounce = 0;
+    this->db_ms = 0;
+    this->db_min = 0;
+    this->db_max = 0;
+    this->db_est = 0;
     this->multiple_click = multiple_click1;
+    this->sched = nullptr;
+    this->sched_id = -1;
+    this->edges = nullptr;
+    this->edge_level = HIGH;
+    this->edge_overflow = 0;
+    this->queue = nullptr;
+    this->queue_id = 0;
+    this->timers = nullptr;
+    this->timer_polled = false;
+    this->timer.poll.timer_len = 0;
 
     this->userdata = nullptr;
     this->OnClick = nullptr;
@@ -159,6 +126,25 @@ Button::Button(bool multiple_click1)
     this->OnEnd = nullptr;
 }
 
+void
+Button::set_user_data (void * userdata1)
+{
+    this->userdata = userdata1;
+}
+
+void
+Button::bind_obj (void * obj)
+{
+    if (nullptr == obj) {
+        // the free function
+        return;
+    }
+    if (this->userdata && (this->userdata != obj)) {
+        TRACE2 ("Button: the callbacks of pin %d are bound to another object", this->pin);
+    }
+    this->userdata = obj;
+}
+
 bool
 Button::is_pressed(uint8_t cur_state)
 {
@@ -192,42 +178,217 @@ Button::set_pin (uint8_t digital_pin)
     }
 }
 
+void
+Button::set_timer (TimerInt * timers1)
+{
+    this->cancle_timer();
+    this->timers = timers1;
+    this->timer_polled = false;
+    if (this->timers) {
+        this->timer.id = -1;
+    } else {
+        this->timer.poll.timer_len = 0;
+    }
+}
+
+void
+Button::set_scheduler (Scheduler * sched1, bool by_interrupt)
+{
+    this->register_task (sched1, this, by_interrupt);
+}
+
+void
+Button::on_pin_change (void)
+{
+    if (this->sched) {
+        this->sched->activate_isr (this->sched_id);
+    }
+}
+
+int
+Button::set_edges (PinEdges * edges1)
+{
+    if (this->edges) {
+        this->edges->detach (this->pin);
+    }
+    this->edges = edges1;
+    if (this->edges) {
+        this->edge_level = digitalRead (this->pin);
+        this->edge_overflow = this->edges->get_overflow();
+        if (this->edges->attach (this->pin, Delegate<void(uint8_t, unsigned long)>::from_method<Button, &Button::on_edge>(this)) < 0) {
+            this->edges = nullptr;
+            return -1;
+        }
+    }
+    return 0;
+}
+
+void
+Button::on_edge (uint8_t level, unsigned long time_ms)
+{
+    // the timeouts before the edge go first
+    this->update_timeouts (tick_from (time_ms));
+    this->edge_level = level;
+    this->update_pin (level, time_ms);
+    if (this->sched) {
+        this->sched->activate (this->sched_id);
+    }
+}
+
+void
+Button::set_queue (ButtonEventQueue * queue1, uint8_t id)
+{
+    this->queue = queue1;
+    this->queue_id = id;
+}
+
+void
+Button::set_debounce (uint8_t min_ms, uint8_t max_ms)
+{
+    if ((max_ms < 1) || (min_ms > max_ms)) {
+        // fixed
+        this->db_min = this->db_max = 0;
+        this->db_ms = 0;
+        return;
+    }
+    this->db_min = min_ms;
+    this->db_max = max_ms;
+    // start from the upper bound, shrink by the bounces seen
+    this->db_ms = max_ms;
+    this->db_est = (uint16_t)max_ms << 3;
+}
+
+// the debounce window ended, learn from the bounce time seen in it:
+// grow at once to avoid the false clicks, shrink slowly (1/8 of the difference each time)
+void
+Button::learn_bounce (void)
+{
+    uint16_t sample = (uint16_t)this->db_bounce << 3;
+    uint16_t win;
+    if (this->db_bounce + 1 >= this->db_ms) {
+        // still bouncing at the end of the window, the bounce time is unknown
+        sample = ((uint16_t)this->db_ms << 3) + ((uint16_t)this->db_ms << 2);
+    }
+    if (sample > this->db_est) {
+        this->db_est = sample;
+    } else {
+        this->db_est -= (this->db_est - sample) >> 3;
+    }
+    win = (this->db_est >> 3) + BUTSW_DEBOUNCE_MARGIN;
+    if (win < this->db_min) {
+        win = this->db_min;
+    }
+    if (win > this->db_max) {
+        win = this->db_max;
+    }
+    TRACE0 ("Button: bounce %d ms, debounce %d -> %d ms", this->db_bounce, this->db_ms, win);
+    this->db_ms = win;
+}
+
+// the timeout armed on the timers
+void
+Button::cb_timeout (void * userdata)
+{
+    Button * pbutt = (Button *)userdata;
+    // the state machine may start a new timer
+    pbutt->timer.id = -1;
+    TRACE0 ("Button: Time out!");
+    Button::Event ev(BUTSW_EVT_TIMEOUT);
+    pbutt->process_event (ev, tick_from (pbutt->timers->get_time()));
+    if (pbutt->edges) {
+        // the level ignored by the state machine before the timeout, such as a press in DEBOUNCE2
+        pbutt->update_pin (pbutt->edge_level, pbutt->timers->get_time());
+    }
+}
+
 // start a timer with timeout time_ms
 // when timeout, push a Event to the state machine
-// the timer is simulated by calling Button::update() in the main loop()
+// the timer is simulated by calling Button::update() in the main loop(), or armed on the timers if set
 void
-Button::start_timer (int time_ms)
+Button::start_timer (tick_t time_ms, tick_t now)
 {
-    this->timer_prev = millis();
-    this->timer_len  = time_ms;
-    this->timer_accu = 0;
+    if (this->by_timers()) {
+        if ((this->timer.id >= 0) && (this->timers->restart (this->timer.id, time_ms) < 0)) {
+            // fired and queued by the ISR, cancel it, or its cb_timeout() would drop the new timer
+            this->timers->cancel (this->timer.id);
+            this->timer.id = -1;
+        }
+        if (this->timer.id < 0) {
+            this->timer.id = this->timers->start (time_ms, this, Button::cb_timeout);
+        }
+        if (this->timer.id >= 0) {
+            return;
+        }
+        // no free timer, poll the timeout in update() until it ends
+        TRACE2 ("Button: no free timer, polled by update()");
+        this->timer_polled = true;
+        now = tick_from (millis());
+    }
+    this->timer.poll.timer_start = now;
+    this->timer.poll.timer_len = time_ms;
+}
+
+// the polled timer ended, the next one is armed on the timers again if set
+void
+Button::stop_poll_timer ()
+{
+    this->timer.poll.timer_len = 0;
+    if (this->timer_polled) {
+        this->timer_polled = false;
+        this->timer.id = -1;
+    }
 }
 
 void
 Button::cancle_timer ()
 {
-    this->timer_len = 0;
+    if (this->by_timers()) {
+        if (this->timer.id >= 0) {
+            this->timers->cancel (this->timer.id);
+            this->timer.id = -1;
+        }
+        return;
+    }
+    this->stop_poll_timer();
+}
+
+bool
+Button::is_timer_active ()
+{
+    if (this->by_timers()) {
+        return (this->timer.id >= 0);
+    }
+    return (this->timer.poll.timer_len > 0);
+}
+
+bool
+Button::next_deadline (unsigned long & deadline)
+{
+    if (this->by_timers()) {
+        // checked by the timers
+        return false;
+    }
+    if (this->timer.poll.timer_len < 1) {
+        return false;
+    }
+    deadline = tick_to_ms (this->timer.poll.timer_start + this->timer.poll.timer_len, millis());
+    return true;
 }
 
 // check the time and return 1 if expired, -1 on error, 0 on normal
 int
-Button::update_timer ()
+Button::update_timer (tick_t now)
 {
-    if (this->timer_len < 1) {
+    if (this->by_timers()) {
+        // checked by the timers
         return -1;
     }
-    unsigned long now = millis();
-    unsigned long val = now;
-    if (this->timer_prev <= now) {
-        val = now - this->timer_prev;
-    } else {
-        TRACE3 ("millis() rollback!");
-        val = now + 10000 - this->timer_prev;
+    if (this->timer.poll.timer_len < 1) {
+        return -1;
     }
-    this->timer_accu += val;
-    this->timer_prev = now;
-    if (this->timer_accu >= this->timer_len) {
-        this->timer_len = 0;
+    // the ticks wrap around, only the elapsed time is compared
+    if (tick_elapsed (now, this->timer.poll.timer_start) >= this->timer.poll.timer_len) {
+        this->stop_poll_timer();
         return 1;
     }
     return 0;
@@ -248,14 +409,6 @@ Button::get_key_type (void)
         }
         break;
 
-        if (this->clicks > 1) {
-            return BUTSW_TYPE_2CLICK;
-        }
-        if (this->clicks > 0) {
-            return BUTSW_TYPE_1CLICK;
-        }
-        break;
-
     case BUTSW_STATE_1CLICK:
         if (this->clicks > 0) {
             return BUTSW_TYPE_2CLICK;
@@ -276,202 +429,80 @@ Button::get_key_type (void)
 }
 
 uint8_t
-Button::process_event (Button::Event &ev)
+Button::process_event (Button::Event &ev, tick_t now)
 {
-    uint8_t next_state = this->current_state;
-    TRACE1 ("Button: %s on %s", VAL2CSTR_BUTTSW_STATE(this->current_state), VAL2CSTR_BUTTSW_EVT(ev.get_type()));
-    switch (this->current_state) {
-    case BUTSW_STATE_READY:
-        switch (ev.get_type()) {
-        case BUTSW_EVT_TIMEOUT:
-            // check the current button status
-            if (this->clicks > 0) {
-                TRACE1 ("Button: CB end");
-                if (this->OnEnd) {
-                    this->OnEnd (this->userdata);
-                }
-                TRACE1 ("Button: CB 1click");
-                if (this->OnClick) {
-                    this->OnClick (this->userdata, this->clicks);
-                }
-                this->clicks = 0;
+    struct Sink {
+        Button & b;
+        tick_t now;
+        inline void timer_start (uint8_t timer, tick_t now1) {
+            if (BUTSW_TIMER_DBOUNCE == timer) {
+                this->b.db_start = now1;
+                this->b.db_bounce = 0;
+                // the fixed timeout may not fit in db_ms
+                this->b.start_timer ((this->b.db_max ? this->b.db_ms : buttonfsm_timeout (timer)), now1);
+                return;
             }
-            break;
-        case BUTSW_EVT_PRESSED:
-            this->button_hold = true;
-            next_state = BUTSW_STATE_DEBOUNCE;
-            start_timer (get_timeout_dbounce());
-            break;
-        default:
-            TRACE3 ("Button: Unhandled : %s", VAL2CSTR_BUTTSW_EVT(ev.get_type()));
-            break;
+            this->b.start_timer (buttonfsm_timeout (timer), now1);
         }
-        break;
-
-    case BUTSW_STATE_DEBOUNCE:
-        switch (ev.get_type()) {
-        case BUTSW_EVT_TIMEOUT:
-            // check the current button status
-            if (this->button_hold) {
-                start_timer (get_timeout_long());
-                next_state = BUTSW_STATE_1CLICK;
-                TRACE1 ("Button: CB start");
-                if (this->OnStart) {
-                    this->OnStart (this->userdata);
-                }
-            } else {
-                next_state = BUTSW_STATE_READY;
+        inline void timer_cancel (void) { this->b.cancle_timer(); }
+        inline void event (uint8_t type, unsigned int times) {
+            TRACE1 ("Button: CB %d, times %d", type, times);
+            if (this->b.queue) {
+                this->b.queue->push (this->b.queue_id, type, times, this->now);
+                return;
             }
-            break;
-        case BUTSW_EVT_PRESSED:
-            this->button_hold = true;
-            break;
-        case BUTSW_EVT_RELEASED:
-            this->button_hold = false;
-            break;
-        default:
-            TRACE3 ("Button: Unhandled : %s", VAL2CSTR_BUTTSW_EVT(ev.get_type()));
-            break;
-        }
-        break;
-
-    case BUTSW_STATE_1CLICK:
-        switch (ev.get_type()) {
-        case BUTSW_EVT_TIMEOUT:
-            // check the current button status
-            if (this->button_hold) {
-                start_timer (get_timeout_vlong());
-                this->clicks = 0;
-                next_state = BUTSW_STATE_LONGPRESS;
+            switch (type) {
+            case BUTEV_START:
+                if (this->b.OnStart) {
+                    this->b.OnStart (this->b.userdata);
+                }
                 break;
-            } else {
-                // not possible state
-                TRACE1 ("Button: not possible in 1click with button released");
-            }
-        case BUTSW_EVT_RELEASED:
-            this->button_hold = false;
-            cancle_timer();
-            if (this->multiple_click) {
-                this->clicks ++;
-            } else {
-                this->clicks = 0;
-                TRACE1 ("Button: CB onEnd");
-                if (this->OnEnd) {
-                    this->OnEnd (this->userdata);
+            case BUTEV_END:
+                if (this->b.OnEnd) {
+                    this->b.OnEnd (this->b.userdata);
                 }
-                TRACE1 ("Button: CB OnClick");
-                if (this->OnClick) {
-                    this->OnClick (this->userdata, 1);
+                break;
+            case BUTEV_CLICK:
+                if (this->b.OnClick) {
+                    this->b.OnClick (this->b.userdata, times);
                 }
-            }
-            start_timer (get_timeout_dbounce());
-            next_state = BUTSW_STATE_DEBOUNCE2;
-            break;
-        case BUTSW_EVT_PRESSED:
-            this->button_hold = true;
-            break;
-        default:
-            TRACE3 ("Button: Unhandled : %s", VAL2CSTR_BUTTSW_EVT(ev.get_type()));
-            break;
-        }
-        break;
-
-    case BUTSW_STATE_LONGPRESS:
-        switch (ev.get_type()) {
-        case BUTSW_EVT_TIMEOUT:
-            // check the current button status
-            if (this->button_hold) {
-                // callback
-                TRACE1 ("Button: CB vlongpress");
-                if (this->OnVLongPress) {
-                    this->OnVLongPress (this->userdata);
+                break;
+            case BUTEV_LONG:
+                if (this->b.OnLongPress) {
+                    this->b.OnLongPress (this->b.userdata);
                 }
-                //next_state = BUTSW_STATE_VLONGPRESS;
-                start_timer (get_timeout_dbounce());
-                next_state = BUTSW_STATE_DEBOUNCE2;
-            } else {
-                TRACE1 ("Button: not possible in LONG with button released");
-            }
-            break;
-        case BUTSW_EVT_PRESSED:
-            this->button_hold = true;
-            break;
-        case BUTSW_EVT_RELEASED:
-            this->button_hold = false;
-            cancle_timer();
-            this->clicks = 0;
-            // callback
-            TRACE1 ("Button: CB onEnd");
-            if (this->OnEnd) {
-                this->OnEnd (this->userdata);
-            }
-            TRACE1 ("Button: CB longpress");
-            if (this->OnLongPress) {
-                this->OnLongPress (this->userdata);
-            }
-            start_timer (get_timeout_dbounce());
-            next_state = BUTSW_STATE_DEBOUNCE2;
-            break;
-        default:
-            TRACE3 ("Button: Unhandled : %s", VAL2CSTR_BUTTSW_EVT(ev.get_type()));
-            break;
-        }
-        break;
-
-    case BUTSW_STATE_VLONGPRESS:
-        switch (ev.get_type()) {
-        case BUTSW_EVT_PRESSED:
-            this->button_hold = true;
-            break;
-        case BUTSW_EVT_RELEASED:
-            cancle_timer();
-            this->button_hold = false;
-            this->clicks = 0;
-            // callback
-            TRACE1 ("Button: CB onEnd");
-            if (this->OnEnd) {
-                this->OnEnd (this->userdata);
+                break;
+            case BUTEV_VLONG:
+                if (this->b.OnVLongPress) {
+                    this->b.OnVLongPress (this->b.userdata);
+                }
+                break;
             }
-            start_timer (get_timeout_dbounce());
-            next_state = BUTSW_STATE_DEBOUNCE2;
-            break;
-        default:
-            TRACE3 ("Button: Unhandled : %s", VAL2CSTR_BUTTSW_EVT(ev.get_type()));
-            break;
         }
-        break;
-
-    case BUTSW_STATE_DEBOUNCE2:
-        switch (ev.get_type()) {
-        case BUTSW_EVT_TIMEOUT:
-            this->button_hold = false;
-            cancle_timer();
-            if (this->multiple_click && this->clicks > 0) {
-                start_timer (get_timeout_2click());
-            }
-            next_state = BUTSW_STATE_READY;
-            break;
-        case BUTSW_EVT_PRESSED:
-            //this->button_hold = true;
-            break;
-        case BUTSW_EVT_RELEASED:
-            //this->button_hold = false;
-            break;
-        default:
-            TRACE3 ("Button: Unhandled : %s", VAL2CSTR_BUTTSW_EVT(ev.get_type()));
-            break;
+    } sink = { *this, now };
+    buttonfsm_t fsm;
+    TRACE1 ("Button: %s on %s", VAL2CSTR_BUTTSW_STATE(this->current_state), VAL2CSTR_BUTTSW_EVT(ev.get_type()));
+    fsm.state = this->current_state;
+    fsm.hold = this->button_hold;
+    fsm.clicks = this->clicks;
+    if (this->db_max && ((BUTSW_STATE_DEBOUNCE == this->current_state) || (BUTSW_STATE_DEBOUNCE2 == this->current_state))) {
+        if (BUTSW_EVT_TIMEOUT == ev.get_type()) {
+            this->learn_bounce();
+        } else {
+            // the bounce
+            tick_t t = tick_elapsed (now, this->db_start);
+            this->db_bounce = ((t > 0xFF) ? 0xFF : t);
         }
-        break;
-    default:
-        TRACE3 ("Error: unknown state: %s", VAL2CSTR_BUTTSW_STATE(this->current_state));
-        break;
     }
-    this->current_state = next_state;
-    return next_state;
+    buttonfsm_run (fsm, ev.get_type(), this->multiple_click, false, now, sink);
+    this->button_hold = fsm.hold;
+    this->clicks = fsm.clicks;
+    this->current_state = fsm.state;
+    return fsm.state;
 }
 
 void
-Button::update_pin (uint8_t pin_state)
+Button::update_pin (uint8_t pin_state, unsigned long now)
 {
     //TRACE1 ("update_pin(%d) ...", pin_state);
 
@@ -481,28 +512,73 @@ Button::update_pin (uint8_t pin_state)
         if (this->button_hold) {
             ev.set_type (BUTSW_EVT_RELEASED);
         }
-        this->process_event (ev);
+        this->process_event (ev, tick_from (now));
     }
 }
 
 void
-Button::update_other ()
+Button::update_pin (uint8_t pin_state)
+{
+    unsigned long now = 0;
+    // the time is only used by the timers polled in update(), the events of the queue and the bounces
+    if (((! this->by_timers()) || this->queue || this->db_max) && (this->button_hold != is_pressed(pin_state))) {
+        now = millis();
+    }
+    this->update_pin (pin_state, now);
+}
+
+void
+Button::update_other (tick_t now)
 {
     // check the timer
-    if (1 == this->update_timer()) {
+    if (1 == this->update_timer(now)) {
         TRACE0 ("Button: Time out!");
         Button::Event ev(BUTSW_EVT_TIMEOUT);
-        this->process_event (ev);
+        this->process_event (ev, now);
     }
 }
 
+// the polled timeouts up to now, each one is processed at its deadline instead of the time of the poll,
+// so the timer started by it is not delayed by a slow loop()
+void
+Button::update_timeouts (tick_t now)
+{
+    tick_t deadline;
+    while ((! this->by_timers()) && (this->timer.poll.timer_len > 0)) {
+        deadline = this->timer.poll.timer_start + this->timer.poll.timer_len;
+        if (! tick_reached (now, deadline)) {
+            break;
+        }
+        this->stop_poll_timer();
+        TRACE0 ("Button: Time out!");
+        Button::Event ev(BUTSW_EVT_TIMEOUT);
+        this->process_event (ev, deadline);
+        if (this->edges) {
+            // no more edge to report the level ignored before the timeout, such as a press in DEBOUNCE2
+            this->update_pin (this->edge_level, deadline);
+        }
+    }
+}
+
+// the edges were dropped by the full ring of the edges, read the level of the pin again
+void
+Button::resync_edges (unsigned long now)
+{
+    this->edge_overflow = this->edges->get_overflow();
+    this->edge_level = digitalRead (this->pin);
+    TRACE2 ("Button: edges dropped, pin %d read again: %d", this->pin, this->edge_level);
+    this->update_pin (this->edge_level, now);
+}
+
 bool
-Button::update ()
+Button::update_state (uint8_t pin_state, tick_t now)
 {
     bool ret = false;
-    update_pin (digitalRead(this->pin));
-    update_other ();
-    if (this->timer_len > 0) {
+    update_pin (pin_state, now);
+    if (! this->by_timers()) {
+        update_other (now);
+    }
+    if (this->is_timer_active()) {
         ret = true;
     }
     if (this->current_state != BUTSW_STATE_READY) {
@@ -511,3 +587,41 @@ Button::update ()
     return ret;
 }
 
+bool
+Button::update (unsigned long now)
+{
+    if (this->edges) {
+        // the pin changes are passed by on_edge()
+        this->update_timeouts (tick_from (now));
+        if (this->edges->get_overflow() != this->edge_overflow) {
+            this->resync_edges (now);
+        }
+        return (this->is_timer_active() || (this->current_state != BUTSW_STATE_READY));
+    }
+    return this->update_state (digitalRead(this->pin), tick_from (now));
+}
+
+bool
+Button::update ()
+{
+    if (this->edges) {
+        unsigned long now = 0;
+        if (((! this->by_timers()) && this->is_timer_active()) || (this->edges->get_overflow() != this->edge_overflow)) {
+            now = millis();
+        }
+        return this->update (now);
+    }
+    return this->update_read (digitalRead(this->pin));
+}
+
+bool
+Button::update_read (uint8_t pin_state)
+{
+    unsigned long now = 0;
+    // millis() is only needed by the polled timer, or the pin changed
+    if (((! this->by_timers()) && this->is_timer_active())
+        || (((! this->by_timers()) || this->queue || this->db_max) && (this->button_hold != is_pressed(pin_state)))) {
+        now = millis();
+    }
+    return this->update_state (pin_state, tick_from (now));
+}
@@ -49,24 +49,79 @@
  *     void loop(void) {
  *         butt.update();
  *     }
+ *
+ *   The callbacks can also be the member functions, the functors or the free functions
+ *   without the userdata, see delegate.h. All of the callbacks of a button share one object,
+ *   only the stub of each callback is kept:
+ *     class Panel {
+ *     public:
+ *         void on_click(unsigned int times);
+ *     };
+ *     Panel panel;
+ *     butt.on_click (Delegate<void(unsigned int)>::from_method<Panel, &Panel::on_click>(&panel));
+ *
+ *   The timeouts of the debounce, long press and double clicks are checked by millis()
+ *   in each update() by default. To avoid the polling, set a shared TimerInt,
+ *   the timeouts are armed on it and the state machine is only woken when a timeout
+ *   expires (by TimerInt::expire()) or the pin changes (by update() or update_pin()):
+ *     TimerInt timers;
+ *     void setup(void) {
+ *         ...
+ *         butt.set_timer (&timers);
+ *     }
+ *     void loop(void) {
+ *         timers.expire();
+ *         butt.update(); // only read the pin
+ *     }
+ *
+ *   The pin is read in each update() by default, the changes between two update() are lost.
+ *   To catch all of the changes with their times, attach the pin to the PinEdges (see pinedge.h),
+ *   then update() doesn't read the pin, the debounce and the long press are timed by the edges:
+ *     PinEdges edges;
+ *     void setup(void) {
+ *         ...
+ *         butt.set_edges (&edges);
+ *         edges.attach_hw();
+ *     }
+ *     void loop(void) {
+ *         edges.dispatch();
+ *         butt.update(); // only check the timeouts
+ *     }
+ *
+ *   The callbacks are called in update(). To keep the slow handlers out of update(), set a queue,
+ *   the events are pushed to the queue instead of calling the callbacks, and popped by the
+ *   application later (see buttonevent.h):
+ *     ButtonEventQueue g_events;
+ *     void setup(void) {
+ *         ...
+ *         butt.set_queue (&g_events, 1); // the id of the button in the events
+ *     }
+ *     void loop(void) {
+ *         buttonevent_t ev;
+ *         butt.update();
+ *         while (g_events.pop (ev)) {
+ *             // process ev
+ *         }
+ *     }
+ *
+ *   The debounce window is BUTSW_TIMEOUT_DBOUNCE for all of the switches by default. To shorten the
+ *   latency of the good switches without the false clicks of the worn ones, let the button learn the
+ *   bounce time (from the first edge to the last edge) of its switch and fit the window in the bounds:
+ *     butt.set_debounce (5, 60); // between 5 ms and 60 ms
+ *     ... butt.get_debounce() ... // the current window
+ *
+ *   The buttons whose timeouts and callbacks are fixed at compile time take less RAM as
+ *   BasicButton<Policy>, see basicbutton.h.
  */
 
 #ifndef _BUTTON_SW_PUSH_H
 #define _BUTTON_SW_PUSH_H 1
 
-#ifndef BUTSW_TIMEOUT_DBOUNCE
-// debounce 30ms
-#define BUTSW_TIMEOUT_DBOUNCE   30
-#endif
-#ifndef BUTSW_TIMEOUT_LONG
-#define BUTSW_TIMEOUT_LONG    1200
-#endif
-#ifndef BUTSW_TIMEOUT_VLONG
-#define BUTSW_TIMEOUT_VLONG   3000
-#endif
-#ifndef BUTSW_TIMEOUT_2CLICK
-#define BUTSW_TIMEOUT_2CLICK   250 // the time between two clicks to merge
-#endif
+#include "tick.h"
+#include "buttonfsm.h"
+#include "delegate.h"
+#include "fastgpio.h"
+#include "scheduler.h"
 
 // the returned button state types
 #define BUTSW_TYPE_NONE        0
@@ -75,6 +130,15 @@
 #define BUTSW_TYPE_LONGPRESS   3
 #define BUTSW_TYPE_VLONGPRESS  4
 
+// the margin added to the learned bounce time for the debounce window
+#ifndef BUTSW_DEBOUNCE_MARGIN
+#define BUTSW_DEBOUNCE_MARGIN 2
+#endif
+
+class TimerInt;
+class PinEdges;
+class ButtonEventQueue;
+
 class Button {
 public:
     Button (bool multiple_click = false);
@@ -90,57 +154,154 @@ public:
 
     inline uint8_t get_pin(void) { return this->pin; }
     void set_pin(uint8_t digital_pin);
-    void set_pin(uint8_t digital_pin, uint8_t preessed_state); // pressed_state: what's the state of the input, HIGH or LOW, when button pressed
+    void set_pin(uint8_t digital_pin, uint8_t pressed_state); // pressed_state: what's the state of the input, HIGH or LOW, when button pressed
+    // arm the timeouts on the timers instead of polling millis(), nullptr to poll
+    void set_timer(TimerInt * timers);
+    // add the button as a task of the scheduler,
+    // by_interrupt: the pin changes are notified by on_pin_change(), otherwise the pin is polled in every run()
+    void set_scheduler(Scheduler * sched, bool by_interrupt = false);
+    // called by the ISR of the pin change if set_scheduler(sched, true)
+    void on_pin_change(void);
+    // get the changes of the pin with their times from the edges instead of reading the pin in update(),
+    // nullptr to read the pin. return -1 on error
+    int set_edges(PinEdges * edges);
+    // called by PinEdges::dispatch(): the pin changed to level at time_ms(millis)
+    void on_edge(uint8_t level, unsigned long time_ms);
+    // push the events with the id to the queue instead of calling the callbacks, nullptr to call the callbacks
+    void set_queue(ButtonEventQueue * queue, uint8_t id = 0);
+    // learn the bounce time of the switch and fit the debounce window in [min_ms, max_ms],
+    // 0 to use the fixed BUTSW_TIMEOUT_DBOUNCE (default)
+    void set_debounce(uint8_t min_ms, uint8_t max_ms);
+    // the current debounce window (ms)
+    inline unsigned int get_debounce(void) { return (this->db_max ? this->db_ms : BUTSW_TIMEOUT_DBOUNCE); }
 
     // Update the LEDs along the blinking
     // Returns TRUE if a blink is still in process
     bool update();
     void update_pin(uint8_t pin_state);
+    // same as above, with the time(millis) sampled once for all of the objects in the loop
+    bool update(unsigned long now);
+    void update_pin(uint8_t pin_state, unsigned long now);
+    // the time(millis) of the next timeout to be checked by update(), return false if nothing to wait
+    // the timeouts armed on the TimerInt are not included, and the pin changes should wake up the MCU by interrupt
+    bool next_deadline(unsigned long & deadline);
 
     uint8_t get_key_type (void); // return the current key type.
 
-    inline void set_user_data (void * userdata1) { this->userdata = userdata1; }
+    // the userdata passed to the C callbacks, before or after they are set
+    void set_user_data (void * userdata1);
     inline void on_click ( void (*function)(void * userdata, unsigned int) ) { this->OnClick = function; }
     inline void on_start ( void (*function)(void * userdata) ) { this->OnStart = function; }
     inline void on_end ( void (*function)(void * userdata) ) { this->OnEnd = function; }
     inline void on_long_press ( void (*function)(void * userdata) ) { this->OnLongPress = function; }
     inline void on_vlong_press ( void (*function)(void * userdata) ) { this->OnVLongPress = function; }
+    // the member functions, the functors or the free functions,
+    // all of the callbacks share one object: the object of the delegate replaces the userdata
+    inline void on_click (const Delegate<void(unsigned int)> & dg) { this->OnClick = dg.get_stub(); this->bind_obj (dg.get_obj()); }
+    inline void on_start (const Delegate<void()> & dg) { this->OnStart = dg.get_stub(); this->bind_obj (dg.get_obj()); }
+    inline void on_end (const Delegate<void()> & dg) { this->OnEnd = dg.get_stub(); this->bind_obj (dg.get_obj()); }
+    inline void on_long_press (const Delegate<void()> & dg) { this->OnLongPress = dg.get_stub(); this->bind_obj (dg.get_obj()); }
+    inline void on_vlong_press (const Delegate<void()> & dg) { this->OnVLongPress = dg.get_stub(); this->bind_obj (dg.get_obj()); }
 
-private:
-    inline unsigned long get_timeout_dbounce() { return BUTSW_TIMEOUT_DBOUNCE; }
-    inline unsigned long get_timeout_long()    { return BUTSW_TIMEOUT_LONG; }
-    inline unsigned long get_timeout_vlong()   { return BUTSW_TIMEOUT_VLONG; }
-    inline unsigned long get_timeout_2click()  { return BUTSW_TIMEOUT_2CLICK; }
+protected:
+    // update with the state of the pin read by the caller, millis() is only read if it's needed
+    bool update_read(uint8_t pin_state);
+    bool update_state(uint8_t pin_state, tick_t now);
 
-    void update_other();
+    Scheduler * sched;
+    int8_t sched_id;
+    // add obj as a task of sched1, the scheduler calls T::update(now) of obj
+    template <class T> void register_task (Scheduler * sched1, T * obj, bool by_interrupt) {
+        if (this->sched) {
+            this->sched->remove (obj);
+        }
+        this->sched = sched1;
+        this->sched_id = -1;
+        if (this->sched) {
+            this->sched_id = this->sched->add_task (obj, ! by_interrupt);
+        }
+    }
 
-    unsigned long longTime;
-    unsigned long shortTime;
-    unsigned int lastButtonStatus;
+private:
+    void update_other(tick_t now);
+    void update_timeouts(tick_t now);
 
     uint8_t pin;
     bool multiple_click; // if the module signal multiple click as one event
     bool button_hold; // if the button pressed and hold?
-    uint8_t process_event (Button::Event &ev); // process event, return the next state
+    uint8_t process_event (Button::Event &ev, tick_t now); // process event, return the next state
     uint8_t current_state; // the current internal state
 
     uint8_t released_state; // what's the state of the input, HIGH or LOW, when button released
     bool is_pressed (uint8_t cur_state);
-    unsigned int clicks; // the adjacent clicks (in BUTSW_TIMEOUT_2CLICK) 
+    uint8_t clicks; // the adjacent clicks (in BUTSW_TIMEOUT_2CLICK)
 
-    unsigned long timer_prev; // the time last updated
-    unsigned long timer_len;  // the timer length
-    unsigned long timer_accu; // the accumulated time
+    // the adaptive debounce, see set_debounce()
+    void learn_bounce(void);
+    tick_t db_start;   // the time of the first edge of the debounce
+    uint8_t db_bounce; // the time from the first edge to the last edge of the debounce
+    uint8_t db_ms;     // the debounce window if adaptive
+    uint8_t db_min;
+    uint8_t db_max;    // 0 if not adaptive
+    uint16_t db_est;   // the learned bounce time, 1/8 ms
+
+    PinEdges * edges; // the source of the pin changes, nullptr if the pin is read by update()
+    uint8_t edge_level; // the last level from the edges, fed again after the timeouts
+    uint16_t edge_overflow; // the overflow of the edges seen, the pin is read again if it changed
+    void resync_edges(unsigned long now);
+    ButtonEventQueue * queue; // the events are pushed to the queue if set, instead of the callbacks
+    uint8_t queue_id; // the id of the button in the events of the queue
+    TimerInt * timers; // the shared timers, nullptr if polled by update()
+    bool timer_polled; // no free timer in the timers, the current timeout is polled by update()
+    inline bool by_timers (void) { return (this->timers && (! this->timer_polled)); }
+    union {
+        struct {
+            tick_t timer_start; // the time the timer started
+            tick_t timer_len;   // the timer length, 0 if not started
+        } poll;
+        int id; // the id of the timer in timers, -1 if not started
+    } timer;
     void cancle_timer ();
-    int update_timer ();
-    void start_timer (int time_ms);
-
-    void * userdata;
-    void (*OnClick)(void * userdata, unsigned int times);
-    void (*OnLongPress)(void * userdata);
-    void (*OnVLongPress)(void * userdata);
-    void (*OnStart)(void * userdata); // start of press
-    void (*OnEnd)(void * userdata); // release of key
+    void stop_poll_timer ();
+    int update_timer (tick_t now);
+    void start_timer (tick_t time_ms, tick_t now);
+    bool is_timer_active ();
+    static void cb_timeout (void * userdata);
+
+    // the callbacks keep only the stubs, the object is shared, one pointer per callback
+    void bind_obj (void * obj);
+    void * userdata; // the userdata of the C callbacks, or the object of the delegates
+    Delegate<void(unsigned int)>::stub_t OnClick; // the times of the clicks
+    Delegate<void()>::stub_t OnLongPress;
+    Delegate<void()>::stub_t OnVLongPress;
+    Delegate<void()>::stub_t OnStart; // start of press
+    Delegate<void()>::stub_t OnEnd; // release of key
+};
+
+/**
+ * The Button bound to the pin at compile time, the pin is read by the port register
+ *   FastButton<3> butt; // pressed when pin 3 is LOW
+ *   void setup(void) {
+ *       FastPin<3>::mode_input_pullup();
+ *   }
+ *   void loop(void) {
+ *       butt.update();
+ *   }
+ */
+template <uint8_t PIN>
+class FastButton : public Button {
+public:
+    FastButton (uint8_t pressed_state = LOW, bool multiple_click = false) : Button(multiple_click) { Button::set_pin (PIN, pressed_state); }
+
+    inline bool update (void) { return this->update_read (FastPin<PIN>::read()); }
+    inline bool update (unsigned long now) { return this->update_state (FastPin<PIN>::read(), tick_from (now)); }
+    // the scheduler calls the update() above,
+    // it should be called on the FastButton: by a Button pointer the pin is read by digitalRead()
+    inline void set_scheduler (Scheduler * sched1, bool by_interrupt = false) { this->register_task (sched1, this, by_interrupt); }
+
+    // the pin is fixed
+    void set_pin (uint8_t digital_pin) = delete;
+    void set_pin (uint8_t digital_pin, uint8_t pressed_state) = delete;
 };
 
 #endif // _BUTTON_SW_PUSH_H
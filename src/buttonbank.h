@@ -0,0 +1,383 @@
+/**
+ * @file    buttonbank.h
+ * @brief   N buttons in the parallel arrays, the pins are read by ports and only the changed ones are processed
+ * @author  Yunhui Fu (yhfudev@gmail.com)
+ * @version 1.0
+ * @date    2016-07-14
+ * @copyright GPL
+ */
+/**
+ * Usage:
+ *   The N Button objects read N pins and check N timers in each loop.
+ *   The ButtonBank<N> keeps the states of the N (up to 64) buttons in the arrays, and the hold
+ *   and the timer flags in the bit masks. The update():
+ *     1) reads each input port once (on AVR), and gathers the levels of the buttons in a mask,
+ *     2) finds the changed buttons by XOR with the hold mask,
+ *     3) runs the state machine (buttonfsm_step(), same as Button) only for the changed buttons
+ *        and the buttons whose timers expired.
+ *   The callbacks are the same as the Button, with the index of the button.
+ *   The levels can also be sampled by the caller, such as from a shift register, by update_bits().
+ *   With set_debounce_sample(), the levels are debounced by the vertical counters (Debouncer)
+ *   sampled every few ms for all of the buttons, and the state machine skips its debounce timers.
+ *
+ *   Example:
+ *     ButtonBank<4> bank;
+ *     void bank_on_click(uint8_t idx, unsigned int times) {
+ *         TRACE0 ("INFO: button %d pressed %d times", idx, times);
+ *     }
+ *     void setup(void) {
+ *         for (uint8_t i = 0; i < 4; i ++) {
+ *             pinMode (2 + i, INPUT_PULLUP);
+ *             bank.set_pin (i, 2 + i, LOW);
+ *         }
+ *         bank.on_click (Delegate<void(uint8_t, unsigned int)>::from_function<bank_on_click>());
+ *     }
+ *     void loop(void) {
+ *         bank.update();
+ *     }
+ */
+
+#ifndef _BUTTON_BANK_H
+#define _BUTTON_BANK_H 1
+
+#include "sysport.h"
+#include "tick.h"
+#include "delegate.h"
+#include "buttonfsm.h"
+#include "debounce.h"
+
+// the max number of the ports of the pins on AVR
+#ifndef BUTTONBANK_MAX_PORTS
+#define BUTTONBANK_MAX_PORTS 4
+#endif
+
+// the bits of the counters of the Debouncer, debounce time = 2^bits x the sample period
+#ifndef BUTTONBANK_DEBOUNCE_BITS
+#define BUTTONBANK_DEBOUNCE_BITS 2
+#endif
+
+template <bool B, typename T, typename F> struct buttonbank_if { typedef T type; };
+template <typename T, typename F> struct buttonbank_if<false, T, F> { typedef F type; };
+// the smallest unsigned type of N bits
+template <uint8_t N> struct buttonbank_mask {
+    typedef typename buttonbank_if<(N <= 8), uint8_t,
+            typename buttonbank_if<(N <= 16), uint16_t,
+            typename buttonbank_if<(N <= 32), uint32_t, uint64_t>::type>::type>::type type;
+};
+
+// the callbacks with the index of the button, shared by ButtonBank and ButtonMatrix
+class ButtonBankCallbacks {
+public:
+    Delegate<void(uint8_t, unsigned int)> OnClick;
+    Delegate<void(uint8_t)> OnLongPress;
+    Delegate<void(uint8_t)> OnVLongPress;
+    Delegate<void(uint8_t)> OnStart;
+    Delegate<void(uint8_t)> OnEnd;
+
+    // call the callback of the event BUTEV_xxx of the button idx
+    inline void call (uint8_t idx, uint8_t type, unsigned int times) {
+        switch (type) {
+        case BUTEV_START:
+            if (this->OnStart.is_set()) {
+                this->OnStart (idx);
+            }
+            break;
+        case BUTEV_END:
+            if (this->OnEnd.is_set()) {
+                this->OnEnd (idx);
+            }
+            break;
+        case BUTEV_CLICK:
+            if (this->OnClick.is_set()) {
+                this->OnClick (idx, times);
+            }
+            break;
+        case BUTEV_LONG:
+            if (this->OnLongPress.is_set()) {
+                this->OnLongPress (idx);
+            }
+            break;
+        case BUTEV_VLONG:
+            if (this->OnVLongPress.is_set()) {
+                this->OnVLongPress (idx);
+            }
+            break;
+        }
+    }
+};
+
+template <uint8_t N>
+class ButtonBank {
+public:
+    static_assert ((N > 0) && (N <= 64), "ButtonBank: 1 to 64 buttons");
+    typedef typename buttonbank_mask<N>::type mask_t;
+
+    ButtonBank ();
+
+    inline uint8_t size (void) const { return N; }
+    // set the pin of the button idx, pressed_state: the state of the input when the button pressed
+    // return -1 on error
+    int set_pin (uint8_t idx, uint8_t digital_pin, uint8_t pressed_state = LOW);
+    // enable the buttons of the mask without the pins, their levels are only passed by update_bits()
+    inline void set_used (mask_t mask) { this->used |= mask; }
+    // signal the multiple clicks as one event for the button idx
+    inline void set_multiple_click (uint8_t idx, bool multiple_click) {
+        if (multiple_click) {
+            this->multi |= BIT(idx);
+        } else {
+            this->multi &= ~BIT(idx);
+        }
+    }
+
+    // debounce all of the buttons by the vertical counters sampled every sample_ms in update(),
+    // the levels of update_bits() should be debounced by the caller if sample_ms > 0.
+    // 0: debounced by the timers of the state machine (default)
+    inline void set_debounce_sample (uint8_t sample_ms1) { this->sample_ms = sample_ms1; this->debouncer.reset (this->hold); }
+
+    inline void on_click (const Delegate<void(uint8_t, unsigned int)> & dg) { this->cbs.OnClick = dg; }
+    inline void on_start (const Delegate<void(uint8_t)> & dg) { this->cbs.OnStart = dg; }
+    inline void on_end (const Delegate<void(uint8_t)> & dg) { this->cbs.OnEnd = dg; }
+    inline void on_long_press (const Delegate<void(uint8_t)> & dg) { this->cbs.OnLongPress = dg; }
+    inline void on_vlong_press (const Delegate<void(uint8_t)> & dg) { this->cbs.OnVLongPress = dg; }
+
+    // read the pins and update all of the buttons, return true if any button is busy
+    inline bool update (void) { return this->update (millis()); }
+    bool update (unsigned long now);
+    // same as above, with the levels sampled by the caller, bit i is 1 if the button i is pressed
+    bool update_bits (mask_t pressed, unsigned long now);
+    // the time(millis) of the next timeout, return false if nothing to wait
+    bool next_deadline (unsigned long & deadline);
+
+    // the buttons pressed, bit i for the button i
+    inline mask_t get_hold (void) const { return this->hold; }
+    inline uint8_t get_state (uint8_t idx) const { return this->state[idx]; }
+
+private:
+    static inline mask_t BIT (uint8_t idx) { return ((mask_t)1) << idx; }
+    mask_t read_pins (void);
+    void process_event (uint8_t idx, uint8_t event, tick_t now);
+
+    // the states of the buttons
+    uint8_t state[N];
+    uint8_t clicks[N];
+    tick_t deadline[N]; // the time of the timeout if the bit in timer_active is set
+    mask_t hold;         // the button is pressed and hold
+    mask_t timer_active; // the timer of the button is started
+    mask_t busy;         // the button is not in READY state
+    mask_t multi;        // the button signals the multiple clicks as one event
+
+    // the debounce of the inputs if sample_ms > 0
+    Debouncer<mask_t, BUTTONBANK_DEBOUNCE_BITS> debouncer;
+    uint8_t sample_ms;
+    tick_t next_sample;
+
+    // the pins
+    mask_t used;   // the pin of the button is set
+    mask_t invert; // the button is pressed when the pin is LOW
+#if defined(__AVR__)
+    volatile uint8_t * ports[BUTTONBANK_MAX_PORTS]; // the input registers
+    uint8_t num_ports;
+    uint8_t pin_map[N]; // the index of the port << 3 | the bit in the port
+#else
+    uint8_t pins[N];
+#endif
+
+    ButtonBankCallbacks cbs;
+};
+
+template <uint8_t N>
+ButtonBank<N>::ButtonBank ()
+: hold(0)
+, timer_active(0)
+, busy(0)
+, multi(0)
+, sample_ms(0)
+, next_sample(0)
+, used(0)
+, invert(0)
+#if defined(__AVR__)
+, num_ports(0)
+#endif
+{
+    uint8_t i;
+    for (i = 0; i < N; i ++) {
+        this->state[i] = BUTSW_STATE_READY;
+        this->clicks[i] = 0;
+        this->deadline[i] = 0;
+#if defined(__AVR__)
+        this->pin_map[i] = 0;
+#else
+        this->pins[i] = 0;
+#endif
+    }
+}
+
+template <uint8_t N>
+int
+ButtonBank<N>::set_pin (uint8_t idx, uint8_t digital_pin, uint8_t pressed_state)
+{
+    if (idx >= N) {
+        return -1;
+    }
+#if defined(__AVR__)
+    uint8_t p;
+    uint8_t bit;
+    uint8_t bitmask = digitalPinToBitMask (digital_pin);
+    volatile uint8_t * reg = portInputRegister (digitalPinToPort (digital_pin));
+    for (p = 0; p < this->num_ports; p ++) {
+        if (this->ports[p] == reg) {
+            break;
+        }
+    }
+    if (p >= this->num_ports) {
+        if (this->num_ports >= BUTTONBANK_MAX_PORTS) {
+            return -1;
+        }
+        this->ports[this->num_ports ++] = reg;
+    }
+    for (bit = 0; (bit < 7) && (0 == (bitmask & (1 << bit))); bit ++);
+    this->pin_map[idx] = (p << 3) | bit;
+#else
+    this->pins[idx] = digital_pin;
+#endif
+    if (pressed_state == LOW) {
+        this->invert |= BIT(idx);
+    } else {
+        this->invert &= ~BIT(idx);
+    }
+    this->used |= BIT(idx);
+    return 0;
+}
+
+template <uint8_t N>
+typename ButtonBank<N>::mask_t
+ButtonBank<N>::read_pins (void)
+{
+    mask_t raw = 0;
+    uint8_t i;
+#if defined(__AVR__)
+    uint8_t val[BUTTONBANK_MAX_PORTS];
+    // one read for each port
+    for (i = 0; i < this->num_ports; i ++) {
+        val[i] = *(this->ports[i]);
+    }
+    for (i = 0; i < N; i ++) {
+        if (val[this->pin_map[i] >> 3] & (1 << (this->pin_map[i] & 0x07))) {
+            raw |= BIT(i);
+        }
+    }
+#else
+    for (i = 0; i < N; i ++) {
+        if ((this->used & BIT(i)) && digitalRead (this->pins[i])) {
+            raw |= BIT(i);
+        }
+    }
+#endif
+    return (raw ^ this->invert) & this->used;
+}
+
+template <uint8_t N>
+void
+ButtonBank<N>::process_event (uint8_t idx, uint8_t event, tick_t now)
+{
+    struct Sink {
+        ButtonBank & b;
+        uint8_t idx;
+        inline void timer_start (uint8_t timer, tick_t now1) {
+            this->b.deadline[this->idx] = now1 + buttonfsm_timeout (timer);
+            this->b.timer_active |= BIT(this->idx);
+        }
+        inline void timer_cancel (void) { this->b.timer_active &= ~BIT(this->idx); }
+        inline void event (uint8_t type, unsigned int times) {
+            this->b.cbs.call (this->idx, type, times);
+        }
+    } sink = { *this, idx };
+    buttonfsm_t fsm;
+    fsm.state = this->state[idx];
+    fsm.hold = ((this->hold & BIT(idx)) ? 1 : 0);
+    fsm.clicks = this->clicks[idx];
+    buttonfsm_run (fsm, event, (this->multi & BIT(idx)), (this->sample_ms > 0), now, sink);
+    if (fsm.hold) {
+        this->hold |= BIT(idx);
+    } else {
+        this->hold &= ~BIT(idx);
+    }
+    if (BUTSW_STATE_READY == fsm.state) {
+        this->busy &= ~BIT(idx);
+    } else {
+        this->busy |= BIT(idx);
+    }
+    this->clicks[idx] = fsm.clicks;
+    this->state[idx] = fsm.state;
+}
+
+template <uint8_t N>
+bool
+ButtonBank<N>::update (unsigned long now)
+{
+    tick_t t;
+    if (this->sample_ms < 1) {
+        return this->update_bits (this->read_pins(), now);
+    }
+    t = tick_from (now);
+    if (tick_reached (t, this->next_sample)) {
+        this->next_sample = t + this->sample_ms;
+        this->debouncer.update (this->read_pins());
+    }
+    return this->update_bits (this->debouncer.get_state(), now) || (! this->debouncer.is_stable());
+}
+
+template <uint8_t N>
+bool
+ButtonBank<N>::update_bits (mask_t pressed, unsigned long now)
+{
+    uint8_t i;
+    mask_t m;
+    tick_t t = tick_from (now);
+    // the buttons changed, compared with the hold of the state machine, same as Button::update_pin()
+    m = (pressed & this->used) ^ this->hold;
+    for (i = 0; m; i ++, m >>= 1) {
+        if (m & 1) {
+            this->process_event (i, ((pressed & BIT(i)) ? BUTSW_EVT_PRESSED : BUTSW_EVT_RELEASED), t);
+        }
+    }
+    // the timers
+    m = this->timer_active;
+    for (i = 0; m; i ++, m >>= 1) {
+        if ((m & 1) && tick_reached (t, this->deadline[i])) {
+            this->timer_active &= ~BIT(i);
+            this->process_event (i, BUTSW_EVT_TIMEOUT, t);
+        }
+    }
+    return (this->timer_active | this->busy) != 0;
+}
+
+template <uint8_t N>
+bool
+ButtonBank<N>::next_deadline (unsigned long & deadline1)
+{
+    uint8_t i;
+    mask_t m = this->timer_active;
+    bool ret = false;
+    tick_t t = 0;
+    if ((this->sample_ms > 0) && (! this->debouncer.is_stable())) {
+        // the next sample
+        t = this->next_sample;
+        ret = true;
+    }
+    for (i = 0; m; i ++, m >>= 1) {
+        if (! (m & 1)) {
+            continue;
+        }
+        if ((! ret) || tick_before (this->deadline[i], t)) {
+            t = this->deadline[i];
+            ret = true;
+        }
+    }
+    if (ret) {
+        deadline1 = tick_to_ms (t, millis());
+    }
+    return ret;
+}
+
+#endif // _BUTTON_BANK_H
@@ -0,0 +1,116 @@
+/**
+ * @file    buttonevent.h
+ * @brief   The queue of the compact button events, drained by the application instead of the callbacks
+ * @author  Yunhui Fu (yhfudev@gmail.com)
+ * @version 1.0
+ * @date    2016-07-14
+ * @copyright GPL
+ */
+/**
+ * Usage:
+ *   The callbacks of the Button are called in its update(), so a slow callback delays the
+ *   debounce and the timeouts of all of the other objects in the loop().
+ *   With Button::set_queue(), the Button pushes each event as a 4-byte record (the id of the button,
+ *   the type, the clicks and the lower 16 bits of millis() of the event) into the ring of the
+ *   ButtonEventQueue instead of calling the callbacks, and the application pops the events
+ *   later, one by one or in batches. The events are dropped and counted by get_overflow()
+ *   if the ring is full.
+ *   The events should be pushed in one context, such as the loop() (update() and TimerInt::expire()),
+ *   and popped in one context.
+ *
+ *   Example:
+ *     ButtonEventQueue g_events;
+ *     Button butt1;
+ *     Button butt2(true);
+ *     void setup(void) {
+ *         butt1.set_pin (2, LOW);
+ *         butt1.set_queue (&g_events, 1);
+ *         butt2.set_pin (3, LOW);
+ *         butt2.set_queue (&g_events, 2);
+ *     }
+ *     void loop(void) {
+ *         buttonevent_t ev;
+ *         butt1.update();
+ *         butt2.update();
+ *         if (g_events.pop (ev) && (BUTEV_CLICK == ev.type)) {
+ *             // button ev.id clicked ev.times times at ev.time
+ *         }
+ *     }
+ */
+
+#ifndef _BUTTON_EVENT_H
+#define _BUTTON_EVENT_H 1
+
+#include "sysport.h"
+#include "ringbuffer.h"
+
+// the size of the ring of the events, a power of 2
+#ifndef BUTTONEVENT_QUEUE_SIZE
+#if defined(__AVR__)
+#define BUTTONEVENT_QUEUE_SIZE  16
+#else
+#define BUTTONEVENT_QUEUE_SIZE 128
+#endif
+#endif
+
+// the types of the events, same as the callbacks
+#define BUTEV_START 1 // start of press
+#define BUTEV_END   2 // release of key
+#define BUTEV_CLICK 3 // the clicks, times
+#define BUTEV_LONG  4 // long press
+#define BUTEV_VLONG 5 // very long press
+
+// the max clicks in a record
+#define BUTEV_MAX_TIMES 31
+
+typedef struct _buttonevent_t {
+    uint8_t id;       // the id of the button, set by Button::set_queue()
+    uint8_t type : 3; // BUTEV_xxx
+    uint8_t times : 5; // the clicks of BUTEV_CLICK, up to BUTEV_MAX_TIMES
+    uint16_t time;    // the lower 16 bits of millis() of the event
+} buttonevent_t;
+
+static_assert (sizeof(buttonevent_t) == 4, "buttonevent_t should be 4 bytes");
+
+class ButtonEventQueue {
+public:
+    ButtonEventQueue () : overflow(0) {}
+
+    // add an event, return false if the ring is full
+    inline bool push (uint8_t id, uint8_t type, unsigned int times, unsigned long now) {
+        buttonevent_t ev;
+        ev.id = id;
+        ev.type = type;
+        ev.times = ((times > BUTEV_MAX_TIMES) ? BUTEV_MAX_TIMES : times);
+        ev.time = (uint16_t)now;
+        if (! this->events.push (ev)) {
+            if (this->overflow < 0xFFFF) {
+                this->overflow = this->overflow + 1;
+            }
+            return false;
+        }
+        return true;
+    }
+
+    // get the oldest event, return false if the queue is empty
+    inline bool pop (buttonevent_t & ev) { return this->events.pop (ev); }
+    // get up to max events in order, return the number of the events
+    inline unsigned int pop (buttonevent_t * evs, unsigned int max) {
+        unsigned int cnt = 0;
+        while ((cnt < max) && this->events.pop (evs[cnt])) {
+            cnt ++;
+        }
+        return cnt;
+    }
+    inline bool empty (void) const { return this->events.empty(); }
+
+    // the number of the events dropped because the ring is full
+    inline uint16_t get_overflow (void) const { return this->overflow; }
+    inline void clear_overflow (void) { this->overflow = 0; }
+
+private:
+    ring_buffer<buttonevent_t, BUTTONEVENT_QUEUE_SIZE> events;
+    volatile uint16_t overflow;
+};
+
+#endif // _BUTTON_EVENT_H
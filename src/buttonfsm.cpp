@@ -0,0 +1,191 @@
+/**
+ * @file    buttonfsm.cpp
+ * @brief   The state machine of the button clicks, shared by Button and ButtonBank
+ * @author  Yunhui Fu (yhfudev@gmail.com)
+ * @version 1.0
+ * @date    2016-07-14
+ * @copyright GPL
+ */
+
+#include "sysport.h"
+#include "buttonfsm.h"
+
+#ifndef TRACE
+#define TRACE(...)
+#endif
+
+// 0 -- verbose, 1 -- info, 2 -- warning, 3 -- error
+#define TRACE0 TRACE
+#define TRACE1 TRACE
+#define TRACE2 TRACE
+#define TRACE3 TRACE
+
+#if 1
+#undef TRACE0
+#define TRACE0(...)
+#undef TRACE2
+#define TRACE2(...)
+#endif
+
+#if DEBUG
+char * val2cstr_buttsw_state(int val)
+{
+#define CASESTATE(v) case BUTSW_STATE_ ##v: return "STATE_" #v
+    switch (val) {
+        CASESTATE(READY);
+        CASESTATE(DEBOUNCE);
+        CASESTATE(1CLICK);
+        CASESTATE(LONGPRESS);
+        CASESTATE(VLONGPRESS);
+        CASESTATE(DEBOUNCE2);
+    }
+    return "STATE_(unknow)";
+#undef CASESTATE
+}
+char * val2cstr_buttsw_evt(int val)
+{
+#define CASEEVT(v) case BUTSW_EVT_ ##v: return "EVT_" #v
+    switch (val) {
+        CASEEVT(NONE);
+        CASEEVT(TIMEOUT);
+        CASEEVT(PRESSED);
+        CASEEVT(RELEASED);
+    }
+    return "EVT_(unknow)";
+#undef CASEEVT
+}
+#endif // DEBUG
+
+unsigned int
+buttonfsm_timeout (uint8_t timer)
+{
+    switch (timer) {
+    case BUTSW_TIMER_DBOUNCE:
+        return BUTSW_TIMEOUT_DBOUNCE;
+    case BUTSW_TIMER_LONG:
+        return BUTSW_TIMEOUT_LONG;
+    case BUTSW_TIMER_VLONG:
+        return BUTSW_TIMEOUT_VLONG;
+    case BUTSW_TIMER_2CLICK:
+        return BUTSW_TIMEOUT_2CLICK;
+    }
+    return 0;
+}
+
+/**
+ * The transitions are in the tables of buttonfsm_table.h, generated from doc/button.dia.
+ * Each row of buttonfsm_rows[] is 16 bits, the fields do not cross the bytes:
+ *   bit 0-2   the next state, BUTSW_STATE_SAME for the self loops
+ *   bit 3-5   the timer action BUTSW_TIMER_xxx
+ *   bit 6-7   the hold: BUTSW_HOLD_xxx
+ *   bit 8-12  the callbacks BUTSW_CB_xxx
+ *   bit 13-14 the clicks: BUTSW_CLICKS_xxx
+ * Each (state, event) of buttonfsm_trans[] is the guard << 4 | the index of the row,
+ * the row of the guard being true is the next one. The (state, event) without transition
+ * in the diagram is the row of the self loop without action.
+ */
+#define BUTSW_STATE_SAME 7
+
+#define BUTSW_ROW(next, timer, cb, hold, clicks) ((uint16_t)((next) | ((timer) << 3) | ((hold) << 6) | ((cb) << 8) | ((clicks) << 13)))
+#define BUTSW_ROW_NEXT(row)   ((row) & 0x07)
+#define BUTSW_ROW_TIMER(row)  (((row) >> 3) & 0x07)
+#define BUTSW_ROW_HOLD(row)   (((row) >> 6) & 0x03)
+#define BUTSW_ROW_CB(row)     (((row) >> 8) & 0x1F)
+#define BUTSW_ROW_CLICKS(row) (((row) >> 13) & 0x03)
+
+#define BUTSW_HOLD_KEEP   0
+#define BUTSW_HOLD_CLEAR  1
+#define BUTSW_HOLD_SET    2 /* the hold is the bit 1 of BUTSW_HOLD_xxx */
+
+#define BUTSW_CLICKS_KEEP  0
+#define BUTSW_CLICKS_CLEAR 1
+#define BUTSW_CLICKS_CLICK 2 /* multiple clicks: clicks ++, otherwise report 1 click */
+#define BUTSW_CLICKS_EMIT  3 /* report the clicks and clear them */
+
+#define BUTSW_GUARD_ALWAYS       0 /* the bit 0 of the guards is always 0 */
+#define BUTSW_GUARD_HOLD         1
+#define BUTSW_GUARD_CLICKS       2
+#define BUTSW_GUARD_MULTI_CLICKS 3
+
+#define BUTSW_TRANS(guard, row) ((uint8_t)(((guard) << 4) | (row)))
+
+#include "buttonfsm_table.h"
+
+// apply the row of the state and the event (0 -- pressed, 1 -- released, 2 -- timeout), return the next state
+static uint8_t
+buttonfsm_apply (buttonfsm_t * fsm, uint8_t ev, bool multiple_click)
+{
+    uint8_t conds;
+    uint16_t row;
+    uint8_t next_state;
+    uint8_t t = pgm_read_byte_near (&(buttonfsm_trans[fsm->state][ev]));
+
+    // the bits of the guards, without the branches
+    conds = ((fsm->hold != 0) << BUTSW_GUARD_HOLD)
+        | ((fsm->clicks > 0) << BUTSW_GUARD_CLICKS)
+        | ((multiple_click && (fsm->clicks > 0)) << BUTSW_GUARD_MULTI_CLICKS);
+    row = pgm_read_word_near (&(buttonfsm_rows[(t & 0x0F) + ((conds >> (t >> 4)) & 0x01)]));
+
+    next_state = BUTSW_ROW_NEXT(row);
+    if (BUTSW_STATE_SAME == next_state) {
+        next_state = fsm->state;
+    }
+    fsm->timer = BUTSW_ROW_TIMER(row);
+    fsm->cb = BUTSW_ROW_CB(row);
+    if (BUTSW_ROW_HOLD(row)) {
+        fsm->hold = (BUTSW_ROW_HOLD(row) >> 1);
+    }
+    switch (BUTSW_ROW_CLICKS(row)) {
+    case BUTSW_CLICKS_CLEAR:
+        fsm->clicks = 0;
+        break;
+    case BUTSW_CLICKS_CLICK:
+        if (multiple_click) {
+            if (fsm->clicks < 255) {
+                fsm->clicks ++;
+            }
+        } else {
+            fsm->clicks = 0;
+            fsm->cb |= BUTSW_CB_END | BUTSW_CB_CLICK;
+            fsm->times = 1;
+        }
+        break;
+    case BUTSW_CLICKS_EMIT:
+        fsm->times = fsm->clicks;
+        fsm->clicks = 0;
+        break;
+    }
+    return next_state;
+}
+
+void
+buttonfsm_step (buttonfsm_t * fsm, uint8_t event, bool multiple_click, bool debounced)
+{
+    // PRESSED, RELEASED, TIMEOUT -> 0, 1, 2, the others are not handled
+    uint8_t ev = (uint8_t)(event - BUTSW_EVT_PRESSED);
+    uint8_t next_state = fsm->state;
+
+    if (BUTSW_EVT_TIMEOUT == event) {
+        ev = 2;
+    } else if (ev > 1) {
+        ev = 3;
+    }
+
+    fsm->timer = BUTSW_TIMER_KEEP;
+    fsm->cb = 0;
+    if ((ev < 3) && (fsm->state < BUTSW_NUM_STATES)) {
+        next_state = buttonfsm_apply (fsm, ev, multiple_click);
+    } else {
+        TRACE3 ("Button: Unhandled %s in %s", VAL2CSTR_BUTTSW_EVT(event), VAL2CSTR_BUTTSW_STATE(fsm->state));
+    }
+
+    if (debounced && ((BUTSW_STATE_DEBOUNCE == next_state) || (BUTSW_STATE_DEBOUNCE2 == next_state))) {
+        // the input is debounced by the caller, the timeout of the debounce state fires at once,
+        // by the TIMEOUT transition of the diagram
+        uint8_t cb = fsm->cb;
+        fsm->state = next_state;
+        next_state = buttonfsm_apply (fsm, 2, multiple_click);
+        fsm->cb |= cb;
+    }
+    fsm->state = next_state;
+}
@@ -0,0 +1,162 @@
+/**
+ * @file    buttonfsm.h
+ * @brief   The state machine of the button clicks, shared by Button and ButtonBank
+ * @author  Yunhui Fu (yhfudev@gmail.com)
+ * @version 1.0
+ * @date    2016-07-14
+ * @copyright GPL
+ */
+/**
+ * Usage:
+ *   buttonfsm_step() moves the state of one button by one event, and returns what the
+ *   caller should do: the timer to be started or canceled and the callbacks to be called.
+ *   The caller keeps the state and the timer, so it can be one object (Button) or
+ *   the arrays of many buttons (ButtonBank).
+ *   The transitions are the PROGMEM table of buttonfsm_table.h, which is generated
+ *   from the diagram doc/button.dia by:
+ *     python3 tools/dia2fsm.py doc/button.dia > src/buttonfsm_table.h  (or make fsm-table)
+ *   The debounced mode (the input debounced by the caller) is not in the diagram:
+ *   buttonfsm_step() applies the TIMEOUT transition of the diagram at once after
+ *   entering a debounce state, so the debounce states are skipped.
+ *
+ *   Example:
+ *     buttonfsm_t fsm;
+ *     buttonfsm_init (&fsm);
+ *     buttonfsm_step (&fsm, BUTSW_EVT_PRESSED, false);
+ *     if (BUTSW_TIMER_DBOUNCE == fsm.timer) {
+ *         // start the timer of BUTSW_TIMEOUT_DBOUNCE, then send BUTSW_EVT_TIMEOUT
+ *     }
+ *     if (fsm.cb & BUTSW_CB_CLICK) {
+ *         // clicked fsm.times times
+ *     }
+ *
+ *   buttonfsm_run() is the glue used by the buttons (Button, BasicButton, CompactButton,
+ *   ButtonBank and ButtonMatrix): it steps the state machine, then passes the timer action and
+ *   the callbacks, in the fixed order, to a sink of the caller, which keeps the storage:
+ *     struct Sink {
+ *         void timer_start (uint8_t timer, tick_t now); // (re)start the timer of buttonfsm_timeout(timer)
+ *         void timer_cancel (void);
+ *         void event (uint8_t type, unsigned int times); // BUTEV_xxx, see buttonevent.h
+ *     };
+ */
+
+#ifndef _BUTTON_FSM_H
+#define _BUTTON_FSM_H 1
+
+#include "sysport.h"
+#include "tick.h"
+#include "buttonevent.h"
+
+#ifndef BUTSW_TIMEOUT_DBOUNCE
+// debounce 30ms
+#define BUTSW_TIMEOUT_DBOUNCE   30
+#endif
+#ifndef BUTSW_TIMEOUT_LONG
+#define BUTSW_TIMEOUT_LONG    1200
+#endif
+#ifndef BUTSW_TIMEOUT_VLONG
+#define BUTSW_TIMEOUT_VLONG   3000
+#endif
+#ifndef BUTSW_TIMEOUT_2CLICK
+#define BUTSW_TIMEOUT_2CLICK   250 // the time between two clicks to merge
+#endif
+
+// internal states
+#define BUTSW_STATE_READY      0
+#define BUTSW_STATE_DEBOUNCE   1
+#define BUTSW_STATE_1CLICK     2
+#define BUTSW_STATE_LONGPRESS  3
+#define BUTSW_STATE_VLONGPRESS 4
+#define BUTSW_STATE_DEBOUNCE2  5
+#define BUTSW_NUM_STATES       6
+
+// event types
+#define BUTSW_EVT_NONE          0
+#define BUTSW_EVT_PRESSED       1
+#define BUTSW_EVT_RELEASED      2
+#define BUTSW_EVT_TIMEOUT_DB1   3
+#define BUTSW_EVT_TIMEOUT_DB2   4
+#define BUTSW_EVT_TIMEOUT_CLICK 5
+#define BUTSW_EVT_TIMEOUT_LONG  6
+#define BUTSW_EVT_TIMEOUT_READY 7
+#define BUTSW_EVT_TIMEOUT       8 /* temp */
+
+// the timer actions of a step
+#define BUTSW_TIMER_KEEP    0 /* the timer is not changed */
+#define BUTSW_TIMER_CANCEL  1
+#define BUTSW_TIMER_DBOUNCE 2 /* (re)start the timer of BUTSW_TIMEOUT_DBOUNCE */
+#define BUTSW_TIMER_LONG    3
+#define BUTSW_TIMER_VLONG   4
+#define BUTSW_TIMER_2CLICK  5
+
+// the callbacks of a step, should be called in this order
+#define BUTSW_CB_START  0x01
+#define BUTSW_CB_END    0x02
+#define BUTSW_CB_CLICK  0x04
+#define BUTSW_CB_LONG   0x08
+#define BUTSW_CB_VLONG  0x10
+
+typedef struct _buttonfsm_t {
+    uint8_t state;  // BUTSW_STATE_xxx
+    uint8_t hold;   // if the button pressed and hold
+    uint8_t clicks; // the adjacent clicks (in BUTSW_TIMEOUT_2CLICK)
+
+    // the results of the last step
+    uint8_t timer;  // BUTSW_TIMER_xxx
+    uint8_t cb;     // BUTSW_CB_xxx
+    uint8_t times;  // the clicks for BUTSW_CB_CLICK
+} buttonfsm_t;
+
+inline void buttonfsm_init (buttonfsm_t * fsm) { fsm->state = BUTSW_STATE_READY; fsm->hold = 0; fsm->clicks = 0; fsm->timer = BUTSW_TIMER_KEEP; fsm->cb = 0; fsm->times = 0; }
+// process the event, multiple_click: signal the multiple clicks as one event
+// debounced: the events are debounced by the caller (such as Debouncer), skip the debounce states
+void buttonfsm_step (buttonfsm_t * fsm, uint8_t event, bool multiple_click, bool debounced = false);
+// the time(ms) of the timer action BUTSW_TIMER_DBOUNCE ... BUTSW_TIMER_2CLICK
+unsigned int buttonfsm_timeout (uint8_t timer);
+
+// step the state machine of the button, fsm.state, fsm.hold and fsm.clicks are loaded by the caller
+// and stored back after the call; the timer action and the callbacks go to the sink, see above
+template <class Sink>
+inline void
+buttonfsm_run (buttonfsm_t & fsm, uint8_t event, bool multiple_click, bool debounced, tick_t now, Sink & sink)
+{
+    buttonfsm_step (&fsm, event, multiple_click, debounced);
+    switch (fsm.timer) {
+    case BUTSW_TIMER_KEEP:
+        break;
+    case BUTSW_TIMER_CANCEL:
+        sink.timer_cancel ();
+        break;
+    default:
+        sink.timer_start (fsm.timer, now);
+        break;
+    }
+    // the callbacks see the state before the event, the same order as BUTSW_CB_xxx
+    if (fsm.cb & BUTSW_CB_START) {
+        sink.event (BUTEV_START, 0);
+    }
+    if (fsm.cb & BUTSW_CB_END) {
+        sink.event (BUTEV_END, 0);
+    }
+    if (fsm.cb & BUTSW_CB_CLICK) {
+        sink.event (BUTEV_CLICK, fsm.times);
+    }
+    if (fsm.cb & BUTSW_CB_LONG) {
+        sink.event (BUTEV_LONG, 0);
+    }
+    if (fsm.cb & BUTSW_CB_VLONG) {
+        sink.event (BUTEV_VLONG, 0);
+    }
+}
+
+#if DEBUG
+char * val2cstr_buttsw_state(int val);
+char * val2cstr_buttsw_evt(int val);
+#define VAL2CSTR_BUTTSW_STATE(v) val2cstr_buttsw_state(v)
+#define VAL2CSTR_BUTTSW_EVT(v) val2cstr_buttsw_evt(v)
+#else
+#define VAL2CSTR_BUTTSW_STATE(v) "val2cstr_buttsw_state unimplemented"
+#define VAL2CSTR_BUTTSW_EVT(v) "val2cstr_buttsw_evt unimplemented"
+#endif // DEBUG
+
+#endif // _BUTTON_FSM_H
@@ -0,0 +1,37 @@
+/**
+ * @file    buttonfsm_table.h
+ * @brief   The transitions of the button state machine, generated by tools/dia2fsm.py from doc/button.dia, do not edit
+ * @author  Yunhui Fu (yhfudev@gmail.com)
+ * @version 1.0
+ * @date    2016-07-14
+ * @copyright GPL
+ */
+
+// the distinct transitions
+static const uint16_t buttonfsm_rows[15] PROGMEM = {
+    /*  0 */ BUTSW_ROW(BUTSW_STATE_SAME, BUTSW_TIMER_KEEP, 0, BUTSW_HOLD_KEEP, BUTSW_CLICKS_KEEP),
+    /*  1 */ BUTSW_ROW(BUTSW_STATE_SAME, BUTSW_TIMER_KEEP, BUTSW_CB_END | BUTSW_CB_CLICK, BUTSW_HOLD_KEEP, BUTSW_CLICKS_EMIT),
+    /*  2 */ BUTSW_ROW(BUTSW_STATE_READY, BUTSW_TIMER_KEEP, 0, BUTSW_HOLD_KEEP, BUTSW_CLICKS_KEEP),
+    /*  3 */ BUTSW_ROW(BUTSW_STATE_1CLICK, BUTSW_TIMER_LONG, BUTSW_CB_START, BUTSW_HOLD_KEEP, BUTSW_CLICKS_KEEP),
+    /*  4 */ BUTSW_ROW(BUTSW_STATE_DEBOUNCE2, BUTSW_TIMER_DBOUNCE, 0, BUTSW_HOLD_CLEAR, BUTSW_CLICKS_CLICK),
+    /*  5 */ BUTSW_ROW(BUTSW_STATE_LONGPRESS, BUTSW_TIMER_VLONG, 0, BUTSW_HOLD_KEEP, BUTSW_CLICKS_CLEAR),
+    /*  6 */ BUTSW_ROW(BUTSW_STATE_SAME, BUTSW_TIMER_KEEP, 0, BUTSW_HOLD_KEEP, BUTSW_CLICKS_KEEP),
+    /*  7 */ BUTSW_ROW(BUTSW_STATE_DEBOUNCE2, BUTSW_TIMER_DBOUNCE, BUTSW_CB_VLONG, BUTSW_HOLD_KEEP, BUTSW_CLICKS_KEEP),
+    /*  8 */ BUTSW_ROW(BUTSW_STATE_READY, BUTSW_TIMER_CANCEL, 0, BUTSW_HOLD_CLEAR, BUTSW_CLICKS_KEEP),
+    /*  9 */ BUTSW_ROW(BUTSW_STATE_READY, BUTSW_TIMER_2CLICK, 0, BUTSW_HOLD_CLEAR, BUTSW_CLICKS_KEEP),
+    /* 10 */ BUTSW_ROW(BUTSW_STATE_DEBOUNCE, BUTSW_TIMER_DBOUNCE, 0, BUTSW_HOLD_SET, BUTSW_CLICKS_KEEP),
+    /* 11 */ BUTSW_ROW(BUTSW_STATE_SAME, BUTSW_TIMER_KEEP, 0, BUTSW_HOLD_SET, BUTSW_CLICKS_KEEP),
+    /* 12 */ BUTSW_ROW(BUTSW_STATE_SAME, BUTSW_TIMER_KEEP, 0, BUTSW_HOLD_CLEAR, BUTSW_CLICKS_KEEP),
+    /* 13 */ BUTSW_ROW(BUTSW_STATE_DEBOUNCE2, BUTSW_TIMER_DBOUNCE, BUTSW_CB_END | BUTSW_CB_LONG, BUTSW_HOLD_CLEAR, BUTSW_CLICKS_CLEAR),
+    /* 14 */ BUTSW_ROW(BUTSW_STATE_DEBOUNCE2, BUTSW_TIMER_DBOUNCE, BUTSW_CB_END, BUTSW_HOLD_CLEAR, BUTSW_CLICKS_CLEAR),
+};
+
+// the guard and the row of each (state, event), the events are PRESSED, RELEASED, TIMEOUT
+static const uint8_t buttonfsm_trans[BUTSW_NUM_STATES][3] PROGMEM = {
+    /* READY      */ { BUTSW_TRANS(BUTSW_GUARD_ALWAYS, 10), BUTSW_TRANS(BUTSW_GUARD_ALWAYS, 0), BUTSW_TRANS(BUTSW_GUARD_CLICKS, 0) },
+    /* DEBOUNCE   */ { BUTSW_TRANS(BUTSW_GUARD_ALWAYS, 11), BUTSW_TRANS(BUTSW_GUARD_ALWAYS, 12), BUTSW_TRANS(BUTSW_GUARD_HOLD, 2) },
+    /* 1CLICK     */ { BUTSW_TRANS(BUTSW_GUARD_ALWAYS, 11), BUTSW_TRANS(BUTSW_GUARD_ALWAYS, 4), BUTSW_TRANS(BUTSW_GUARD_HOLD, 4) },
+    /* LONGPRESS  */ { BUTSW_TRANS(BUTSW_GUARD_ALWAYS, 11), BUTSW_TRANS(BUTSW_GUARD_ALWAYS, 13), BUTSW_TRANS(BUTSW_GUARD_HOLD, 6) },
+    /* VLONGPRESS */ { BUTSW_TRANS(BUTSW_GUARD_ALWAYS, 11), BUTSW_TRANS(BUTSW_GUARD_ALWAYS, 14), BUTSW_TRANS(BUTSW_GUARD_ALWAYS, 0) },
+    /* DEBOUNCE2  */ { BUTSW_TRANS(BUTSW_GUARD_ALWAYS, 0), BUTSW_TRANS(BUTSW_GUARD_ALWAYS, 0), BUTSW_TRANS(BUTSW_GUARD_MULTI_CLICKS, 8) },
+};
@@ -0,0 +1,403 @@
+/**
+ * @file    buttonmatrix.h
+ * @brief   Scan the keys of a matrix keypad one row per update(), with the clicks and the long press of each key
+ * @author  Yunhui Fu (yhfudev@gmail.com)
+ * @version 1.0
+ * @date    2016-07-14
+ * @copyright GPL
+ */
+/**
+ * Usage:
+ *   The ROWS x COLS keys of a matrix keypad are connected to ROWS + COLS pins.
+ *   The ButtonMatrix<ROWS, COLS, SLOTS> scans one row in each update(): reads the columns
+ *   of the row driven in the last update() (each port once on AVR), then drives the next row,
+ *   so update() never waits for the lines to settle.
+ *   The keys of each row are kept in one word, and the state machine of the Button (buttonfsm_step())
+ *   runs only for the keys changed from the hold of their state machines, so the edges ignored
+ *   by the state machine (such as a press in DEBOUNCE2) are fed again in the next scans.
+ *   The state machines and the timers are kept in SLOTS slots shared by all of the keys, a slot is taken by a key when it's pressed and given back when
+ *   the key is idle again, so the RAM grows with the rows and the slots, not with the keys.
+ *   The presses without a free slot are ignored and counted by get_overflow().
+ *   The keypads without the diodes show a ghost key at the 4th corner when 3 keys of a rectangle
+ *   are pressed. If a row shares 2 or more pressed columns with another row, the new presses of the
+ *   row are ignored until the rectangle is broken, the releases are still processed.
+ *   The rows are driven LOW one by one (the others are high-Z), and the columns are INPUT_PULLUP,
+ *   the key is pressed if its column reads LOW. The columns can also be sampled by the caller,
+ *   such as from a shift register, by update_row().
+ *
+ *   Example:
+ *     static const uint8_t rows[4] = { 2, 3, 4, 5 };
+ *     static const uint8_t cols[4] = { 6, 7, 8, 9 };
+ *     ButtonMatrix<4, 4> keypad;
+ *     void keypad_on_click(uint8_t key, unsigned int times) {
+ *         TRACE0 ("INFO: key %d (row %d col %d) pressed %d times", key, key / 4, key % 4, times);
+ *     }
+ *     void setup(void) {
+ *         keypad.set_pins (rows, cols);
+ *         keypad.on_click (Delegate<void(uint8_t, unsigned int)>::from_function<keypad_on_click>());
+ *     }
+ *     void loop(void) {
+ *         keypad.update();
+ *     }
+ */
+
+#ifndef _BUTTON_MATRIX_H
+#define _BUTTON_MATRIX_H 1
+
+#include "sysport.h"
+#include "tick.h"
+#include "delegate.h"
+#include "buttonfsm.h"
+#include "buttonbank.h"
+
+// the max number of the ports of the columns on AVR
+#ifndef BUTTONMATRIX_MAX_PORTS
+#define BUTTONMATRIX_MAX_PORTS 2
+#endif
+
+// the slot is not used
+#define BUTTONMATRIX_FREE 0xFF
+
+template <uint8_t ROWS, uint8_t COLS, uint8_t SLOTS = 4>
+class ButtonMatrix {
+public:
+    static_assert ((ROWS > 0) && (ROWS <= 16), "ButtonMatrix: 1 to 16 rows");
+    static_assert ((COLS > 0) && (COLS <= 16), "ButtonMatrix: 1 to 16 columns");
+    static_assert ((SLOTS > 0) && (SLOTS <= 8), "ButtonMatrix: 1 to 8 slots");
+    // the key 255 would be BUTTONMATRIX_FREE
+    static_assert ((unsigned int)ROWS * COLS <= BUTTONMATRIX_FREE, "ButtonMatrix: at most 255 keys");
+    // the keys of a row, bit c for the column c
+    typedef typename buttonbank_mask<COLS>::type cols_t;
+
+    ButtonMatrix ();
+
+    // the pins of the rows and the columns, return -1 on error
+    int set_pins (const uint8_t * row_pins, const uint8_t * col_pins);
+    // signal the multiple clicks as one event for all of the keys
+    inline void set_multiple_click (bool multiple_click) { this->multi = multiple_click; }
+
+    // the callbacks with the key, row * COLS + col
+    inline void on_click (const Delegate<void(uint8_t, unsigned int)> & dg) { this->cbs.OnClick = dg; }
+    inline void on_start (const Delegate<void(uint8_t)> & dg) { this->cbs.OnStart = dg; }
+    inline void on_end (const Delegate<void(uint8_t)> & dg) { this->cbs.OnEnd = dg; }
+    inline void on_long_press (const Delegate<void(uint8_t)> & dg) { this->cbs.OnLongPress = dg; }
+    inline void on_vlong_press (const Delegate<void(uint8_t)> & dg) { this->cbs.OnVLongPress = dg; }
+
+    // scan one row and check the timers, return true if any key is busy
+    inline bool update (void) { return this->update (millis()); }
+    bool update (unsigned long now);
+    // same as above, with the keys of the row sampled by the caller, bit c is 1 if the key is pressed
+    bool update_row (uint8_t row, cols_t pressed, unsigned long now);
+
+    // the keys of the row being pressed, after the ghost filter
+    inline cols_t get_row (uint8_t row) const { return this->keys[row]; }
+    // the presses ignored because of no free slot
+    inline uint16_t get_overflow (void) const { return this->overflow; }
+    // the scans with the new presses ignored because of the ghost keys
+    inline uint16_t get_ghosts (void) const { return this->ghosts; }
+
+private:
+    static inline cols_t BIT (uint8_t idx) { return ((cols_t)1) << idx; }
+    static inline uint8_t count_bits (cols_t v) {
+        uint8_t n = 0;
+        for (; v; v &= (v - 1)) {
+            n ++;
+        }
+        return n;
+    }
+    cols_t read_cols (void);
+    void select_row (uint8_t row);
+    // the slot of the key, allocate one if alloc, -1 if none
+    int8_t find_slot (uint8_t key, bool alloc);
+    void process_event (uint8_t s, uint8_t event, tick_t now);
+
+    cols_t keys[ROWS]; // the pressed keys of each row
+    uint8_t row;       // the row being driven, to be read in the next update()
+
+    // the state machines of the pressed and busy keys
+    uint8_t slot_key[SLOTS];    // the key of the slot, BUTTONMATRIX_FREE if free
+    uint8_t slot_state[SLOTS];
+    uint8_t slot_clicks[SLOTS];
+    tick_t slot_deadline[SLOTS];
+    uint8_t slot_hold;          // bit s: the key of the slot s is hold
+    uint8_t slot_timer;         // bit s: the timer of the slot s is started
+    bool multi;
+
+    uint16_t overflow;
+    uint16_t ghosts;
+
+    uint8_t row_pins[ROWS];
+#if defined(__AVR__)
+    volatile uint8_t * ports[BUTTONMATRIX_MAX_PORTS]; // the input registers of the columns
+    uint8_t num_ports;
+    uint8_t col_map[COLS]; // the index of the port << 3 | the bit in the port
+#else
+    uint8_t col_pins[COLS];
+#endif
+    bool has_pins;
+
+    ButtonBankCallbacks cbs;
+};
+
+template <uint8_t ROWS, uint8_t COLS, uint8_t SLOTS>
+ButtonMatrix<ROWS, COLS, SLOTS>::ButtonMatrix ()
+: row(0)
+, slot_hold(0)
+, slot_timer(0)
+, multi(false)
+, overflow(0)
+, ghosts(0)
+#if defined(__AVR__)
+, num_ports(0)
+#endif
+, has_pins(false)
+{
+    uint8_t i;
+    for (i = 0; i < ROWS; i ++) {
+        this->keys[i] = 0;
+        this->row_pins[i] = 0;
+    }
+    for (i = 0; i < SLOTS; i ++) {
+        this->slot_key[i] = BUTTONMATRIX_FREE;
+        this->slot_state[i] = BUTSW_STATE_READY;
+        this->slot_clicks[i] = 0;
+        this->slot_deadline[i] = 0;
+    }
+}
+
+template <uint8_t ROWS, uint8_t COLS, uint8_t SLOTS>
+int
+ButtonMatrix<ROWS, COLS, SLOTS>::set_pins (const uint8_t * row_pins1, const uint8_t * col_pins1)
+{
+    uint8_t i;
+    if ((nullptr == row_pins1) || (nullptr == col_pins1)) {
+        return -1;
+    }
+    for (i = 0; i < ROWS; i ++) {
+        this->row_pins[i] = row_pins1[i];
+        // high-Z until driven
+        pinMode (row_pins1[i], INPUT);
+    }
+#if defined(__AVR__)
+    uint8_t p;
+    uint8_t bit;
+    this->num_ports = 0;
+    for (i = 0; i < COLS; i ++) {
+        uint8_t bitmask = digitalPinToBitMask (col_pins1[i]);
+        volatile uint8_t * reg = portInputRegister (digitalPinToPort (col_pins1[i]));
+        for (p = 0; p < this->num_ports; p ++) {
+            if (this->ports[p] == reg) {
+                break;
+            }
+        }
+        if (p >= this->num_ports) {
+            if (this->num_ports >= BUTTONMATRIX_MAX_PORTS) {
+                // the columns are in too many ports
+                return -1;
+            }
+            this->ports[this->num_ports ++] = reg;
+        }
+        for (bit = 0; (bit < 7) && (0 == (bitmask & (1 << bit))); bit ++);
+        this->col_map[i] = (p << 3) | bit;
+        pinMode (col_pins1[i], INPUT_PULLUP);
+    }
+#else
+    for (i = 0; i < COLS; i ++) {
+        this->col_pins[i] = col_pins1[i];
+        pinMode (col_pins1[i], INPUT_PULLUP);
+    }
+#endif
+    this->has_pins = true;
+    this->row = 0;
+    this->select_row (0);
+    return 0;
+}
+
+template <uint8_t ROWS, uint8_t COLS, uint8_t SLOTS>
+void
+ButtonMatrix<ROWS, COLS, SLOTS>::select_row (uint8_t row1)
+{
+    // release the last row
+    pinMode (this->row_pins[(row1 > 0) ? (row1 - 1) : (ROWS - 1)], INPUT);
+    pinMode (this->row_pins[row1], OUTPUT);
+    digitalWrite (this->row_pins[row1], LOW);
+}
+
+template <uint8_t ROWS, uint8_t COLS, uint8_t SLOTS>
+typename ButtonMatrix<ROWS, COLS, SLOTS>::cols_t
+ButtonMatrix<ROWS, COLS, SLOTS>::read_cols (void)
+{
+    cols_t pressed = 0;
+    uint8_t i;
+#if defined(__AVR__)
+    uint8_t val[BUTTONMATRIX_MAX_PORTS];
+    // one read for each port
+    for (i = 0; i < this->num_ports; i ++) {
+        val[i] = *(this->ports[i]);
+    }
+    for (i = 0; i < COLS; i ++) {
+        if (0 == (val[this->col_map[i] >> 3] & (1 << (this->col_map[i] & 0x07)))) {
+            pressed |= BIT(i);
+        }
+    }
+#else
+    for (i = 0; i < COLS; i ++) {
+        if (LOW == digitalRead (this->col_pins[i])) {
+            pressed |= BIT(i);
+        }
+    }
+#endif
+    return pressed;
+}
+
+template <uint8_t ROWS, uint8_t COLS, uint8_t SLOTS>
+int8_t
+ButtonMatrix<ROWS, COLS, SLOTS>::find_slot (uint8_t key, bool alloc)
+{
+    uint8_t s;
+    int8_t free_slot = -1;
+    for (s = 0; s < SLOTS; s ++) {
+        if (this->slot_key[s] == key) {
+            return s;
+        }
+        if ((free_slot < 0) && (BUTTONMATRIX_FREE == this->slot_key[s])) {
+            free_slot = s;
+        }
+    }
+    if (alloc && (free_slot >= 0)) {
+        this->slot_key[free_slot] = key;
+        this->slot_state[free_slot] = BUTSW_STATE_READY;
+        this->slot_clicks[free_slot] = 0;
+        this->slot_hold &= ~(1 << free_slot);
+        this->slot_timer &= ~(1 << free_slot);
+        return free_slot;
+    }
+    return -1;
+}
+
+template <uint8_t ROWS, uint8_t COLS, uint8_t SLOTS>
+void
+ButtonMatrix<ROWS, COLS, SLOTS>::process_event (uint8_t s, uint8_t event, tick_t now)
+{
+    struct Sink {
+        ButtonMatrix & m;
+        uint8_t s;
+        inline void timer_start (uint8_t timer, tick_t now1) {
+            this->m.slot_deadline[this->s] = now1 + buttonfsm_timeout (timer);
+            this->m.slot_timer |= (1 << this->s);
+        }
+        inline void timer_cancel (void) { this->m.slot_timer &= ~(1 << this->s); }
+        inline void event (uint8_t type, unsigned int times) {
+            this->m.cbs.call (this->m.slot_key[this->s], type, times);
+        }
+    } sink = { *this, s };
+    buttonfsm_t fsm;
+    buttonfsm_init (&fsm);
+    fsm.state = this->slot_state[s];
+    fsm.hold = ((this->slot_hold & (1 << s)) ? 1 : 0);
+    fsm.clicks = this->slot_clicks[s];
+    buttonfsm_run (fsm, event, this->multi, false, now, sink);
+    if (fsm.hold) {
+        this->slot_hold |= (1 << s);
+    } else {
+        this->slot_hold &= ~(1 << s);
+    }
+    this->slot_clicks[s] = fsm.clicks;
+    this->slot_state[s] = fsm.state;
+    if ((BUTSW_STATE_READY == fsm.state) && (0 == (this->slot_timer & (1 << s)))) {
+        // idle, give back the slot
+        this->slot_key[s] = BUTTONMATRIX_FREE;
+    }
+}
+
+template <uint8_t ROWS, uint8_t COLS, uint8_t SLOTS>
+bool
+ButtonMatrix<ROWS, COLS, SLOTS>::update (unsigned long now)
+{
+    bool ret;
+    if (! this->has_pins) {
+        return false;
+    }
+    // the row driven in the last update() is settled
+    ret = this->update_row (this->row, this->read_cols(), now);
+    this->row ++;
+    if (this->row >= ROWS) {
+        this->row = 0;
+    }
+    this->select_row (this->row);
+    return ret;
+}
+
+template <uint8_t ROWS, uint8_t COLS, uint8_t SLOTS>
+bool
+ButtonMatrix<ROWS, COLS, SLOTS>::update_row (uint8_t row1, cols_t pressed, unsigned long now)
+{
+    tick_t t = tick_from (now);
+    cols_t m;
+    cols_t pressed_new;
+    cols_t held;
+    uint8_t i;
+    uint8_t c;
+    int8_t s;
+
+    if (row1 >= ROWS) {
+        return false;
+    }
+    pressed &= (cols_t)(((cols_t)~(cols_t)0) >> (sizeof(cols_t) * 8 - COLS));
+    pressed_new = pressed & ~this->keys[row1];
+    if (pressed_new) {
+        // the ghost: the row shares 2 or more columns with another row, ignore the new presses
+        for (i = 0; i < ROWS; i ++) {
+            if ((i != row1) && (count_bits (pressed & this->keys[i]) >= 2)) {
+                pressed &= this->keys[row1];
+                if (this->ghosts < 0xFFFF) {
+                    this->ghosts ++;
+                }
+                break;
+            }
+        }
+    }
+    // the keys of the row changed from the hold of their slots, same as ButtonBank::update_bits(),
+    // the keys without a slot are released
+    held = 0;
+    for (i = 0; i < SLOTS; i ++) {
+        if ((this->slot_hold & (1 << i)) && (BUTTONMATRIX_FREE != this->slot_key[i]) && (this->slot_key[i] / COLS == row1)) {
+            held |= BIT(this->slot_key[i] % COLS);
+        }
+    }
+    m = pressed ^ held;
+    for (c = 0; m; c ++, m >>= 1) {
+        if (0 == (m & 1)) {
+            continue;
+        }
+        s = this->find_slot (row1 * COLS + c, (pressed & BIT(c)) != 0);
+        if (s < 0) {
+            if (pressed & BIT(c)) {
+                // no free slot, try again in the next scan
+                pressed &= ~BIT(c);
+                if (this->overflow < 0xFFFF) {
+                    this->overflow ++;
+                }
+            }
+            continue;
+        }
+        this->process_event (s, ((pressed & BIT(c)) ? BUTSW_EVT_PRESSED : BUTSW_EVT_RELEASED), t);
+    }
+    this->keys[row1] = pressed;
+
+    // the timers of all of the slots
+    for (i = 0; i < SLOTS; i ++) {
+        if ((this->slot_timer & (1 << i)) && tick_reached (t, this->slot_deadline[i])) {
+            this->slot_timer &= ~(1 << i);
+            this->process_event (i, BUTSW_EVT_TIMEOUT, t);
+        }
+    }
+    for (i = 0; i < SLOTS; i ++) {
+        if (BUTTONMATRIX_FREE != this->slot_key[i]) {
+            return true;
+        }
+    }
+    return false;
+}
+
+#endif // _BUTTON_MATRIX_H
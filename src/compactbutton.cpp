@@ -0,0 +1,101 @@
+/**
+ * @file    compactbutton.cpp
+ * @brief   The button in a few bytes of RAM, for many buttons on the small MCUs such as ATtiny85
+ * @author  Yunhui Fu (yhfudev@gmail.com)
+ * @version 1.0
+ * @date    2016-07-14
+ * @copyright GPL
+ */
+
+#include "sysport.h"
+#include "compactbutton.h"
+
+#ifndef TRACE
+#define TRACE(...)
+#endif
+
+// 0 -- verbose, 1 -- info, 2 -- warning, 3 -- error
+#define TRACE0 TRACE
+#define TRACE1 TRACE
+#define TRACE2 TRACE
+#define TRACE3 TRACE
+
+#if 1
+#undef TRACE0
+#define TRACE0(...)
+#endif
+
+Delegate<void(uint8_t, uint8_t, unsigned int)> CompactButton::dispatcher;
+
+CompactButton::CompactButton (bool multiple_click)
+{
+    this->pin = 0;
+    this->id = 0;
+    this->state = BUTSW_STATE_READY;
+    this->hold = 0;
+    this->released_high = 1;
+    this->multi = (multiple_click ? 1 : 0);
+    this->timer_active = 0;
+    this->clicks = 0;
+    this->deadline = 0;
+}
+
+void
+CompactButton::set_pin (uint8_t digital_pin, uint8_t pressed_state)
+{
+    this->pin = digital_pin;
+    this->released_high = (pressed_state ? 0 : 1);
+}
+
+bool
+CompactButton::next_deadline (unsigned long & deadline1)
+{
+    if (! this->timer_active) {
+        return false;
+    }
+    deadline1 = tick_to_ms (this->deadline, millis());
+    return true;
+}
+
+void
+CompactButton::process_event (uint8_t event, tick_t now)
+{
+    struct Sink {
+        CompactButton & b;
+        inline void timer_start (uint8_t timer, tick_t now1) {
+            this->b.deadline = now1 + buttonfsm_timeout (timer);
+            this->b.timer_active = 1;
+        }
+        inline void timer_cancel (void) { this->b.timer_active = 0; }
+        inline void event (uint8_t type, unsigned int times) {
+            TRACE0 ("CompactButton %d: event %d", this->b.id, type);
+            if (CompactButton::dispatcher.is_set()) {
+                CompactButton::dispatcher (this->b.id, type, times);
+            }
+        }
+    } sink = { *this };
+    buttonfsm_t fsm;
+    fsm.state = this->state;
+    fsm.hold = this->hold;
+    fsm.clicks = this->clicks;
+    buttonfsm_run (fsm, event, this->multi, false, now, sink);
+    this->hold = (fsm.hold ? 1 : 0);
+    this->clicks = fsm.clicks;
+    this->state = fsm.state;
+}
+
+bool
+CompactButton::update_pin (uint8_t pin_state, unsigned long now)
+{
+    tick_t t = tick_from (now);
+    uint8_t pressed = (((pin_state ? 1 : 0) != this->released_high) ? 1 : 0);
+    // the pin first, then the timer, same as Button
+    if (pressed != this->hold) {
+        this->process_event ((pressed ? BUTSW_EVT_PRESSED : BUTSW_EVT_RELEASED), t);
+    }
+    if (this->timer_active && tick_reached (t, this->deadline)) {
+        this->timer_active = 0;
+        this->process_event (BUTSW_EVT_TIMEOUT, t);
+    }
+    return (this->timer_active || (BUTSW_STATE_READY != this->state));
+}
@@ -0,0 +1,105 @@
+/**
+ * @file    compactbutton.h
+ * @brief   The button in a few bytes of RAM, for many buttons on the small MCUs such as ATtiny85
+ * @author  Yunhui Fu (yhfudev@gmail.com)
+ * @version 1.0
+ * @date    2016-07-14
+ * @copyright GPL
+ */
+/**
+ * Usage:
+ *   The Button keeps the timers, the scheduler, the edges and five callbacks for each object.
+ *   The CompactButton keeps only:
+ *     1) the pin and the id of the button,
+ *     2) the state, the hold, the polarity, the multiple click and the timer flag in the bitfields,
+ *     3) the clicks,
+ *     4) the deadline of the running timer (tick_t),
+ *   6 bytes in total (8 bytes if TICK_BITS is 32),
+ *   and all of the CompactButtons call one shared dispatcher with the id, the type of the
+ *   event (BUTEV_xxx, see buttonevent.h) and the clicks.
+ *   The state machine and the timeouts are the same as the Button (buttonfsm_step(),
+ *   BUTSW_TIMEOUT_xxx), so the events are the same. The pin and the timer are polled in update().
+ *
+ *   Example:
+ *     CompactButton butts[4];
+ *     void butt_on_event(uint8_t id, uint8_t type, unsigned int times) {
+ *         if (BUTEV_CLICK == type) {
+ *             TRACE0 ("INFO: button %d pressed %d times", id, times);
+ *         }
+ *     }
+ *     void setup(void) {
+ *         for (uint8_t i = 0; i < 4; i ++) {
+ *             pinMode (i, INPUT_PULLUP);
+ *             butts[i].set_pin (i, LOW);
+ *             butts[i].set_id (i);
+ *         }
+ *         CompactButton::set_dispatcher (Delegate<void(uint8_t, uint8_t, unsigned int)>::from_function<butt_on_event>());
+ *     }
+ *     void loop(void) {
+ *         unsigned long now = millis();
+ *         for (uint8_t i = 0; i < 4; i ++) {
+ *             butts[i].update (now);
+ *         }
+ *     }
+ */
+
+#ifndef _COMPACT_BUTTON_H
+#define _COMPACT_BUTTON_H 1
+
+#include "sysport.h"
+#include "tick.h"
+#include "delegate.h"
+#include "buttonfsm.h"
+#include "buttonevent.h"
+
+// the size limit of the CompactButton
+#ifndef COMPACTBUTTON_MAX_SIZE
+#define COMPACTBUTTON_MAX_SIZE 12
+#endif
+
+class CompactButton {
+public:
+    CompactButton (bool multiple_click = false);
+
+    // pressed_state: the state of the input when the button pressed, HIGH or LOW
+    void set_pin (uint8_t digital_pin, uint8_t pressed_state = LOW);
+    inline uint8_t get_pin (void) const { return this->pin; }
+    // the id passed to the dispatcher
+    inline void set_id (uint8_t id1) { this->id = id1; }
+    inline uint8_t get_id (void) const { return this->id; }
+    // signal the multiple clicks as one event
+    inline void set_multiple_click (bool multiple_click) { this->multi = (multiple_click ? 1 : 0); }
+
+    // the callback of the events of all of the CompactButtons: the id, BUTEV_xxx and the clicks
+    static inline void set_dispatcher (const Delegate<void(uint8_t, uint8_t, unsigned int)> & dg) { CompactButton::dispatcher = dg; }
+
+    // read the pin and check the timer, return true if the button is busy
+    inline bool update (void) { return this->update (millis()); }
+    inline bool update (unsigned long now) { return this->update_pin (digitalRead (this->pin), now); }
+    // same as above, with the state of the pin read by the caller
+    bool update_pin (uint8_t pin_state, unsigned long now);
+    // the time(millis) of the next timeout, return false if nothing to wait
+    bool next_deadline (unsigned long & deadline1);
+
+    inline uint8_t get_state (void) const { return this->state; }
+    inline bool is_hold (void) const { return (this->hold != 0); }
+
+private:
+    void process_event (uint8_t event, tick_t now);
+
+    uint8_t pin;
+    uint8_t id;
+    uint8_t state : 3;         // BUTSW_STATE_xxx
+    uint8_t hold : 1;          // the button pressed and hold
+    uint8_t released_high : 1; // the input is HIGH when the button released
+    uint8_t multi : 1;         // signal the multiple clicks as one event
+    uint8_t timer_active : 1;  // the timer is started
+    uint8_t clicks;            // the adjacent clicks
+    tick_t deadline;           // the time of the timeout if timer_active
+
+    static Delegate<void(uint8_t, uint8_t, unsigned int)> dispatcher;
+};
+
+static_assert (sizeof(CompactButton) <= COMPACTBUTTON_MAX_SIZE, "CompactButton is larger than COMPACTBUTTON_MAX_SIZE");
+
+#endif // _COMPACT_BUTTON_H
@@ -0,0 +1,97 @@
+/**
+ * @file    debounce.h
+ * @brief   Debounce 8/16/32/64 inputs in parallel by the vertical counters
+ * @author  Yunhui Fu (yhfudev@gmail.com)
+ * @version 1.0
+ * @date    2016-07-14
+ * @copyright GPL
+ */
+/**
+ * Usage:
+ *   The Button debounces each input by its own timer and the debounce states.
+ *   The Debouncer<T, BITS> keeps one BITS-bit counter for each bit of T, the bit i of the
+ *   counter is stored in the bit i of the word cnt[i] (the vertical counter), so one update()
+ *   counts all of the inputs in a few bitwise operations:
+ *     1) the inputs different from the debounced state are counted, the others are cleared,
+ *     2) the inputs different for 2^BITS samples are toggled in the debounced state.
+ *   The debounce time is 2^BITS times the sample period, such as 4 x 5ms for BITS=2.
+ *   The edges of the last update() are returned by get_pressed() and get_released(), and
+ *   the debounced state can be fed to ButtonBank::update_bits() with set_debounce_sample().
+ *
+ *   Example:
+ *     Debouncer<uint8_t> db;
+ *     void loop(void) {
+ *         // sample the port every 5 ms
+ *         db.update (~PIND);
+ *         if (db.get_pressed() & 0x04) {
+ *             // pin 2 pressed
+ *         }
+ *     }
+ */
+
+#ifndef _DEBOUNCE_H
+#define _DEBOUNCE_H 1
+
+#include "sysport.h"
+
+template <typename T, uint8_t BITS = 2>
+class Debouncer {
+public:
+    static_assert ((BITS >= 2) && (BITS <= 4), "Debouncer: 2 to 4 bits counters");
+
+    Debouncer () : state(0), changed(0) { this->reset (0); }
+
+    // set the debounced state, clear the counters
+    inline void reset (T state1) {
+        uint8_t i;
+        this->state = state1;
+        this->changed = 0;
+        for (i = 0; i < BITS; i ++) {
+            this->cnt[i] = 0;
+        }
+    }
+
+    // add a sample of the inputs, return the bits changed in the debounced state
+    inline T update (T sample) {
+        uint8_t i;
+        T tmp;
+        T delta = sample ^ this->state;
+        T carry = delta;
+        // increase the counters of the different inputs, clear the others
+        for (i = 0; i < BITS; i ++) {
+            tmp = this->cnt[i] & carry;
+            this->cnt[i] = (this->cnt[i] ^ carry) & delta;
+            carry = tmp;
+        }
+        // the counters overflowed to 0: different for 2^BITS samples
+        this->changed = carry;
+        this->state ^= carry;
+        return carry;
+    }
+
+    // return true if no input is being counted
+    inline bool is_stable (void) const {
+        uint8_t i;
+        for (i = 0; i < BITS; i ++) {
+            if (this->cnt[i]) {
+                return false;
+            }
+        }
+        return true;
+    }
+    // the debounced state
+    inline T get_state (void) const { return this->state; }
+    // the bits changed by the last update()
+    inline T get_changed (void) const { return this->changed; }
+    // the bits changed from 0 to 1 by the last update()
+    inline T get_pressed (void) const { return this->changed & this->state; }
+    // the bits changed from 1 to 0 by the last update()
+    inline T get_released (void) const { return this->changed & ~this->state; }
+
+private:
+    T state;     // the debounced state
+    T changed;   // the edges of the last update()
+    T cnt[BITS]; // the vertical counters, cnt[i] is the bit i of the counters
+};
+
+#endif // _DEBOUNCE_H
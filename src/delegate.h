@@ -0,0 +1,92 @@
+/**
+ * @file    delegate.h
+ * @brief   Type-safe callback to a free function, a member function or a functor, without heap
+ * @author  Yunhui Fu (yhfudev@gmail.com)
+ * @version 1.0
+ * @date    2016-07-14
+ * @copyright GPL
+ */
+/**
+ * Usage:
+ *   A Delegate<R(Args...)> is an object pointer and a stub function, two pointers in RAM.
+ *   The target is a template argument of the stub, so it's known at compile time and
+ *   inlined into the stub, and calling the delegate is one indirect call, the same as
+ *   the C callback with the userdata.
+ *   The stub has the same type as the C callback R (*)(void * userdata, Args...), so the
+ *   existing C callbacks can also be stored in the delegate.
+ *   The arguments are passed by value, the callbacks of the library only pass the scalars.
+ *   The objects with several callbacks, such as Button, keep one object for all of them and
+ *   only the stub of each delegate (get_stub()), one pointer per callback.
+ *
+ *   Example:
+ *     class Panel {
+ *     public:
+ *         void on_click(unsigned int times);
+ *     };
+ *     Panel panel;
+ *     Button butt;
+ *     void butt_on_long(void) { ... }
+ *     void butt_on_end(void * userdata) { ... }
+ *     void setup(void) {
+ *         // the member function
+ *         butt.on_click (Delegate<void(unsigned int)>::from_method<Panel, &Panel::on_click>(&panel));
+ *         // the free function
+ *         butt.on_long_press (Delegate<void()>::from_function<butt_on_long>());
+ *         // the C callback
+ *         butt.on_end (Delegate<void()>(butt_on_end, &panel));
+ *     }
+ */
+
+#ifndef _DELEGATE_H
+#define _DELEGATE_H 1
+
+template <typename T> class Delegate;
+
+template <typename R, typename... Args>
+class Delegate<R(Args...)> {
+public:
+    // the stub, same as the C callback with the userdata
+    typedef R (* stub_t)(void * obj, Args...);
+
+    Delegate () : obj(nullptr), stub(nullptr) {}
+    // the C callback and its userdata
+    Delegate (stub_t function, void * userdata) : obj(userdata), stub(function) {}
+
+    // the free function
+    template <R (* function)(Args...)>
+    static inline Delegate from_function (void) { return Delegate (&Delegate::function_stub<function>, nullptr); }
+    // the member function of the object
+    template <class T, R (T::* method)(Args...)>
+    static inline Delegate from_method (T * obj1) { return Delegate (&Delegate::method_stub<T, method>, obj1); }
+    template <class T, R (T::* method)(Args...) const>
+    static inline Delegate from_const_method (const T * obj1) { return Delegate (&Delegate::const_method_stub<T, method>, const_cast<T *>(obj1)); }
+    // the functor or the lambda, it should live longer than the delegate
+    template <class T>
+    static inline Delegate from_functor (T * obj1) { return Delegate (&Delegate::functor_stub<T>, obj1); }
+
+    inline R operator() (Args... args) const { return this->stub (this->obj, args...); }
+    // if the target is set
+    inline bool is_set (void) const { return (nullptr != this->stub); }
+    inline void clear (void) { this->obj = nullptr; this->stub = nullptr; }
+    inline bool operator== (const Delegate & rhs) const { return (this->obj == rhs.obj) && (this->stub == rhs.stub); }
+    inline bool operator!= (const Delegate & rhs) const { return ! (*this == rhs); }
+
+    // for the APIs with the C callbacks, such as TimerInt::start()
+    inline void * get_obj (void) const { return this->obj; }
+    inline stub_t get_stub (void) const { return this->stub; }
+
+private:
+    void * obj;
+    stub_t stub;
+
+    template <R (* function)(Args...)>
+    static R function_stub (void * obj1, Args... args) { return function (args...); }
+    template <class T, R (T::* method)(Args...)>
+    static R method_stub (void * obj1, Args... args) { return (((T *)obj1)->*method)(args...); }
+    template <class T, R (T::* method)(Args...) const>
+    static R const_method_stub (void * obj1, Args... args) { return (((const T *)obj1)->*method)(args...); }
+    template <class T>
+    static R functor_stub (void * obj1, Args... args) { return (*(T *)obj1)(args...); }
+};
+
+#endif // _DELEGATE_H
@@ -0,0 +1,182 @@
+/**
+ * @file    encoder.cpp
+ * @brief   Quadrature rotary encoder decoded by a 16-entry transition table, with the acceleration and the push switch
+ * @author  Yunhui Fu (yhfudev@gmail.com)
+ * @version 1.0
+ * @date    2016-07-14
+ * @copyright GPL
+ */
+
+#include "sysport.h"
+#include "encoder.h"
+#include "button.h"
+
+#if defined(__AVR__)
+#include <avr/interrupt.h>
+#endif
+
+#ifndef TRACE
+#define TRACE(...)
+#endif
+
+// 0 -- verbose, 1 -- info, 2 -- warning, 3 -- error
+#define TRACE0 TRACE
+#define TRACE1 TRACE
+#define TRACE2 TRACE
+#define TRACE3 TRACE
+
+#if 1
+#undef TRACE0
+#define TRACE0(...)
+#undef TRACE1
+#define TRACE1(...)
+#endif
+
+// both of the channels changed, the direction is unknown
+#define ENC_ERR 2
+
+// the step of the transition, indexed by the last levels << 2 | the new levels (A: bit 1, B: bit 0)
+// the gray code sequence 00 -> 10 -> 11 -> 01 -> 00 is forward (A leads B)
+static const PROGMEM int8_t encoder_table[16] = {
+    /* 00 -> */  0, -1,  1, ENC_ERR,
+    /* 01 -> */  1,  0, ENC_ERR, -1,
+    /* 10 -> */ -1, ENC_ERR,  0,  1,
+    /* 11 -> */ ENC_ERR,  1, -1,  0,
+};
+
+Encoder::Encoder ()
+: pin_a(0)
+, pin_b(0)
+#if defined(__AVR__)
+, reg_a(nullptr)
+, reg_b(nullptr)
+, mask_a(0)
+, mask_b(0)
+#endif
+, has_pins(false)
+, by_interrupt(false)
+, steps_per_detent(ENCODER_STEPS_PER_DETENT)
+, levels(0)
+, steps(0)
+, errors(0)
+, pending(0)
+, position(0)
+, fast_ms(0)
+, max_mult(1)
+, t_last(0)
+, idle(true)
+, sw(nullptr)
+{
+}
+
+int
+Encoder::set_pins (uint8_t pin_a1, uint8_t pin_b1, uint8_t steps_per_detent1)
+{
+    if ((steps_per_detent1 < 1) || (steps_per_detent1 > 4) || (pin_a1 == pin_b1)) {
+        TRACE3 ("Encoder: invalid pins %d, %d or steps %d", pin_a1, pin_b1, steps_per_detent1);
+        return -1;
+    }
+    this->pin_a = pin_a1;
+    this->pin_b = pin_b1;
+    this->steps_per_detent = steps_per_detent1;
+    pinMode (pin_a1, INPUT_PULLUP);
+    pinMode (pin_b1, INPUT_PULLUP);
+#if defined(__AVR__)
+    this->reg_a = portInputRegister (digitalPinToPort (pin_a1));
+    this->reg_b = portInputRegister (digitalPinToPort (pin_b1));
+    this->mask_a = digitalPinToBitMask (pin_a1);
+    this->mask_b = digitalPinToBitMask (pin_b1);
+#endif
+    this->has_pins = true;
+    // start from the current levels
+    this->isr_update ();
+    this->steps = 0;
+    this->errors = 0;
+    this->pending = 0;
+    return 0;
+}
+
+void
+Encoder::isr_update (void)
+{
+    uint8_t lv;
+    if (! this->has_pins) {
+        return;
+    }
+#if defined(__AVR__)
+    lv = (((*(this->reg_a)) & this->mask_a) ? 0x02 : 0) | (((*(this->reg_b)) & this->mask_b) ? 0x01 : 0);
+#else
+    lv = ((HIGH == digitalRead (this->pin_a)) ? 0x02 : 0) | ((HIGH == digitalRead (this->pin_b)) ? 0x01 : 0);
+#endif
+    this->isr_levels (lv);
+}
+
+void
+Encoder::isr_levels (uint8_t lv)
+{
+    int8_t d;
+    lv &= 0x03;
+    d = (int8_t)pgm_read_byte_near (&(encoder_table[(this->levels << 2) | lv]));
+    this->levels = lv;
+    if (ENC_ERR == d) {
+        if (this->errors < 0xFFFF) {
+            this->errors = this->errors + 1;
+        }
+        return;
+    }
+    this->steps = this->steps + d;
+}
+
+bool
+Encoder::update (unsigned long now)
+{
+    tick_t t = tick_from (now);
+    int16_t st;
+    int detents;
+    unsigned int mult = 1;
+    unsigned long dt;
+
+    if (this->has_pins && (! this->by_interrupt)) {
+        this->isr_update ();
+    }
+#if defined(__AVR__)
+    uint8_t sreg_saved = SREG;
+    cli();
+#endif
+    st = this->steps;
+    this->steps = 0;
+#if defined(__AVR__)
+    SREG = sreg_saved;
+#endif
+
+    if (this->sw) {
+        this->sw->update (now);
+    }
+    st += this->pending;
+    detents = st / this->steps_per_detent;
+    this->pending = st - detents * this->steps_per_detent;
+    if (0 == detents) {
+        // the elapsed time wraps around after TICK_MAX_SPAN, mark the knob idle before that
+        if ((! this->idle) && (tick_elapsed (t, this->t_last) >= this->fast_ms)) {
+            this->idle = true;
+        }
+        return false;
+    }
+
+    if ((this->fast_ms > 0) && (this->max_mult > 1) && (! this->idle)) {
+        // the time of each detent in this update
+        dt = tick_elapsed (t, this->t_last) / ((detents < 0) ? -detents : detents);
+        if (dt < this->fast_ms) {
+            mult = 1 + (unsigned long)(this->max_mult - 1) * (this->fast_ms - dt) / this->fast_ms;
+        }
+    }
+    this->t_last = t;
+    this->idle = false;
+    detents *= (int)mult;
+    this->position += detents;
+    TRACE0 ("Encoder: %d detents (x%d), position %ld", detents, mult, this->position);
+    if (this->OnRotate.is_set()) {
+        this->OnRotate (detents);
+    }
+    return true;
+}
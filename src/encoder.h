@@ -0,0 +1,122 @@
+/**
+ * @file    encoder.h
+ * @brief   Quadrature rotary encoder decoded by a 16-entry transition table, with the acceleration and the push switch
+ * @author  Yunhui Fu (yhfudev@gmail.com)
+ * @version 1.0
+ * @date    2016-07-14
+ * @copyright GPL
+ */
+/**
+ * Usage:
+ *   The Encoder decodes the two channels A and B of a rotary encoder by the table of the 16
+ *   transitions (the last levels and the new levels), each valid transition is one step forward
+ *   or backward, the transitions of both channels changed at once are counted as errors.
+ *   The steps are added to an accumulator, and update() turns them into the detents
+ *   (steps_per_detent steps each), applies the acceleration and calls the callback,
+ *   following the update()/callback convention of the Button.
+ *
+ *   The pins are read in each update() by default, the steps are lost if the knob turns more than
+ *   one step between two update(). To catch all of the steps, call isr_update() from the ISR of the
+ *   pin changes of both pins, then update() only takes the accumulator:
+ *     #define PORT_ENC_A 2
+ *     #define PORT_ENC_B 3
+ *     #define PORT_ENC_SW 4
+ *     Encoder enc;
+ *     Button enc_sw(false);
+ *     void on_enc_change(void) { enc.isr_update(); }
+ *     void on_rotate(int detents) { ... }
+ *     void on_push(unsigned int times) { ... }
+ *     void setup(void) {
+ *         enc.set_pins (PORT_ENC_A, PORT_ENC_B);
+ *         enc.set_acceleration (50, 8); // up to x8 if the detents are less than 50 ms apart
+ *         enc.on_rotate (Delegate<void(int)>::from_function<on_rotate>());
+ *         enc.set_interrupt (true);
+ *         attachInterrupt(digitalPinToInterrupt(PORT_ENC_A), on_enc_change, CHANGE);
+ *         attachInterrupt(digitalPinToInterrupt(PORT_ENC_B), on_enc_change, CHANGE);
+ *         // the push switch of the encoder, updated by enc.update()
+ *         pinMode(PORT_ENC_SW, INPUT_PULLUP);
+ *         enc_sw.set_pin (PORT_ENC_SW);
+ *         enc_sw.on_click (Delegate<void(unsigned int)>::from_function<on_push>());
+ *         enc.set_switch (&enc_sw);
+ *     }
+ *     void loop(void) {
+ *         enc.update();
+ *     }
+ *   On PC, isr_levels() stands in for the interrupt with the levels of the pins.
+ */
+
+#ifndef _ENCODER_H
+#define _ENCODER_H 1
+
+#include "sysport.h"
+#include "tick.h"
+#include "delegate.h"
+
+// the steps of a detent of the common encoders
+#ifndef ENCODER_STEPS_PER_DETENT
+#define ENCODER_STEPS_PER_DETENT 4
+#endif
+
+class Button;
+
+class Encoder {
+public:
+    Encoder ();
+
+    // the pins of the channels A and B (INPUT_PULLUP), return -1 on error
+    int set_pins (uint8_t pin_a, uint8_t pin_b, uint8_t steps_per_detent = ENCODER_STEPS_PER_DETENT);
+    // by_interrupt: the pins are read by isr_update() from the ISR, otherwise in every update()
+    inline void set_interrupt (bool by_interrupt1) { this->by_interrupt = by_interrupt1; }
+    // the detents less than fast_ms apart are multiplied up to max_mult, by the speed; 0 to disable
+    inline void set_acceleration (uint16_t fast_ms1, uint8_t max_mult1) { this->fast_ms = fast_ms1; this->max_mult = ((max_mult1 > 0) ? max_mult1 : 1); }
+    // the push switch of the encoder, updated by update() with the same time, nullptr if none
+    inline void set_switch (Button * butt) { this->sw = butt; }
+    // the detents turned since the last callback (after the acceleration), positive for clockwise (A leads B)
+    inline void on_rotate (const Delegate<void(int)> & dg) { this->OnRotate = dg; }
+
+    // read the pins and decode the transition, called by the ISR of the pin changes
+    void isr_update (void);
+    // decode the new levels of the pins, bit 1: A, bit 0: B
+    void isr_levels (uint8_t levels);
+
+    // take the steps from the accumulator, call the callback, and update the switch
+    // return true if the knob turned
+    inline bool update (void) { return this->update (millis()); }
+    bool update (unsigned long now);
+
+    // the sum of the detents reported (after the acceleration)
+    inline long get_position (void) const { return this->position; }
+    inline void set_position (long pos) { this->position = pos; }
+    // the transitions of both channels changed at once, the steps are lost
+    inline uint16_t get_errors (void) const { return this->errors; }
+
+private:
+    uint8_t pin_a;
+    uint8_t pin_b;
+#if defined(__AVR__)
+    volatile uint8_t * reg_a; // the input registers of the pins
+    volatile uint8_t * reg_b;
+    uint8_t mask_a;
+    uint8_t mask_b;
+#endif
+    bool has_pins;
+    bool by_interrupt;
+    uint8_t steps_per_detent;
+
+    // written by the ISR
+    volatile uint8_t levels;  // the last levels of A and B
+    volatile int16_t steps;   // the steps not taken by update()
+    volatile uint16_t errors;
+
+    int8_t pending;     // the steps less than a detent
+    long position;
+    uint16_t fast_ms;
+    uint8_t max_mult;
+    tick_t t_last;      // the time of the last detent
+    bool idle;          // no detent in fast_ms since t_last, no acceleration for the next one
+
+    Button * sw;
+    Delegate<void(int)> OnRotate;
+};
+
+#endif // _ENCODER_H
@@ -0,0 +1,80 @@
+/**
+ * @file    fastgpio.h
+ * @brief   Read and write the digital pin bound at compile time by the port registers
+ * @author  Yunhui Fu (yhfudev@gmail.com)
+ * @version 1.0
+ * @date    2016-07-14
+ * @copyright GPL
+ */
+/**
+ * Usage:
+ *   digitalRead() and digitalWrite() look up the port and the bit of the pin in the tables
+ *   of the Arduino core in each call, about 50 cycles on AVR.
+ *   The FastPin<PIN> maps the pin to the port registers at compile time, so read() and
+ *   write() are single SBIS/SBI/CBI instructions. The pins of the ATmega328P/168 boards
+ *   (Uno, Nano, Pro Mini) are mapped, the other boards use digitalRead() and digitalWrite().
+ *   FastButton<PIN> and FastLEDBlink<PIN> are the Button and LEDBlink bound to the pins,
+ *   Button and LEDBlink are still used for the pins configured at runtime.
+ *
+ *   Example:
+ *     FastPin<13>::mode_output();
+ *     FastPin<13>::write(HIGH);
+ *     if (FastPin<3>::read() == LOW) {
+ *         // pressed
+ *     }
+ */
+
+#ifndef _FAST_GPIO_H
+#define _FAST_GPIO_H 1
+
+#include "sysport.h"
+
+#if defined(__AVR_ATmega328P__) || defined(__AVR_ATmega328__) || defined(__AVR_ATmega168__) || defined(__AVR_ATmega168P__) || defined(__AVR_ATmega88__) || defined(__AVR_ATmega48__)
+#define FASTGPIO_AVR_MX8 1
+#else
+#define FASTGPIO_AVR_MX8 0
+#endif
+
+#if FASTGPIO_AVR_MX8
+// digital pin 0-7: PORTD, 8-13: PORTB, 14-19 (A0-A5): PORTC
+template <uint8_t PIN>
+class FastPin {
+public:
+    static_assert (PIN < 20, "FastPin: not a digital pin of ATmega328P");
+
+    static inline uint8_t read (void) { return (in_reg() & mask()) ? HIGH : LOW; }
+    static inline void write (uint8_t value) {
+        if (value) {
+            out_reg() |= mask();
+        } else {
+            out_reg() &= ~mask();
+        }
+    }
+    // writing 1 to the PINx toggles the PORTx
+    static inline void toggle (void) { in_reg() = mask(); }
+    static inline void mode_output (void) { ddr_reg() |= mask(); }
+    static inline void mode_input (void) { ddr_reg() &= ~mask(); out_reg() &= ~mask(); }
+    static inline void mode_input_pullup (void) { ddr_reg() &= ~mask(); out_reg() |= mask(); }
+
+private:
+    static inline uint8_t mask (void) { return (PIN < 8) ? (1 << PIN) : ((PIN < 14) ? (1 << (PIN - 8)) : (1 << (PIN - 14))); }
+    static inline volatile uint8_t & in_reg (void) { return (PIN < 8) ? PIND : ((PIN < 14) ? PINB : PINC); }
+    static inline volatile uint8_t & out_reg (void) { return (PIN < 8) ? PORTD : ((PIN < 14) ? PORTB : PORTC); }
+    static inline volatile uint8_t & ddr_reg (void) { return (PIN < 8) ? DDRD : ((PIN < 14) ? DDRB : DDRC); }
+};
+
+#else
+// the Arduino core of the other boards, or the simulation on PC
+template <uint8_t PIN>
+class FastPin {
+public:
+    static inline uint8_t read (void) { return digitalRead (PIN); }
+    static inline void write (uint8_t value) { digitalWrite (PIN, value); }
+    static inline void toggle (void) { digitalWrite (PIN, (digitalRead (PIN) ? LOW : HIGH)); }
+    static inline void mode_output (void) { pinMode (PIN, OUTPUT); }
+    static inline void mode_input (void) { pinMode (PIN, INPUT); }
+    static inline void mode_input_pullup (void) { pinMode (PIN, INPUT_PULLUP); }
+};
+#endif
+
+#endif // _FAST_GPIO_H
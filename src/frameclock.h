@@ -0,0 +1,58 @@
+/**
+ * @file    frameclock.h
+ * @brief   Sample millis() once in each loop and share the time with all of the objects
+ * @author  Yunhui Fu (yhfudev@gmail.com)
+ * @version 1.0
+ * @date    2016-07-14
+ * @copyright GPL
+ */
+/**
+ * Usage:
+ *   Each millis() disables and enables the interrupts and copies 32 bits on AVR, and the objects
+ *   calling millis() by themselves see different time in the same loop.
+ *   The FrameClock samples millis() once at the beginning of the loop(), the time is passed to
+ *   update(now) of the objects, so all of them see the same time.
+ *
+ *   Example:
+ *     FrameClock clk;
+ *     Button butt;
+ *     LEDBlink led;
+ *     void butt_on_click(void * userdata, unsigned int times) {
+ *         led.start_blink (200, times, clk.now());
+ *     }
+ *     void loop(void) {
+ *         unsigned long now = clk.tick();
+ *         butt.update(now);
+ *         led.update(now);
+ *     }
+ */
+
+#ifndef _FRAME_CLOCK_H
+#define _FRAME_CLOCK_H 1
+
+#include "sysport.h"
+
+class FrameClock {
+public:
+    FrameClock () : time_frame(0), time_delta(0) {}
+
+    // sample millis() at the beginning of the loop, return the time
+    inline unsigned long tick (void) { return this->tick (millis()); }
+    // set the time of the frame, such as from the TimerInt or the ISR
+    inline unsigned long tick (unsigned long now) {
+        this->time_delta = now - this->time_frame;
+        this->time_frame = now;
+        return now;
+    }
+    // the time of the current frame
+    inline unsigned long now (void) const { return this->time_frame; }
+    // the time(ms) from the previous frame
+    inline unsigned long delta (void) const { return this->time_delta; }
+
+private:
+    unsigned long time_frame;
+    unsigned long time_delta;
+};
+
+#endif // _FRAME_CLOCK_H
+
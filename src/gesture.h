@@ -0,0 +1,212 @@
+/**
+ * @file    gesture.h
+ * @brief   Recognize the sequences of the clicks and the holds of one button, such as click-click-hold
+ * @author  Yunhui Fu (yhfudev@gmail.com)
+ * @version 1.0
+ * @date    2016-07-14
+ * @copyright GPL
+ */
+/**
+ * Usage:
+ *   The Button reports the clicks and the long presses, but not the mixed sequences.
+ *   The GestureRecognizer<NODES> gets the debounced level of one button, turns each press into
+ *   a symbol, '.' if it's released before hold_ms (click), '-' once it's held for hold_ms (hold),
+ *   and walks a trie of all of the added patterns by the symbols, so all of the patterns are matched
+ *   in one pass. A gesture is reported:
+ *     1) at once, if its pattern is not the prefix of any other pattern,
+ *     2) otherwise, when the button is released for gap_ms without a new press.
+ *   The sequences not added are ignored until the button is released for gap_ms.
+ *   The trie takes 3 bytes for each node, and a pattern takes at most one node for each symbol.
+ *   The levels can be debounced by the Debouncer (debounce.h), or be read from a switch without bounces.
+ *
+ *   Example:
+ *     #define CMD_DOUBLE 1
+ *     #define CMD_TRIPLE 2
+ *     #define CMD_CLICK_CLICK_HOLD 3
+ *     GestureRecognizer<8> gestures;
+ *     Debouncer<uint8_t> db;
+ *     void on_gesture(uint8_t id) { ... }
+ *     void setup(void) {
+ *         gestures.add ("..", CMD_DOUBLE);
+ *         gestures.add ("...", CMD_TRIPLE);
+ *         gestures.add ("..-", CMD_CLICK_CLICK_HOLD);
+ *         gestures.on_gesture (Delegate<void(uint8_t)>::from_function<on_gesture>());
+ *     }
+ *     void loop(void) {
+ *         // sample the pin every 5 ms
+ *         db.update (digitalRead (2) == LOW);
+ *         gestures.update (db.get_state() & 0x01);
+ *     }
+ */
+
+#ifndef _GESTURE_H
+#define _GESTURE_H 1
+
+#include "sysport.h"
+#include "tick.h"
+#include "delegate.h"
+#include "buttonfsm.h"
+
+// the symbols of the patterns
+#define GESTURE_SYM_CLICK '.'
+#define GESTURE_SYM_HOLD  '-'
+
+template <uint8_t NODES>
+class GestureRecognizer {
+public:
+    static_assert ((NODES > 0) && (NODES < 255), "GestureRecognizer: 1 to 254 nodes");
+
+    GestureRecognizer ();
+
+    // add the pattern of '.' and '-' as the gesture id (1 to 255), return -1 on error
+    int add (const char * pattern, uint8_t id);
+    // hold_ms: the press to be a hold, gap_ms: the release to end the sequence
+    inline void set_timeouts (uint16_t hold_ms1, uint16_t gap_ms1) { this->hold_ms = hold_ms1; this->gap_ms = gap_ms1; }
+    inline void on_gesture (const Delegate<void(uint8_t)> & dg) { this->OnGesture = dg; }
+
+    // the debounced level of the button, return true if a sequence is in process
+    inline bool update (bool pressed) { return this->update (pressed, millis()); }
+    bool update (bool pressed, unsigned long now);
+    // drop the current sequence
+    inline void reset (void) { this->node = 0; this->dead = false; }
+
+private:
+    static const uint8_t NONE = 0; // no child, the root is not a child
+
+    void step (uint8_t sym);
+    void fire (uint8_t id);
+
+    // the trie, node 0 is the root
+    uint8_t next[NODES][2];  // the child of the click and the hold
+    uint8_t gesture[NODES];  // the id of the gesture ended at the node, 0 if none
+    uint8_t num_nodes;
+
+    uint16_t hold_ms;
+    uint16_t gap_ms;
+
+    uint8_t node;    // the current node
+    bool dead;       // the sequence is not in the trie, wait for the end
+    bool pressed;    // the last level
+    bool hold_sent;  // the hold symbol of the current press is sent
+    tick_t t_edge;   // the time of the last press or release
+
+    Delegate<void(uint8_t)> OnGesture;
+};
+
+template <uint8_t NODES>
+GestureRecognizer<NODES>::GestureRecognizer ()
+: num_nodes(1)
+, hold_ms(BUTSW_TIMEOUT_LONG)
+, gap_ms(BUTSW_TIMEOUT_2CLICK)
+, node(0)
+, dead(false)
+, pressed(false)
+, hold_sent(false)
+, t_edge(0)
+{
+    this->next[0][0] = this->next[0][1] = NONE;
+    this->gesture[0] = 0;
+}
+
+template <uint8_t NODES>
+int
+GestureRecognizer<NODES>::add (const char * pattern, uint8_t id)
+{
+    uint8_t n = 0;
+    uint8_t sym;
+    if ((nullptr == pattern) || (0 == *pattern) || (0 == id)) {
+        return -1;
+    }
+    for (; *pattern; pattern ++) {
+        switch (*pattern) {
+        case GESTURE_SYM_CLICK:
+            sym = 0;
+            break;
+        case GESTURE_SYM_HOLD:
+            sym = 1;
+            break;
+        default:
+            return -1;
+        }
+        if (NONE == this->next[n][sym]) {
+            if (this->num_nodes >= NODES) {
+                return -1;
+            }
+            this->next[n][sym] = this->num_nodes;
+            n = this->num_nodes;
+            this->num_nodes ++;
+            this->next[n][0] = this->next[n][1] = NONE;
+            this->gesture[n] = 0;
+        } else {
+            n = this->next[n][sym];
+        }
+    }
+    this->gesture[n] = id;
+    return 0;
+}
+
+template <uint8_t NODES>
+void
+GestureRecognizer<NODES>::fire (uint8_t id)
+{
+    if (this->OnGesture.is_set()) {
+        this->OnGesture (id);
+    }
+}
+
+template <uint8_t NODES>
+void
+GestureRecognizer<NODES>::step (uint8_t sym)
+{
+    uint8_t n;
+    if (this->dead) {
+        return;
+    }
+    n = this->next[this->node][sym];
+    if (NONE == n) {
+        // not a prefix of any pattern
+        this->dead = true;
+        return;
+    }
+    this->node = n;
+    if ((NONE == this->next[n][0]) && (NONE == this->next[n][1])) {
+        // no longer pattern to be confused with, the rest of the sequence is ignored
+        this->dead = true;
+        this->fire (this->gesture[n]);
+    }
+}
+
+template <uint8_t NODES>
+bool
+GestureRecognizer<NODES>::update (bool pressed1, unsigned long now)
+{
+    tick_t t = tick_from (now);
+    if (pressed1 != this->pressed) {
+        this->pressed = pressed1;
+        if ((! pressed1) && (! this->hold_sent)) {
+            this->step (0);
+        }
+        this->hold_sent = false;
+        this->t_edge = t;
+    }
+    if (this->pressed) {
+        if ((! this->hold_sent) && (tick_elapsed (t, this->t_edge) >= this->hold_ms)) {
+            this->hold_sent = true;
+            this->step (1);
+        }
+        return true;
+    }
+    if ((this->node != 0) || this->dead) {
+        if (tick_elapsed (t, this->t_edge) < this->gap_ms) {
+            return true;
+        }
+        // the end of the sequence
+        if ((! this->dead) && this->gesture[this->node]) {
+            this->fire (this->gesture[this->node]);
+        }
+        this->reset ();
+    }
+    return false;
+}
+
+#endif // _GESTURE_H
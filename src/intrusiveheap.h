@@ -0,0 +1,143 @@
+/**
+ * @file    intrusiveheap.h
+ * @brief   Fixed capacity intrusive binary heap without dynamic memory
+ * @author  Yunhui Fu (yhfudev@gmail.com)
+ * @version 1.0
+ * @date    2016-07-14
+ * @copyright GPL
+ */
+/**
+ * Usage:
+ *   The intrusive_heap stores the pointers of the elements, and each element keeps
+ *   its position in the heap in the member heap_idx, so an element can be removed or
+ *   re-ordered after its key changed in O(log n) without searching.
+ *   The top() is the least element by Less::operator()(const T *, const T *).
+ *
+ *   Example:
+ *     struct Job {
+ *         unsigned long deadline;
+ *         uint8_t heap_idx;
+ *     };
+ *     struct JobLess {
+ *         bool operator() (const Job * a, const Job * b) const { return (long)(a->deadline - b->deadline) < 0; }
+ *     };
+ *     intrusive_heap<Job, 8, JobLess> jobs;
+ *     Job j1, j2;
+ *     j1.deadline = 300; jobs.push (&j1);
+ *     j2.deadline = 100; jobs.push (&j2);
+ *     jobs.top(); // &j2
+ *     j2.deadline = 500; jobs.update (&j2);
+ *     jobs.top(); // &j1
+ *     jobs.remove (&j1);
+ */
+
+#ifndef _INTRUSIVE_HEAP_H
+#define _INTRUSIVE_HEAP_H 1
+
+#include "sysport.h"
+
+template <typename T, unsigned int N, typename Less>
+class intrusive_heap {
+public:
+    intrusive_heap () : num(0) {}
+
+    inline unsigned int size (void) const { return this->num; }
+    inline unsigned int capacity (void) const { return N; }
+    inline bool empty (void) const { return (this->num == 0); }
+    inline bool full (void) const { return (this->num >= N); }
+    inline void clear (void) { this->num = 0; }
+    // the least element, the heap should not be empty
+    inline T * top (void) { return this->buf[0]; }
+    // if the element is in this heap
+    inline bool contains (const T * p) const { return ((unsigned int)(p->heap_idx) < this->num) && (this->buf[p->heap_idx] == p); }
+
+    // add an element, return false if the heap is full
+    bool push (T * p) {
+        if (this->num >= N) {
+            return false;
+        }
+        this->buf[this->num] = p;
+        p->heap_idx = this->num;
+        this->num ++;
+        this->sift_up (this->num - 1);
+        return true;
+    }
+
+    // remove and return the least element, nullptr if empty
+    T * pop (void) {
+        if (this->num < 1) {
+            return nullptr;
+        }
+        T * p = this->buf[0];
+        this->remove_at (0);
+        return p;
+    }
+
+    // remove an element in the heap
+    inline void remove (T * p) { this->remove_at (p->heap_idx); }
+
+    // re-order the element after its key changed
+    inline void update (T * p) {
+        if (! this->sift_up (p->heap_idx)) {
+            this->sift_down (p->heap_idx);
+        }
+    }
+
+private:
+    unsigned int num;
+    T * buf[N];
+    Less less;
+
+    inline void place (unsigned int i, T * p) {
+        this->buf[i] = p;
+        p->heap_idx = i;
+    }
+
+    void remove_at (unsigned int i) {
+        this->num --;
+        if (i < this->num) {
+            this->place (i, this->buf[this->num]);
+            if (! this->sift_up (i)) {
+                this->sift_down (i);
+            }
+        }
+    }
+
+    // return true if the element moved
+    bool sift_up (unsigned int i) {
+        T * p = this->buf[i];
+        unsigned int i0 = i;
+        while (i > 0) {
+            unsigned int parent = (i - 1) / 2;
+            if (! this->less (p, this->buf[parent])) {
+                break;
+            }
+            this->place (i, this->buf[parent]);
+            i = parent;
+        }
+        this->place (i, p);
+        return (i != i0);
+    }
+
+    void sift_down (unsigned int i) {
+        T * p = this->buf[i];
+        for (;;) {
+            unsigned int child = i * 2 + 1;
+            if (child >= this->num) {
+                break;
+            }
+            if ((child + 1 < this->num) && this->less (this->buf[child + 1], this->buf[child])) {
+                child ++;
+            }
+            if (! this->less (this->buf[child], p)) {
+                break;
+            }
+            this->place (i, this->buf[child]);
+            i = child;
+        }
+        this->place (i, p);
+    }
+};
+
+#endif // _INTRUSIVE_HEAP_H
+
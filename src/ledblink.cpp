@@ -9,11 +9,8 @@
 
 #include "sysport.h"
 #include "ledblink.h"
-
-/**
-TODO:
-timer and callback to change the LED directly.
-*/
+#include "timerint.h"
+#include "scheduler.h"
 
 #ifndef TRACE
 #define TRACE(...)
@@ -63,7 +60,7 @@ static const PROGMEM uint8_t etable[256] = {
 
 #if DEBUG
 void
-LEDBlink::check_integrate (void)
+LEDBlinkBase::check_integrate (void)
 {
     if (this->color_first == this->color_last) {
         if (this->times_onoff > 0) {
@@ -80,9 +77,12 @@ LEDBlink::check_integrate (void)
 #define LEDB_CHECK_INTEGRATE()
 #endif
 
-LEDBlink::LEDBlink()
+LEDBlinkBase::LEDBlinkBase()
 {
     this->pin = 0;
+    this->sched = nullptr;
+    this->sched_id = -1;
+    this->timers = nullptr;
 
     this->interval = 0;
     this->last_step_time = 0;
@@ -98,6 +98,68 @@ LEDBlink::LEDBlink()
     LEDB_CHECK_INTEGRATE();
 }
 
+void
+LEDBlinkBase::set_timer (TimerInt * timers1, step_fn_t step)
+{
+    this->stop_timer();
+    this->timers = timers1;
+    if (this->timers) {
+        this->timer_id = -1;
+        if (this->is_busy()) {
+            this->start_timer (this->timers->get_time(), step);
+        }
+    } else {
+        this->last_step_time = tick_from (millis());
+    }
+}
+
+// the LED is added to the scheduler, activate it if it's polled and busy
+void
+LEDBlinkBase::activate_sched ()
+{
+    if ((! this->timers) && this->is_busy()) {
+        this->sched->activate (this->sched_id);
+    }
+}
+
+// the step of the periodic timer
+int8_t
+LEDBlinkBase::step_level ()
+{
+    // the steps merged when the loop is late
+    unsigned int n = 1 + this->timers->get_overrun (this->timer_id);
+    int8_t level = this->advance_ms ((unsigned long)this->interval * n);
+    if (! this->is_busy()) {
+        this->stop_timer();
+    }
+    return level;
+}
+
+// start the steps of the blinking or fading, the interval should be set
+void
+LEDBlinkBase::start_timer (unsigned long now, step_fn_t step)
+{
+    if (! this->timers) {
+        this->last_step_time = tick_from (now);
+        if (this->sched) {
+            // polled by update() until it's finished
+            this->sched->activate (this->sched_id);
+        }
+        return;
+    }
+    this->stop_timer();
+    this->timer_id = this->timers->start_periodic (this->interval, this, step, TIMERINT_CATCHUP_COALESCE);
+}
+
+void
+LEDBlinkBase::stop_timer ()
+{
+    if (this->timers && (this->timer_id >= 0)) {
+        this->timers->cancel (this->timer_id);
+        this->timer_id = -1;
+    }
+}
+
 bool
 is_in_range_8b (uint8_t a, uint8_t b, uint8_t v)
 {
@@ -108,20 +170,20 @@ is_in_range_8b (uint8_t a, uint8_t b, uint8_t v)
     }
 }
 
-void
-LEDBlink::set_value(int value)
+int8_t
+LEDBlinkBase::value_level(int value)
 {
     LEDB_CHECK_INTEGRATE();
 
     if (! this->pin) {
         TRACE3 ("LEDBlink setvalue failed, pin not set!");
-        return;
+        return LEDBLINK_LEVEL_NONE;
     }
     if (is_fade()) {
         uint8_t color = (uint8_t)constrain(value, 0, 255);
         if (color == this->color_pre) {
             TRACE3 ("LEDBlink ignore the same color as previous: %d!", (int)color);
-            return;
+            return LEDBLINK_LEVEL_NONE;
         }
         TRACE0 ("LEDBlink set pin(%d)=%d by analogWrite", (int)this->pin, (int)value);
         analogWrite(pin, READ_ETAB(color));
@@ -131,14 +193,17 @@ LEDBlink::set_value(int value)
             LEDB_CHECK_INTEGRATE();
         }
     } else {
+        // written by the caller
         TRACE0 ("LEDBlink set pin(%d)=%d by digitalWrite", (int)this->pin, (int)value);
-        digitalWrite (this->pin, (value?HIGH:LOW));
+        LEDB_CHECK_INTEGRATE();
+        return (value?HIGH:LOW);
     }
     LEDB_CHECK_INTEGRATE();
+    return LEDBLINK_LEVEL_NONE;
 }
 
 bool
-LEDBlink::is_busy()
+LEDBlinkBase::is_busy()
 {
     LEDB_CHECK_INTEGRATE();
 
@@ -155,45 +220,47 @@ LEDBlink::is_busy()
     return false;
 }
 
-void
-LEDBlink::stop()
+int8_t
+LEDBlinkBase::stop_level()
 {
+    int8_t level;
     LEDB_CHECK_INTEGRATE();
 
     if (is_fade() || is_fade_prev()) {
-        this->set_value (this->color_last);
+        level = this->value_level (this->color_last);
         this->color_first = this->color_last;
     } else {
-        this->set_value (LOW);
+        level = this->value_level (LOW);
         this->color_first = 0;
         this->color_last = 0;
     }
     this->times_onoff = 0;
     this->tm_accum = this->tm_length;
+    this->stop_timer();
+    return level;
 }
 
-void
-LEDBlink::start_blink(unsigned long time_ms, unsigned int times_onoff)
+int8_t
+LEDBlinkBase::start_blink_level(unsigned long time_ms, unsigned int times_onoff, unsigned long now, step_fn_t step)
 {
     LEDB_CHECK_INTEGRATE();
 
     // No pin defined
     if (! this->pin) {
         TRACE3 ("LEDBlink start failed, pin not set!");
-        return;
+        return LEDBLINK_LEVEL_NONE;
     }
 
     this->color_first = 0;
     this->color_last = 0;
-    this->tm_length = time_ms;
+    this->tm_length = tick_span (time_ms);
     this->tm_accum = 0;
-    this->last_step_time = millis();
+    this->stop_timer();
 
     if (time_ms <= LEDBLINK_MIN_INTERVAL) {
-        set_value (LOW);
         TRACE3 ("LEDBlink time too short!");
         LEDB_CHECK_INTEGRATE();
-        return;
+        return this->value_level (LOW);
     }
 
     this->times_onoff = times_onoff;
@@ -208,14 +275,16 @@ LEDBlink::start_blink(unsigned long time_ms, unsigned int times_onoff)
     if (this->interval < LEDBLINK_MIN_INTERVAL) {
         this->interval = LEDBLINK_MIN_INTERVAL;
     }
-    if (this->tm_length < this->interval * 3) {
+    if (this->tm_length < (unsigned long)this->interval * 3) {
         this->tm_length = this->interval * 3;
     }
+    this->start_timer (now, step);
     LEDB_CHECK_INTEGRATE();
+    return LEDBLINK_LEVEL_NONE;
 }
 
-void
-LEDBlink::start_fade(unsigned long time_ms, uint8_t pwm_first, uint8_t pwm_last)
+int8_t
+LEDBlinkBase::start_fade_level(unsigned long time_ms, uint8_t pwm_first, uint8_t pwm_last, unsigned long now, step_fn_t step)
 {
     LEDB_CHECK_INTEGRATE();
 
@@ -225,18 +294,18 @@ LEDBlink::start_fade(unsigned long time_ms, uint8_t pwm_first, uint8_t pwm_last)
     // No pin defined
     if (! this->pin) {
         TRACE3 ("LEDBlink start failed, pin not set!");
-        return;
+        return LEDBLINK_LEVEL_NONE;
     }
 
     if (time_ms <= LEDBLINK_MIN_INTERVAL) {
         TRACE3 ("LEDBlink time too short!");
-        return;
+        // the last blink or fade is not continued
+        return this->stop_level();
     }
 
     this->times_onoff = 0;
-    this->tm_length = time_ms;
+    this->tm_length = tick_span (time_ms);
     this->tm_accum = 0;
-    this->last_step_time = millis();
 
     this->color_first = (uint8_t)constrain(pwm_first, 0, 255);
     this->color_last  = (uint8_t)constrain(pwm_last, 0, 255);
@@ -248,25 +317,34 @@ LEDBlink::start_fade(unsigned long time_ms, uint8_t pwm_first, uint8_t pwm_last)
     if (this->interval < LEDBLINK_MIN_INTERVAL) {
         this->interval = LEDBLINK_MIN_INTERVAL;
     }
+    this->start_timer (now, step);
 
     LEDB_CHECK_INTEGRATE();
+    return LEDBLINK_LEVEL_NONE;
 }
 
 
-bool
-LEDBlink::advance_ms(unsigned int time_diff)
+// return the last digital level set in the step
+int8_t
+LEDBlinkBase::advance_ms(unsigned long time_diff)
 {
-    this->tm_accum += time_diff;
+    int8_t level = LEDBLINK_LEVEL_NONE;
+    // the time beyond the length is dropped anyway
+    if (time_diff >= (unsigned long)(this->tm_length - this->tm_accum)) {
+        this->tm_accum = this->tm_length;
+    } else {
+        this->tm_accum += time_diff;
+    }
     if (this->tm_accum >= this->tm_length) {
         if (is_fade()) {
-            this->set_value (this->color_last);
+            level = this->value_level (this->color_last);
             this->color_first = this->color_last;
             this->tm_accum = this->tm_length;
             //LEDB_CHECK_INTEGRATE();
         } else {
             this->tm_accum = 0;
             //LEDB_CHECK_INTEGRATE();
-            set_value(LOW);
+            level = this->value_level (LOW);
             this->times_onoff --;
             if (this->times_onoff < 1) {
                 this->tm_accum = this->tm_length;
@@ -277,7 +355,7 @@ LEDBlink::advance_ms(unsigned int time_diff)
     if (! is_busy()) {
         TRACE0 ("LEDBlink task was finished, Skip update!");
         //LEDB_CHECK_INTEGRATE();
-        return false;
+        return level;
     }
 
     if (is_fade()) {
@@ -292,27 +370,37 @@ LEDBlink::advance_ms(unsigned int time_diff)
             color -= incval;
             TRACE0 ("LEDBlink fade color down pin:%d -%d --> %d", (int)this->pin, (int)incval, (int)color);
         }
-        set_value(color);
+        level = this->value_level (color);
         //LEDB_CHECK_INTEGRATE();
     } else {
         if (0 == ((this->tm_accum / this->interval) % (3) )) {
             // off
             TRACE0 ("LEDBlink OFF");
-            set_value(LOW);
+            level = this->value_level (LOW);
             //LEDB_CHECK_INTEGRATE();
         } else {
             // on
             TRACE0 ("LEDBlink ON");
-            set_value(HIGH);
+            level = this->value_level (HIGH);
             //LEDB_CHECK_INTEGRATE();
         }
     }
+    return level;
+}
+
+bool
+LEDBlinkBase::next_deadline (unsigned long & deadline)
+{
+    if ((! this->pin) || this->timers || (! is_busy())) {
+        return false;
+    }
+    deadline = tick_to_ms (this->last_step_time + this->interval, millis());
     return true;
 }
 
 // update the led by checking the time.
 bool
-LEDBlink::update()
+LEDBlinkBase::update_level(unsigned long now, int8_t & level)
 {
     LEDB_CHECK_INTEGRATE();
 
@@ -328,22 +416,22 @@ LEDBlink::update()
         LEDB_CHECK_INTEGRATE();
         return false;
     }
-
-    unsigned long now = millis();
-    unsigned int time_diff = now;
-    if (now >= this->last_step_time) {
-        time_diff = now - this->last_step_time;
+    if (this->timers) {
+        // stepped by the timers
+        return true;
     }
 
+    tick_t time_diff = tick_elapsed (tick_from (now), this->last_step_time);
+
     // Interval hasn't passed yet
     if (time_diff < this->interval) {
         LEDB_CHECK_INTEGRATE();
         return true;
     }
 
-    this->advance_ms (time_diff);
+    level = this->advance_ms (time_diff);
 
-    this->last_step_time = now;
+    this->last_step_time = tick_from (now);
 
     LEDB_CHECK_INTEGRATE();
     return true;
@@ -30,38 +30,59 @@
  *         led_pwm.update();
  *         led_nopwm.update();
  *     }
+ *
+ *   The steps of blinking and fading are checked by millis() in each update() by default.
+ *   To avoid the polling, set a shared TimerInt, the steps are driven by a periodic timer
+ *   on it, and update() is not needed:
+ *     TimerInt timers;
+ *     void setup(void) {
+ *         led_nopwm.set_pin(LED_BUILTIN);
+ *         led_nopwm.set_timer(&timers);
+ *         led_nopwm.start_blink(500, 200000);
+ *     }
+ *     void loop(void) {
+ *         timers.expire();
+ *     }
+ *
+ *   The steps are computed by LEDBlinkBase (ledblink.cpp), which returns the level of the blinking,
+ *   and LEDBlinkT<Derived> writes it by Derived::write_level(), so the writes are direct calls
+ *   without any pointer in the object: LEDBlink writes by digitalWrite(), FastLEDBlink<PIN> by FastPin<PIN>.
  */
 
 #ifndef _LED_BLINK_H
 #define _LED_BLINK_H
 
-class LEDBlink {
+#include "tick.h"
+#include "fastgpio.h"
+#include "scheduler.h"
+
+class TimerInt;
+
+// no digital level to write, the fading is written by analogWrite()
+#define LEDBLINK_LEVEL_NONE (-1)
+
+// The minimum time (milliseconds) the program will wait between LED adjustments
+// adjust this to modify performance.
+#define LEDBLINK_MIN_INTERVAL 20
+
+// the steps of the blinking and fading, the digital level is returned to the caller to write
+class LEDBlinkBase {
 public:
-    LEDBlink ();
+    LEDBlinkBase ();
 
     // Set the digital pin that the LED is connected to
     inline void set_pin(uint8_t pwm_pin) { this->pin = pwm_pin; }
     inline uint8_t get_pin(void) { return pin; }
 
-    // Blink an LED over a duration of time time_ms(milliseconds) with times_onoff times.
-    void start_blink(unsigned long time_ms, unsigned int times_onoff);
-    // Stop the current work where it's at
-    void stop();
-    // fade an LED with a range of PWM value over a duration of milliseconds
-    void start_fade(unsigned long time_ms, uint8_t pwm_first, uint8_t pwm_last);
-
     // Returns TRUE if there is an active blinking process
     bool is_busy();
 
-    // Update the LEDs along the blinking
-    // Returns TRUE if a blink is still in process
-    bool update();
+    // the time(millis) of the next step to be checked by update(), return false if nothing to wait
+    // the steps driven by the TimerInt are not included
+    bool next_deadline(unsigned long & deadline);
 
     // Returns how much of the blink is complete in a percentage between 0 - 100
-    inline uint8_t get_progress() { return this->tm_accum * 100 / this->tm_length; }
-
-    // // Set an LED to an absolute PWM value or status
-    void set_value(int value);
+    inline uint8_t get_progress() { return (unsigned long)this->tm_accum * 100 / this->tm_length; }
 
     inline bool is_blinking () { if (this->times_onoff > 0) { return true; } return false; }
     inline bool is_fade () { if ((this->color_first == this->color_last)) { return false; } return true; }
@@ -70,15 +91,40 @@ public:
     void check_integrate (void);
 #endif
 
-private:
-    inline bool is_fade_prev () { if (this->color_last > 0) return true; return false; }
-    bool advance_ms(unsigned int time_diff);
+protected:
+    typedef void (* step_fn_t)(void * userdata);
+
+    // the same as the public functions of LEDBlinkT, return the digital level to write, or LEDBLINK_LEVEL_NONE
+    // step: the callback of the periodic timer
+    void set_timer(TimerInt * timers, step_fn_t step);
+    int8_t value_level(int value);
+    int8_t stop_level();
+    int8_t start_blink_level(unsigned long time_ms, unsigned int times_onoff, unsigned long now, step_fn_t step);
+    int8_t start_fade_level(unsigned long time_ms, uint8_t pwm_first, uint8_t pwm_last, unsigned long now, step_fn_t step);
+    bool update_level(unsigned long now, int8_t & level);
+    // the step of the periodic timer
+    int8_t step_level();
+    void activate_sched();
 
     uint8_t pin;
-    unsigned long last_step_time;
-    unsigned long interval;
-    unsigned long tm_accum;
-    unsigned long tm_length;
+    int8_t sched_id;
+    Scheduler * sched;
+    TimerInt * timers; // the shared timers, nullptr if polled by update()
+
+private:
+    inline bool is_fade_prev () { if (this->color_last > 0) return true; return false; }
+    int8_t advance_ms(unsigned long time_diff);
+    void start_timer(unsigned long now, step_fn_t step);
+    void stop_timer();
+
+    union {
+        tick_t last_step_time; // the time of the last step if polled
+        int timer_id; // the id of the periodic timer in timers, -1 if not started
+    };
+    // the durations are limited to TICK_MAX_SPAN
+    tick_t interval;
+    tick_t tm_accum;
+    tick_t tm_length;
 
     unsigned int times_onoff; // for blinking
     uint8_t color_first;      // for fading
@@ -87,9 +133,96 @@ private:
     uint8_t color_pre; // last color set
 };
 
-// The minimum time (milliseconds) the program will wait between LED adjustments
-// adjust this to modify performance.
-#define LEDBLINK_MIN_INTERVAL 20
+// the blinking and fading written by Derived::write_level(uint8_t level)
+template <class Derived>
+class LEDBlinkT : public LEDBlinkBase {
+public:
+    // step the LED by a periodic timer on the timers instead of polling millis(), nullptr to poll
+    inline void set_timer(TimerInt * timers1) { LEDBlinkBase::set_timer (timers1, &LEDBlinkT::cb_step); }
+    // add the LED as a task of the scheduler, it's activated when a blink or fade starts
+    void set_scheduler(Scheduler * sched1) {
+        if (this->sched) {
+            this->sched->remove (this);
+        }
+        this->sched = sched1;
+        this->sched_id = -1;
+        if (this->sched) {
+            this->sched_id = this->sched->add_task (static_cast<Derived *>(this));
+            this->activate_sched ();
+        }
+    }
 
-#endif // _LED_BLINK_H
+    // Blink an LED over a duration of time time_ms(milliseconds) with times_onoff times.
+    inline void start_blink(unsigned long time_ms, unsigned int times_onoff) { this->start_blink (time_ms, times_onoff, (this->timers ? 0 : millis())); }
+    inline void start_blink(unsigned long time_ms, unsigned int times_onoff, unsigned long now) { this->write (this->start_blink_level (time_ms, times_onoff, now, &LEDBlinkT::cb_step)); }
+    // Stop the current work where it's at
+    inline void stop() { this->write (this->stop_level ()); }
+    // fade an LED with a range of PWM value over a duration of milliseconds
+    inline void start_fade(unsigned long time_ms, uint8_t pwm_first, uint8_t pwm_last) { this->start_fade (time_ms, pwm_first, pwm_last, (this->timers ? 0 : millis())); }
+    inline void start_fade(unsigned long time_ms, uint8_t pwm_first, uint8_t pwm_last, unsigned long now) { this->write (this->start_fade_level (time_ms, pwm_first, pwm_last, now, &LEDBlinkT::cb_step)); }
 
+    // Update the LEDs along the blinking
+    // Returns TRUE if a blink is still in process
+    inline bool update() {
+        // millis() is only needed when it's polled and busy
+        if (this->timers || (! this->pin) || (! this->is_busy())) {
+            return this->update ((unsigned long)0);
+        }
+        return this->update (millis());
+    }
+    // same as above, with the time(millis) sampled once for all of the objects in the loop
+    inline bool update(unsigned long now) {
+        int8_t level = LEDBLINK_LEVEL_NONE;
+        bool ret = this->update_level (now, level);
+        this->write (level);
+        return ret;
+    }
+
+    // // Set an LED to an absolute PWM value or status
+    inline void set_value(int value) { this->write (this->value_level (value)); }
+
+private:
+    inline void write (int8_t level) {
+        if (LEDBLINK_LEVEL_NONE != level) {
+            static_cast<Derived *>(this)->write_level ((uint8_t)level);
+        }
+    }
+    static void cb_step (void * userdata) {
+        LEDBlinkT * pled = (LEDBlinkT *)userdata;
+        pled->write (pled->step_level ());
+    }
+};
+
+/**
+ * The LED on the pin set at runtime, the blinking is written by digitalWrite()
+ */
+class LEDBlink : public LEDBlinkT<LEDBlink> {
+public:
+    LEDBlink () {}
+
+private:
+    friend class LEDBlinkT<LEDBlink>;
+    inline void write_level (uint8_t level) { digitalWrite (this->pin, level); }
+};
+
+/**
+ * The LEDBlink bound to the pin at compile time, the blinking is written by the port register,
+ * the fading still uses analogWrite()
+ *   FastLEDBlink<13> led;
+ *   void setup(void) {
+ *       FastPin<13>::mode_output();
+ *   }
+ */
+template <uint8_t PIN>
+class FastLEDBlink : public LEDBlinkT<FastLEDBlink<PIN> > {
+public:
+    FastLEDBlink () { LEDBlinkBase::set_pin (PIN); }
+
+private:
+    friend class LEDBlinkT<FastLEDBlink<PIN> >;
+    static inline void write_level (uint8_t level) { FastPin<PIN>::write (level); }
+    // the pin is fixed
+    void set_pin (uint8_t pwm_pin);
+};
+
+#endif // _LED_BLINK_H
@@ -0,0 +1,271 @@
+/**
+ * @file    pinedge.cpp
+ * @brief   Capture the pin changes with the time stamps by the pin change interrupts
+ * @author  Yunhui Fu (yhfudev@gmail.com)
+ * @version 1.0
+ * @date    2016-07-14
+ * @copyright GPL
+ */
+
+#include "sysport.h"
+#include "pinedge.h"
+
+#if defined(__AVR__)
+#include <avr/interrupt.h>
+#endif
+
+#ifndef TRACE
+#define TRACE(...)
+#endif
+
+// 0 -- verbose, 1 -- info, 2 -- warning, 3 -- error
+#define TRACE0 TRACE
+#define TRACE1 TRACE
+#define TRACE2 TRACE
+#define TRACE3 TRACE
+
+#if 1
+#undef TRACE0
+#define TRACE0(...)
+#undef TRACE1
+#define TRACE1(...)
+#endif
+
+PinEdges::PinEdges()
+{
+    this->overflow = 0;
+    this->num_pins = 0;
+#if defined(__AVR__)
+    uint8_t i;
+    for (i = 0; i < PINEDGE_PCINT_GROUPS; i ++) {
+        this->group_reg[i] = nullptr;
+        this->group_mask[i] = 0;
+        this->group_last[i] = 0;
+    }
+#endif
+}
+
+#if defined(__AVR__) && defined(digitalPinToPCICR)
+static PinEdges * volatile g_pinedge_hw = nullptr;
+#endif
+
+int
+PinEdges::attach (uint8_t pin, const Delegate<void(uint8_t, unsigned long)> & dg)
+{
+    uint8_t i;
+#if defined(__AVR__) && defined(digitalPinToPCICR)
+    // check the pin before it's added
+    if (nullptr == digitalPinToPCICR (pin)) {
+        TRACE3 ("PinEdges: no pin change interrupt on pin %d", pin);
+        return -1;
+    }
+    uint8_t group = digitalPinToPCICRbit (pin);
+    uint8_t bitmask = digitalPinToBitMask (pin);
+    volatile uint8_t * reg = portInputRegister (digitalPinToPort (pin));
+    uint8_t bit;
+    if (group >= PINEDGE_PCINT_GROUPS) {
+        return -1;
+    }
+    if ((this->group_reg[group]) && (this->group_reg[group] != reg)) {
+        // the pins of the group are in different ports
+        TRACE3 ("PinEdges: pin %d is not in the port of the group %d", pin, group);
+        return -1;
+    }
+#endif
+    for (i = 0; i < this->num_pins; i ++) {
+        if (this->pins[i] == pin) {
+            break;
+        }
+    }
+    if (i >= this->num_pins) {
+        if (this->num_pins >= PINEDGE_MAX_PINS) {
+            TRACE3 ("PinEdges: too many pins");
+            return -1;
+        }
+        this->num_pins ++;
+    }
+    this->pins[i] = pin;
+    this->callbacks[i] = dg;
+
+#if defined(__AVR__) && defined(digitalPinToPCICR)
+    for (bit = 0; (bit < 7) && (0 == (bitmask & (1 << bit))); bit ++);
+    uint8_t sreg_saved = SREG;
+    cli();
+    this->group_reg[group] = reg;
+    this->group_pins[group][bit] = pin;
+    if (0 == (this->group_mask[group] & bitmask)) {
+        this->group_last[group] = (this->group_last[group] & ~bitmask) | (*reg & bitmask);
+    }
+    this->group_mask[group] |= bitmask;
+    *digitalPinToPCMSK (pin) |= _BV(digitalPinToPCMSKbit (pin));
+    if ((g_pinedge_hw == this) && (0 == (PCICR & _BV(group)))) {
+        // attached after attach_hw()
+        this->group_last[group] = *reg;
+        PCIFR = _BV(group);
+        PCICR |= _BV(group);
+    }
+    SREG = sreg_saved;
+#endif
+    return 0;
+}
+
+void
+PinEdges::detach (uint8_t pin)
+{
+    uint8_t i;
+    for (i = 0; i < this->num_pins; i ++) {
+        if (this->pins[i] == pin) {
+            break;
+        }
+    }
+    if (i >= this->num_pins) {
+        return;
+    }
+#if defined(__AVR__) && defined(digitalPinToPCICR)
+    uint8_t sreg_saved = SREG;
+    cli();
+    *digitalPinToPCMSK (pin) &= ~_BV(digitalPinToPCMSKbit (pin));
+    if (digitalPinToPCICRbit (pin) < PINEDGE_PCINT_GROUPS) {
+        this->group_mask[digitalPinToPCICRbit (pin)] &= ~digitalPinToBitMask (pin);
+    }
+    SREG = sreg_saved;
+#endif
+    // the edges of the pin in the ring are ignored by dispatch()
+    this->num_pins --;
+    this->pins[i] = this->pins[this->num_pins];
+    this->callbacks[i] = this->callbacks[this->num_pins];
+}
+
+unsigned int
+PinEdges::dispatch (unsigned long now_ms, unsigned long now_us)
+{
+    unsigned int cnt = 0;
+    uint8_t i;
+    long age;
+    pinedge_t e;
+    while (this->edges.pop (e)) {
+        cnt ++;
+        // the age is wrap safe, and the edges pushed after now_us are not in the future
+        age = (long)(now_us - e.time_us);
+        if (age < 0) {
+            age = 0;
+        }
+        for (i = 0; i < this->num_pins; i ++) {
+            if (this->pins[i] == e.pin) {
+                TRACE0 ("PinEdges: pin %d level %d at %lu us", e.pin, e.level, e.time_us);
+                if (this->callbacks[i].is_set()) {
+                    this->callbacks[i] (e.level, now_ms - (unsigned long)age / 1000);
+                }
+                break;
+            }
+        }
+    }
+    return cnt;
+}
+
+#if defined(__AVR__) && defined(digitalPinToPCICR)
+void
+PinEdges::isr_group (uint8_t group)
+{
+    volatile uint8_t * reg = this->group_reg[group];
+    uint8_t val;
+    uint8_t changed;
+    uint8_t bit;
+    unsigned long t;
+    if (nullptr == reg) {
+        return;
+    }
+    t = micros();
+    val = *reg;
+    changed = (val ^ this->group_last[group]) & this->group_mask[group];
+    this->group_last[group] = val;
+    for (bit = 0; changed; bit ++, changed >>= 1) {
+        if (changed & 1) {
+            this->isr_push (this->group_pins[group][bit], ((val >> bit) & 1) ? HIGH : LOW, t);
+        }
+    }
+}
+
+#if PINEDGE_DEFINE_ISR
+#if defined(PCINT0_vect)
+ISR(PCINT0_vect)
+{
+    if (g_pinedge_hw) {
+        g_pinedge_hw->isr_group (0);
+    }
+}
+#endif
+#if defined(PCINT1_vect) && (PINEDGE_PCINT_GROUPS > 1)
+ISR(PCINT1_vect)
+{
+    if (g_pinedge_hw) {
+        g_pinedge_hw->isr_group (1);
+    }
+}
+#endif
+#if defined(PCINT2_vect) && (PINEDGE_PCINT_GROUPS > 2)
+ISR(PCINT2_vect)
+{
+    if (g_pinedge_hw) {
+        g_pinedge_hw->isr_group (2);
+    }
+}
+#endif
+#endif // PINEDGE_DEFINE_ISR
+
+int
+PinEdges::attach_hw (void)
+{
+    uint8_t i;
+    if (g_pinedge_hw) {
+        return -1;
+    }
+    uint8_t sreg_saved = SREG;
+    cli();
+    g_pinedge_hw = this;
+    for (i = 0; i < PINEDGE_PCINT_GROUPS; i ++) {
+        if (this->group_mask[i]) {
+            this->group_last[i] = *(this->group_reg[i]);
+            PCIFR = _BV(i); // clear the pending flag
+            PCICR |= _BV(i);
+        }
+    }
+    SREG = sreg_saved;
+    return 0;
+}
+
+void
+PinEdges::detach_hw (void)
+{
+    uint8_t i;
+    if (g_pinedge_hw != this) {
+        return;
+    }
+    uint8_t sreg_saved = SREG;
+    cli();
+    for (i = 0; i < PINEDGE_PCINT_GROUPS; i ++) {
+        if (this->group_mask[i]) {
+            PCICR &= ~_BV(i);
+        }
+    }
+    g_pinedge_hw = nullptr;
+    SREG = sreg_saved;
+}
+
+#else
+// on PC (or the boards without the pin change interrupts) the edges are pushed by isr_push()
+int
+PinEdges::attach_hw (void)
+{
+#if defined(ARDUINO)
+    return -1;
+#else
+    return 0;
+#endif
+}
+
+void
+PinEdges::detach_hw (void)
+{
+}
+#endif
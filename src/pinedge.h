@@ -0,0 +1,143 @@
+/**
+ * @file    pinedge.h
+ * @brief   Capture the pin changes with the time stamps by the pin change interrupts
+ * @author  Yunhui Fu (yhfudev@gmail.com)
+ * @version 1.0
+ * @date    2016-07-14
+ * @copyright GPL
+ */
+/**
+ * Usage:
+ *   The Button polls the level of the pin in update(), the changes between two polls
+ *   are lost if the loop() is slower than the bounce or the click, and each update() reads the pin.
+ *   The PinEdges records each change of the attached pins as (pin, level, micros()) in a lock-free
+ *   ring from the pin change interrupt (PCINT on AVR), and dispatch() in the loop() passes
+ *   the edges in order to the callbacks of the pins, such as Button::on_edge(), with the time
+ *   of the edge in millis(), so the debounce and the long press are timed by the time stamps
+ *   of the edges instead of the time of the poll.
+ *   The edges are dropped and counted by get_overflow() if the ring is full.
+ *   On PC, a thread calls isr_push() to stand in for the interrupt.
+ *   dispatch() should be called before the update() of the objects in the loop().
+ *   On AVR the sketch defines the ISR of the pin change group of its pins, which calls isr_group(),
+ *   so the other vectors are left to the other libraries (such as SoftwareSerial);
+ *   or build with PINEDGE_DEFINE_ISR=1 to define the ISRs of all of the groups in the library.
+ *
+ *   Example:
+ *     PinEdges edges;
+ *     Button butt;
+ *     void setup(void) {
+ *         pinMode(PORT_SWITCH, INPUT_PULLUP);
+ *         butt.set_pin (PORT_SWITCH, LOW);
+ *         butt.set_edges (&edges); // attach the pin of the button
+ *         edges.attach_hw ();
+ *     }
+ *     ISR(PCINT0_vect) { // the group of PORT_SWITCH, pins 8 to 13 on UNO
+ *         edges.isr_group (0);
+ *     }
+ *     void loop(void) {
+ *         edges.dispatch ();
+ *         butt.update (); // only check the timeouts
+ *     }
+ */
+
+#ifndef _PIN_EDGE_H
+#define _PIN_EDGE_H 1
+
+#include "sysport.h"
+#include "ringbuffer.h"
+#include "delegate.h"
+
+// the size of the ring of the edges, a power of 2
+#ifndef PINEDGE_QUEUE_SIZE
+#if defined(__AVR__)
+#define PINEDGE_QUEUE_SIZE  16
+#else
+#define PINEDGE_QUEUE_SIZE 256
+#endif
+#endif
+
+// the max number of the attached pins
+#ifndef PINEDGE_MAX_PINS
+#if defined(__AVR__)
+#define PINEDGE_MAX_PINS  8
+#else
+#define PINEDGE_MAX_PINS 32
+#endif
+#endif
+
+// the number of the pin change interrupt groups (PCINT0_vect ...) on AVR
+#ifndef PINEDGE_PCINT_GROUPS
+#define PINEDGE_PCINT_GROUPS 3
+#endif
+
+// 1 -- the library defines the ISRs of the pin change groups, 0 -- the sketch defines the ISRs it needs
+#ifndef PINEDGE_DEFINE_ISR
+#define PINEDGE_DEFINE_ISR 0
+#endif
+
+typedef struct _pinedge_t {
+    uint8_t pin;
+    uint8_t level;         // the level after the change, HIGH or LOW
+    unsigned long time_us; // micros() of the change
+} pinedge_t;
+
+class PinEdges {
+public:
+    PinEdges ();
+
+    // pass the edges of the pin to dg (the level and the time in millis()) in dispatch(), return -1 on error
+    int attach (uint8_t pin, const Delegate<void(uint8_t, unsigned long)> & dg);
+    void detach (uint8_t pin);
+
+    // enable the pin change interrupts of the attached pins, return 0 on success, -1 on error
+    // on AVR the ISRs calling isr_group() are defined by the sketch, unless PINEDGE_DEFINE_ISR
+    int attach_hw (void);
+    void detach_hw (void);
+
+    // pass the queued edges to the callbacks in order, return the number of the edges
+    inline unsigned int dispatch (void) { return (this->edges.empty() ? 0 : this->dispatch (millis(), micros())); }
+    // same as above, now_ms and now_us are the current millis() and micros(),
+    // the time of each edge is now_ms - the age of the edge
+    unsigned int dispatch (unsigned long now_ms, unsigned long now_us);
+    inline bool empty (void) const { return this->edges.empty(); }
+    // the number of the edges dropped because the ring is full
+    inline uint16_t get_overflow (void) const { return this->overflow; }
+
+    // called by the ISR (or the thread on PC): record the change of the pin
+    inline bool isr_push (uint8_t pin, uint8_t level, unsigned long time_us) {
+        pinedge_t e;
+        e.pin = pin;
+        e.level = level;
+        e.time_us = time_us;
+        if (! this->edges.push (e)) {
+            if (this->overflow < 0xFFFF) {
+                this->overflow = this->overflow + 1;
+            }
+            return false;
+        }
+        return true;
+    }
+    inline bool isr_push (uint8_t pin, uint8_t level) { return this->isr_push (pin, level, micros()); }
+#if defined(__AVR__)
+    // called by the ISR of the pin change group: compare the port with the last levels
+    void isr_group (uint8_t group);
+#endif
+
+private:
+    ring_buffer<pinedge_t, PINEDGE_QUEUE_SIZE> edges;
+    volatile uint16_t overflow;
+
+    uint8_t num_pins;
+    uint8_t pins[PINEDGE_MAX_PINS];
+    Delegate<void(uint8_t, unsigned long)> callbacks[PINEDGE_MAX_PINS];
+
+#if defined(__AVR__)
+    // the port and the pins of each pin change group
+    volatile uint8_t * group_reg[PINEDGE_PCINT_GROUPS]; // the input register of the port
+    uint8_t group_mask[PINEDGE_PCINT_GROUPS];  // the bits of the attached pins in the port
+    volatile uint8_t group_last[PINEDGE_PCINT_GROUPS]; // the levels of the last interrupt
+    uint8_t group_pins[PINEDGE_PCINT_GROUPS][8]; // the pin of each bit of the port
+#endif
+};
+
+#endif // _PIN_EDGE_H
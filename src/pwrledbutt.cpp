@@ -106,42 +106,117 @@ PowerLedButton::blink_led (int type)
         // fadeled.blink( uint32_t duration, uint32_t pause_duration, uint16_t repeat_count = ATM_COUNTER_OFF )
         // fadeled.fade( int fade ), the speed time each fade step takes in milliseconds. 32 steps
         TRACE0("set led WAITON");
+        this->led_active = true;
         this->led.blink( 1, 1 ).fade(1024, 0, 255);//fade(10);
         this->bit_fade.trigger( this->bit_fade.EVT_ON );
         break;
     case PWRLEDBUTT_LEDT_WAITOFF:
         TRACE0("set led WAITOFF");
+        this->led_active = true;
         this->led.blink( 1, 1 ).fade(512, 0, 255);//fade(5);
         this->bit_fade.trigger( this->bit_fade.EVT_ON );
         break;
     case PWRLEDBUTT_LEDT_STANDBY:
         TRACE0("set led STANDBY");
+        this->led_active = true;
         this->led.blink( 1, 1 ).fade(2300, 0, 88);//fade(25);
         this->bit_fade.trigger( this->bit_fade.EVT_ON );
         break;
     case PWRLEDBUTT_LEDT_ON:
         TRACE0("set led ON");
+        this->led_active = false;
         this->bit_butt.trigger( this->bit_fade.EVT_ON );
         break;
     case PWRLEDBUTT_LEDT_OFF:
         TRACE0("set led OFF");
+        this->led_active = false;
         this->bit_fade.trigger( this->bit_fade.EVT_OFF );
         this->bit_butt.trigger( this->bit_butt.EVT_OFF );
         break;
     }
 }
 
+PowerLedButton * PowerLedButton::instances[PWRLEDBUTT_MAX_INSTANCES] = { nullptr };
+
 PowerLedButton::PowerLedButton()
 : userdata(nullptr)
 , cb_poweron(nullptr)
 , cb_shutdown(nullptr)
 , cb_forceoff(nullptr)
+, cb_sleep(nullptr)
+, inst_idx(-1)
+, timer_start(0)
+, timer_period(0)
+, led_active(false)
+, butt_hold(false)
 {
 }
 
 void
+PowerLedButton::set_user_data (void * userdata1)
+{
+    this->userdata = userdata1;
+}
+
+void
+PowerLedButton::bind_obj (void * obj)
+{
+    if (nullptr == obj) {
+        // the free function
+        return;
+    }
+    if (this->userdata && (this->userdata != obj)) {
+        TRACE2 ("PowerLedButton: the callbacks are bound to another object");
+    }
+    this->userdata = obj;
+}
+
+// get the index of the object passed to the callbacks of the Automaton
+int
+PowerLedButton::register_instance (void)
+{
+    int i;
+    if (this->inst_idx >= 0) {
+        return this->inst_idx;
+    }
+    for (i = 0; i < PWRLEDBUTT_MAX_INSTANCES; i ++) {
+        if (nullptr == PowerLedButton::instances[i]) {
+            PowerLedButton::instances[i] = this;
+            this->inst_idx = i;
+            return i;
+        }
+    }
+    TRACE3 ("PowerLedButton: too many objects, increase PWRLEDBUTT_MAX_INSTANCES!");
+    return -1;
+}
+
+bool
+PowerLedButton::next_deadline (unsigned long & deadline)
+{
+    return this->next_deadline (deadline, millis());
+}
+
+bool
+PowerLedButton::next_deadline (unsigned long & deadline, unsigned long now)
+{
+    if (this->led_active || this->butt_hold) {
+        deadline = now;
+        return true;
+    }
+    if (this->timer_period < 1) {
+        return false;
+    }
+    // the next one of the repeated timer
+    deadline = this->timer_start + this->timer_period * (1 + (now - this->timer_start) / this->timer_period);
+    return true;
+}
+
+int
 PowerLedButton::setup(void)
 {
+    if (this->register_instance() < 0) {
+        return -1;
+    }
     // INPUT_PULLUP mode
     // callback(int idx, int v, int up):
     //   idx--the value passed by the second parameter of onPress( callback, <idx> );
@@ -156,10 +231,11 @@ PowerLedButton::setup(void)
 []( int idx, int v, int up )
 {
     PowerLedButton * pthis;
-    pthis = (PowerLedButton *)idx;
+    pthis = PowerLedButton::from_index (idx);
     if (v < 0) {
         if (v == -1) {
             TRACE0 ("ATM button down");
+            pthis->butt_hold = true;
             pthis->bit_butt.trigger( pthis->bit_butt.EVT_ON );
             // onbegin
             StateMachine::Event ev(PWRLEDBUTT_EVT_ONBEGIN);
@@ -168,6 +244,7 @@ PowerLedButton::setup(void)
     } else if (v > 0) {
         // onend
         TRACE0 ("ATM button up");
+        pthis->butt_hold = false;
         pthis->bit_butt.trigger( pthis->bit_butt.EVT_OFF );
         StateMachine::Event ev(PWRLEDBUTT_EVT_ONEND);
         pthis->add_event (ev);
@@ -191,7 +268,7 @@ PowerLedButton::setup(void)
         }
     }
 }
-                  , (int)this)
+                  , this->inst_idx)
         ;
 
     this->bit_butt.begin();
@@ -213,6 +290,7 @@ PowerLedButton::setup(void)
 #endif
      // start the standby state
      enter_standby();
+     return 0;
 }
 
 // told the class that host is off now
@@ -261,6 +339,7 @@ PowerLedButton::process_event (StateMachine::Event &ev)
         case PWRLEDBUTT_EVT_ENTER_STANDBY:
             // stop any timer
             this->timer.stop();
+            this->timer_period = 0;
             // start timer 1: the time stay in standby before enter to sleep mode
             //    the next timer 2 would be the time before call on_sleep
             TRACE0("Setup 1st timer for SLP1, tm=", (this->get_timeout_sleep()));
@@ -270,25 +349,28 @@ PowerLedButton::process_event (StateMachine::Event &ev)
                        // Something to do when the timer goes off
                        if (v == 1) {
                            PowerLedButton *pthis;
-                           pthis = (PowerLedButton *)idx;
+                           pthis = PowerLedButton::from_index (idx);
                            StateMachine::Event ev(PWRLEDBUTT_EVT_TIMEOUT_SLEEP1);
                            pthis->add_event (ev);
                        }
-                   }, (int)this)
+                   }, this->inst_idx)
                .onFinish( [] ( int idx, int v, int up ) {
                        // Something to do when the timer goes off
                        PowerLedButton *pthis;
-                       pthis = (PowerLedButton *)idx;
+                       pthis = PowerLedButton::from_index (idx);
                        TRACE0 ("ATM timeout SLP1");
                        StateMachine::Event ev(PWRLEDBUTT_EVT_TIMEOUT_SLEEP2);
                        pthis->add_event (ev);
-                   }, (int)this)
+                   }, this->inst_idx)
                .start();
+            this->track_timer (get_timeout_sleep()/10);
             break;
         case PWRLEDBUTT_EVT_TIMEOUT_SLEEP1:
             this->blink_led (PWRLEDBUTT_LEDT_OFF);
             break;
         case PWRLEDBUTT_EVT_TIMEOUT_SLEEP2:
+            // the repeated timer finished
+            this->timer_period = 0;
             TRACE0 ("PowerLedButton: CB sleep");
             if (this->cb_sleep) {
                 this->cb_sleep (this->userdata);
@@ -297,6 +379,7 @@ PowerLedButton::process_event (StateMachine::Event &ev)
 
         case PWRLEDBUTT_EVT_ONBEGIN:
             this->timer.stop();
+            this->timer_period = 0;
             TRACE0 ("PowerLedButton: CB poweron");
             if (this->cb_poweron) {
                 this->cb_poweron (this->userdata);
@@ -309,6 +392,7 @@ PowerLedButton::process_event (StateMachine::Event &ev)
             break;
         case PWRLEDBUTT_EVT_ONSIGRDY:
             this->timer.stop();
+            this->timer_period = 0;
             TRACE0 ("PowerLedButton: CB poweron");
             if (this->cb_poweron) {
                 this->cb_poweron (this->userdata);
@@ -381,11 +465,12 @@ PowerLedButton::process_event (StateMachine::Event &ev)
                                // Something to do when the timer goes off
                                TRACE0 ("ATM timeout");
                                PowerLedButton *pthis;
-                               pthis = (PowerLedButton *)idx;
+                               pthis = PowerLedButton::from_index (idx);
                                StateMachine::Event ev(PWRLEDBUTT_EVT_TIMEOUT_SHUTDOWN);
                                pthis->add_event (ev);
-                           }, (int)this)
+                           }, this->inst_idx)
                        .start();
+            this->track_timer (get_timeout_shutdown());
             blink_led (PWRLEDBUTT_LEDT_WAITOFF);
             this->next_state(PWRLEDBUTT_STATE_SHUTDOWN);
             break;
@@ -405,6 +490,7 @@ PowerLedButton::process_event (StateMachine::Event &ev)
         case PWRLEDBUTT_EVT_TIMEOUT_SHUTDOWN:
         case PWRLEDBUTT_EVT_ONLONG:
             this->timer.stop();
+            this->timer_period = 0;
             TRACE0 ("PowerLedButton: CB forced off");
             if (this->cb_forceoff) {
                 this->cb_forceoff (this->userdata);
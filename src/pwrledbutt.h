@@ -57,6 +57,7 @@
 
 #include "sysport.h"
 #include "statemachine.h"
+#include "delegate.h"
 
 // int event( int id ); return if there's event that generate the event id
 // void action( int id ); do the action by the id
@@ -76,6 +77,11 @@
 
 #endif
 
+#ifndef PWRLEDBUTT_MAX_INSTANCES
+// the number of the objects, which are passed to the callbacks of the Automaton by the index
+#define PWRLEDBUTT_MAX_INSTANCES 2
+#endif
+
 class PowerLedButton : public StateMachine {
 public:
 
@@ -84,13 +90,20 @@ public:
     inline void set_led (uint8_t pwm_pin) { this->led.begin (pwm_pin); }
     inline void set_butt (uint8_t digital_pin) { this->butt.begin(digital_pin); }
 
-    inline void set_user_data (void * userdata1) { this->userdata = userdata1; }
+    // the userdata passed to the C callbacks, before or after they are set
+    void set_user_data (void * userdata1);
     inline void on_poweron ( void (*function)(void * userdata) ) { this->cb_poweron = function; }
     inline void on_shutdown ( void (*function)(void * userdata) ) { this->cb_shutdown = function; }
     inline void on_force_off ( void (*function)(void * userdata) ) { this->cb_forceoff = function; }
     inline void on_sleep ( void (*function)(void * userdata) ) { this->cb_sleep = function; }
+    // the member functions, the functors or the free functions,
+    // all of the callbacks share one object: the object of the delegate replaces the userdata
+    inline void on_poweron (const Delegate<void()> & dg) { this->cb_poweron = dg.get_stub(); this->bind_obj (dg.get_obj()); }
+    inline void on_shutdown (const Delegate<void()> & dg) { this->cb_shutdown = dg.get_stub(); this->bind_obj (dg.get_obj()); }
+    inline void on_force_off (const Delegate<void()> & dg) { this->cb_forceoff = dg.get_stub(); this->bind_obj (dg.get_obj()); }
+    inline void on_sleep (const Delegate<void()> & dg) { this->cb_sleep = dg.get_stub(); this->bind_obj (dg.get_obj()); }
 
-    void setup (void); // prepare to ready
+    int setup (void); // prepare to ready, return -1 if there're more than PWRLEDBUTT_MAX_INSTANCES objects
 
     // user called:
     void signal_off (void);   // told the class that host is off now
@@ -104,12 +117,27 @@ public:
 #define PWRLEDBUTT_LEDT_OFF     5
     void blink_led (int type);
 
+    // the time(millis) of the next action, return false if nothing to wait
+    // it's the current time when the LED is fading or the button is held, which are driven by automaton.run()
+    bool next_deadline (unsigned long & deadline);
+    // same as above, with the time(millis) sampled once in the loop
+    bool next_deadline (unsigned long & deadline, unsigned long now);
+
 private:
-    void * userdata;
-    void (*cb_poweron)(void * userdata);
-    void (*cb_shutdown)(void * userdata);
-    void (*cb_forceoff)(void * userdata);
-    void (*cb_sleep)(void * userdata); // called when at standby more than 30 seconds
+    // the callbacks keep only the stubs, the object is shared
+    void bind_obj (void * obj);
+    void * userdata; // the userdata of the C callbacks, or the object of the delegates
+    Delegate<void()>::stub_t cb_poweron;
+    Delegate<void()>::stub_t cb_shutdown;
+    Delegate<void()>::stub_t cb_forceoff;
+    Delegate<void()>::stub_t cb_sleep; // called when at standby more than 30 seconds
+
+    // the callbacks of the Automaton only pass an int, which can't hold the pointer on 64-bit PC,
+    // so the index of the object in the table is passed instead
+    static PowerLedButton * instances[PWRLEDBUTT_MAX_INSTANCES];
+    static inline PowerLedButton * from_index (int idx) { return PowerLedButton::instances[idx]; }
+    int8_t inst_idx; // the index in instances[], -1 if not registered
+    int register_instance (void);
 
     Atm_button butt;
     Atm_fade led;
@@ -120,6 +148,13 @@ private:
     Atm_controller ctrl_3;
     Atm_timer timer;
 
+    // track the Atm_timer and the LED for next_deadline()
+    unsigned long timer_start;
+    unsigned long timer_period; // the period of the timer, 0 if stopped
+    bool led_active; // the LED is fading or blinking
+    bool butt_hold;
+    inline void track_timer (unsigned long period_ms) { this->timer_start = millis(); this->timer_period = period_ms; }
+
     inline unsigned long get_timeout_shutdown() { return PWRLEDBUTT_TIMEOUT_SHUTDOWN; }
     inline unsigned long get_timeout_sleep() { return PWRLEDBUTT_TIMEOUT_SLEEP; }
 
@@ -0,0 +1,96 @@
+/**
+ * @file    ringbuffer.h
+ * @brief   Fixed size lock-free single-producer/single-consumer ring buffer
+ * @author  Yunhui Fu (yhfudev@gmail.com)
+ * @version 1.0
+ * @date    2016-07-14
+ * @copyright GPL
+ */
+/**
+ * Usage:
+ *   The ring_buffer is wait-free when there is only one producer (for example an ISR)
+ *   and only one consumer (for example the loop()).
+ *   The capacity N should be a power of 2, and not larger than 128 on AVR,
+ *   so the indexes are single bytes which are read and written atomically.
+ *
+ *   Example:
+ *     ring_buffer<uint8_t, 16> g_keys;
+ *     ISR(PCINT0_vect) {
+ *         g_keys.push (PINB);
+ *     }
+ *     void loop(void) {
+ *         uint8_t val;
+ *         while (g_keys.pop (val)) {
+ *             // process the value
+ *         }
+ *     }
+ */
+
+#ifndef _RING_BUFFER_SPSC_H
+#define _RING_BUFFER_SPSC_H 1
+
+#include "sysport.h"
+
+#if defined(__AVR__)
+// single core, only prevent the compiler from re-ordering the memory accesses
+#define RINGBUF_BARRIER() __asm__ __volatile__ ("" ::: "memory")
+// the accesses after the load are not moved before it
+#define RINGBUF_LOAD_ACQ(var) ({ auto v = (var); RINGBUF_BARRIER(); v; })
+#define RINGBUF_STORE_REL(var, val) do { RINGBUF_BARRIER(); (var) = (val); } while (0)
+#else
+#define RINGBUF_LOAD_ACQ(var) __atomic_load_n (&(var), __ATOMIC_ACQUIRE)
+#define RINGBUF_STORE_REL(var, val) __atomic_store_n (&(var), (val), __ATOMIC_RELEASE)
+#endif
+
+// the type of the index, single byte if possible
+template <bool is_small> struct ring_buffer_index { typedef uint16_t type; };
+template <> struct ring_buffer_index<true> { typedef uint8_t type; };
+
+template <typename T, unsigned int N>
+class ring_buffer {
+public:
+    typedef typename ring_buffer_index<(N <= 128)>::type index_type;
+
+    ring_buffer () : head(0), tail(0) {}
+
+    // producer: add a value, return false if the buffer is full
+    inline bool push (const T & val) {
+        index_type h = this->head;
+        if ((index_type)(h - RINGBUF_LOAD_ACQ(this->tail)) >= N) {
+            return false;
+        }
+        this->buf[h & (N - 1)] = val;
+        RINGBUF_STORE_REL(this->head, (index_type)(h + 1));
+        return true;
+    }
+
+    // consumer: get a value, return false if the buffer is empty
+    inline bool pop (T & val) {
+        index_type t = this->tail;
+        if (t == RINGBUF_LOAD_ACQ(this->head)) {
+            return false;
+        }
+        val = this->buf[t & (N - 1)];
+        RINGBUF_STORE_REL(this->tail, (index_type)(t + 1));
+        return true;
+    }
+
+    // consumer: the first value, the buffer should not be empty
+    inline T & front (void) { return this->buf[this->tail & (N - 1)]; }
+
+    inline bool empty (void) const { return (this->head == this->tail); }
+    inline bool full (void) const { return ((index_type)(this->head - this->tail) >= N); }
+    inline unsigned int size (void) const { return (index_type)(this->head - this->tail); }
+    inline unsigned int capacity (void) const { return N; }
+
+private:
+    // the free running indexes, head is only written by the producer, tail only by the consumer
+    volatile index_type head;
+    volatile index_type tail;
+    T buf[N];
+
+    static_assert ((N & (N - 1)) == 0 && N > 0, "ring_buffer: N should be a power of 2");
+};
+
+#endif // _RING_BUFFER_SPSC_H
+
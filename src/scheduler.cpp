@@ -0,0 +1,200 @@
+/**
+ * @file    scheduler.cpp
+ * @brief   Query the next deadline of the objects and sleep until then
+ * @author  Yunhui Fu (yhfudev@gmail.com)
+ * @version 1.0
+ * @date    2016-07-14
+ * @copyright GPL
+ */
+
+#include "sysport.h"
+#include "scheduler.h"
+
+#if defined(__AVR__)
+#include <avr/sleep.h>
+#endif
+
+#ifndef TRACE
+#define TRACE(...)
+#endif
+
+// 0 -- verbose, 1 -- info, 2 -- warning, 3 -- error
+#define TRACE0 TRACE
+#define TRACE1 TRACE
+#define TRACE2 TRACE
+#define TRACE3 TRACE
+
+#if 1
+#undef TRACE0
+#define TRACE0(...)
+#endif
+
+Scheduler::Scheduler ()
+: num_free(0)
+, isr_lost(false)
+, woken(false)
+{
+}
+
+int
+Scheduler::add_obj (void * obj, deadline_fn_t fn_deadline, update_fn_t fn_update, bool always)
+{
+    Entry ent;
+    unsigned int i = this->objs.size();
+    ent.obj = obj;
+    ent.fn_deadline = fn_deadline;
+    ent.fn_update = fn_update;
+    ent.always = always;
+    ent.is_active = false;
+    if (this->num_free > 0) {
+        for (i = 0; i < this->objs.size(); i ++) {
+            if (nullptr == this->objs[i].obj) {
+                break;
+            }
+        }
+        this->objs[i] = ent;
+        this->num_free --;
+    } else if (! this->objs.push_back (ent)) {
+        TRACE3 ("Scheduler: no free entry!");
+        return -1;
+    }
+    if (always) {
+        this->activate (i);
+    }
+    return i;
+}
+
+int
+Scheduler::remove (void * obj)
+{
+    unsigned int i;
+    for (i = 0; i < this->objs.size(); i ++) {
+        if (this->objs[i].obj == obj) {
+            break;
+        }
+    }
+    if (i >= this->objs.size()) {
+        return -1;
+    }
+    if (this->objs[i].is_active) {
+        unsigned int j;
+        for (j = 0; j < this->active.size(); j ++) {
+            if (this->active[j] == i) {
+                this->active.erase_unordered (this->active.begin() + j);
+                break;
+            }
+        }
+    }
+    this->objs[i].obj = nullptr;
+    this->objs[i].is_active = false;
+    this->num_free ++;
+    return 0;
+}
+
+void
+Scheduler::activate (int id)
+{
+    if ((id < 0) || ((unsigned int)id >= this->objs.size())) {
+        return;
+    }
+    Entry & ent = this->objs[id];
+    if ((nullptr == ent.obj) || (nullptr == ent.fn_update) || ent.is_active) {
+        return;
+    }
+    ent.is_active = true;
+    this->active.push_back (id);
+}
+
+unsigned int
+Scheduler::run (unsigned long now)
+{
+    unsigned int i;
+    uint8_t id;
+    while (this->isr_queue.pop (id)) {
+        this->activate (id);
+    }
+    if (this->isr_lost) {
+        this->isr_lost = false;
+        for (i = 0; i < this->objs.size(); i ++) {
+            this->activate (i);
+        }
+    }
+    // the tasks activated by the update() are appended and also run in this round
+    i = 0;
+    while (i < this->active.size()) {
+        id = this->active[i];
+        Entry & ent = this->objs[id];
+        if (ent.fn_update (ent.obj, now) || ent.always) {
+            i ++;
+            continue;
+        }
+        // finished
+        ent.is_active = false;
+        this->active.erase_unordered (this->active.begin() + i);
+    }
+    return this->active.size();
+}
+
+bool
+Scheduler::next_deadline (unsigned long & deadline)
+{
+    bool ret = false;
+    unsigned long val;
+    unsigned int i;
+    for (i = 0; i < this->objs.size(); i ++) {
+        if (nullptr == this->objs[i].obj) {
+            continue;
+        }
+        if (! this->objs[i].fn_deadline (this->objs[i].obj, val)) {
+            continue;
+        }
+        if ((! ret) || ((long)(val - deadline) < 0)) {
+            deadline = val;
+            ret = true;
+        }
+    }
+    return ret;
+}
+
+unsigned long
+Scheduler::time_to_next (unsigned long now, unsigned long max_ms)
+{
+    unsigned long deadline;
+    if (! this->next_deadline (deadline)) {
+        return max_ms;
+    }
+    if ((long)(deadline - now) <= 0) {
+        return 0;
+    }
+    if (deadline - now > max_ms) {
+        return max_ms;
+    }
+    return deadline - now;
+}
+
+void
+Scheduler::idle (unsigned long max_ms)
+{
+    unsigned long now = millis();
+    unsigned long ms = this->time_to_next (now, max_ms);
+    if ((ms < 1) || (! this->isr_queue.empty())) {
+        return;
+    }
+    TRACE0 ("Scheduler: idle %lu ms", ms);
+#if defined(__AVR__)
+    // the Timer0 of millis() wakes up the CPU every 1 ms in the idle mode,
+    // so a wake() just before the sleep_mode() delays the loop at most 1 ms
+    set_sleep_mode (SLEEP_MODE_IDLE);
+    while ((! this->woken) && (millis() - now < ms)) {
+        sleep_mode ();
+    }
+#else
+    while ((! this->woken) && (ms > 0)) {
+        delay (1);
+        ms --;
+    }
+#endif
+    // the wake() before the idle() also breaks it, so it's cleared after
+    this->woken = false;
+}
+
@@ -0,0 +1,140 @@
+/**
+ * @file    scheduler.h
+ * @brief   Query the next deadline of the objects and sleep until then
+ * @author  Yunhui Fu (yhfudev@gmail.com)
+ * @version 1.0
+ * @date    2016-07-14
+ * @copyright GPL
+ */
+/**
+ * Usage:
+ *   The Scheduler keeps a list of the objects which have the method
+ *     bool next_deadline(unsigned long & deadline);
+ *   such as Button, LEDBlink, PowerLedButton and TimerInt, and returns the earliest
+ *   deadline of them, so the loop() can sleep until there's something to do
+ *   instead of polling millis() continuously.
+ *   The pin changes are not known by the objects, the ISR of the pin should call wake()
+ *   to break the sleep.
+ *
+ *   The objects which have the method bool update(unsigned long now) can be added as tasks by add_task(),
+ *   then run() only calls update() of the active tasks: a task is activated by activate()
+ *   (or activate_isr() in an ISR) when it starts some work, and is removed from the active list
+ *   when its update() returns false. The tasks added with always=true, such as a TimerInt or
+ *   the Buttons polling their pins, are updated in every run().
+ *   millis() is sampled once in run() and passed to all of the tasks.
+ *   Button and LEDBlink activate themselves after set_scheduler() is called:
+ *     Scheduler sched;
+ *     void setup(void) {
+ *         ...
+ *         butt.set_scheduler (&sched);
+ *         led.set_scheduler (&sched);
+ *     }
+ *     void loop(void) {
+ *         sched.run();
+ *         sched.idle(1000);
+ *     }
+ *
+ *   Example:
+ *     Button butt;
+ *     LEDBlink led;
+ *     Scheduler sched;
+ *     void on_pin_change(void) {
+ *         sched.wake();
+ *     }
+ *     void setup(void) {
+ *         ...
+ *         sched.add (&butt);
+ *         sched.add (&led);
+ *         attachInterrupt(digitalPinToInterrupt(PORT_SWITCH), on_pin_change, CHANGE);
+ *     }
+ *     void loop(void) {
+ *         butt.update();
+ *         led.update();
+ *         sched.idle(1000); // sleep at most 1 second
+ *     }
+ */
+
+#ifndef _SCHEDULER_IDLE_H
+#define _SCHEDULER_IDLE_H 1
+
+#include "sysport.h"
+#include "staticvector.h"
+#include "ringbuffer.h"
+
+// the max number of the objects
+#ifndef SCHEDULER_MAX_OBJS
+#if defined(__AVR__)
+#define SCHEDULER_MAX_OBJS  8
+#else
+#define SCHEDULER_MAX_OBJS 64
+#endif
+#endif
+#if SCHEDULER_MAX_OBJS > 127
+#error "SCHEDULER_MAX_OBJS should not be larger than 127, the ids are stored in int8_t"
+#endif
+
+// the size of the queue of the tasks activated by ISR, a power of 2
+#ifndef SCHEDULER_ISR_QUEUE
+#define SCHEDULER_ISR_QUEUE 8
+#endif
+
+class Scheduler {
+public:
+    Scheduler ();
+
+    // add an object which has the method bool next_deadline(unsigned long &), return the id, -1 on error
+    template <typename T> inline int add (T * obj) { return this->add_obj ((void *)obj, &Scheduler::thunk_deadline<T>); }
+    // add an object which also has the method bool update(unsigned long now), return the id of the task, -1 on error
+    // always: update the task in every run(), otherwise only when it's activated
+    template <typename T> inline int add_task (T * obj, bool always = false) { return this->add_obj ((void *)obj, &Scheduler::thunk_deadline<T>, &Scheduler::thunk_update<T>, always); }
+    // remove an object, return 0 on success, -1 if not found
+    int remove (void * obj);
+    // the number of the objects
+    inline unsigned int size (void) { return this->objs.size() - this->num_free; }
+
+    // put the task to the active list
+    void activate (int id);
+    // called by the ISR to activate the task, it's added to the active list in the next run()
+    inline void activate_isr (int id) { if (! this->isr_queue.push ((uint8_t)id)) { this->isr_lost = true; } this->woken = true; }
+    // call update(now) of the active tasks, return the number of the tasks still active
+    unsigned int run (unsigned long now);
+    inline unsigned int run (void) { return this->run (millis()); }
+    inline unsigned int num_active (void) { return this->active.size(); }
+
+    // the earliest deadline(millis) of the objects, return false if none of them is waiting
+    bool next_deadline (unsigned long & deadline);
+    // the time(ms) from now to the earliest deadline, max_ms if there's no deadline or it's later than max_ms
+    unsigned long time_to_next (unsigned long now, unsigned long max_ms);
+
+    // sleep (CPU idle) until the earliest deadline, at most max_ms, or wake() is called
+    void idle (unsigned long max_ms);
+    // break the idle(), called by the ISR such as pin change
+    inline void wake (void) { this->woken = true; }
+
+private:
+    typedef bool (* deadline_fn_t)(void * obj, unsigned long & deadline);
+    typedef bool (* update_fn_t)(void * obj, unsigned long now);
+    class Entry {
+    public:
+        void * obj; // nullptr if removed
+        deadline_fn_t fn_deadline;
+        update_fn_t fn_update; // nullptr if not a task
+        bool always;
+        bool is_active;
+    };
+    // the ids of the entries are the indexes, the removed ones are reused
+    static_vector<Entry, SCHEDULER_MAX_OBJS> objs;
+    uint8_t num_free;
+    // the ids of the active tasks
+    static_vector<uint8_t, SCHEDULER_MAX_OBJS> active;
+    ring_buffer<uint8_t, SCHEDULER_ISR_QUEUE> isr_queue;
+    volatile bool isr_lost; // the queue was full, activate all of the tasks
+    volatile bool woken;
+
+    int add_obj (void * obj, deadline_fn_t fn_deadline, update_fn_t fn_update = nullptr, bool always = false);
+    template <typename T> static bool thunk_deadline (void * obj, unsigned long & deadline) { return ((T *)obj)->next_deadline (deadline); }
+    template <typename T> static bool thunk_update (void * obj, unsigned long now) { return ((T *)obj)->update (now); }
+};
+
+#endif // _SCHEDULER_IDLE_H
+
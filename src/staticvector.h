@@ -0,0 +1,107 @@
+/**
+ * @file    staticvector.h
+ * @brief   Fixed capacity vector without dynamic memory
+ * @author  Yunhui Fu (yhfudev@gmail.com)
+ * @version 1.0
+ * @date    2016-07-14
+ * @copyright GPL
+ */
+/**
+ * Usage:
+ *   The static_vector has the similar interface of std::vector, but the elements are
+ *   stored in the object itself, the capacity N is fixed at compile time.
+ *   T should be default constructible, the elements beyond size() are not used.
+ *
+ *   Example:
+ *     static_vector<int, 8> vec;
+ *     vec.push_back (1);
+ *     vec.push_back (2);
+ *     for (static_vector<int, 8>::iterator it = vec.begin(); it != vec.end(); it ++) {
+ *         TRACE ("%d", *it);
+ *     }
+ */
+
+#ifndef _STATIC_VECTOR_H
+#define _STATIC_VECTOR_H 1
+
+#include "sysport.h"
+
+// the type of the number of the elements, single byte if possible
+template <bool is_small> struct static_vector_size { typedef unsigned int type; };
+template <> struct static_vector_size<true> { typedef uint8_t type; };
+
+template <typename T, unsigned int N>
+class static_vector {
+public:
+    typedef T value_type;
+    typedef T * iterator;
+    typedef const T * const_iterator;
+    typedef typename static_vector_size<(N < 256)>::type size_type;
+
+    static_vector () : num(0) {}
+
+    inline iterator begin (void) { return this->buf; }
+    inline iterator end (void) { return this->buf + this->num; }
+    inline const_iterator begin (void) const { return this->buf; }
+    inline const_iterator end (void) const { return this->buf + this->num; }
+
+    inline T & operator[] (unsigned int i) { return this->buf[i]; }
+    inline const T & operator[] (unsigned int i) const { return this->buf[i]; }
+    inline T & front (void) { return this->buf[0]; }
+    inline T & back (void) { return this->buf[this->num - 1]; }
+
+    inline unsigned int size (void) const { return this->num; }
+    inline unsigned int capacity (void) const { return N; }
+    inline bool empty (void) const { return (this->num == 0); }
+    inline bool full (void) const { return (this->num >= N); }
+    inline void clear (void) { this->num = 0; }
+
+    // append a value, return false if the vector is full
+    inline bool push_back (const T & val) {
+        if (this->num >= N) {
+            return false;
+        }
+        this->buf[this->num ++] = val;
+        return true;
+    }
+    inline void pop_back (void) {
+        if (this->num > 0) {
+            this->num --;
+        }
+    }
+
+    // insert the value before pos, return the position of the new value, end() if the vector is full
+    iterator insert (iterator pos, const T & val) {
+        if (this->num >= N) {
+            return this->end();
+        }
+        iterator it;
+        for (it = this->end(); it != pos; it --) {
+            *it = *(it - 1);
+        }
+        *pos = val;
+        this->num ++;
+        return pos;
+    }
+    // remove the value at pos, return the position of the next value
+    iterator erase (iterator pos) {
+        iterator it;
+        for (it = pos + 1; it != this->end(); it ++) {
+            *(it - 1) = *it;
+        }
+        this->num --;
+        return pos;
+    }
+    // remove the value at pos by moving the last one to pos, O(1) but not keep the order
+    inline void erase_unordered (iterator pos) {
+        *pos = this->back();
+        this->num --;
+    }
+
+private:
+    size_type num;
+    T buf[N];
+};
+
+#endif // _STATIC_VECTOR_H
+
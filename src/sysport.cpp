@@ -10,6 +10,7 @@
 #include "sysport.h"
 
 #if ! defined(ARDUINO)
+#include <time.h>
 
 // test time 60000 -- 60 seconds
 #define TIME_TEST 60000
@@ -27,6 +28,14 @@ millis0(void)
     return time_in_mill;
 }
 
+unsigned long
+micros(void)
+{
+    struct timespec ts;
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+    return (unsigned long)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
 static unsigned long m_tm_mill_pre = 1500;
 unsigned long
 millis(void)
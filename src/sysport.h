@@ -75,6 +75,8 @@
 #define dtostrf(val, width, prec, buf) sprintf (buf, "%" # width "." # prec "f", (val))
 
 extern unsigned long millis(void);
+// the real time in microseconds, not the simulated time of millis()
+extern unsigned long micros(void);
 
 #define LOW  0
 #define HIGH 1
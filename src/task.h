@@ -0,0 +1,309 @@
+/**
+ * @file    task.h
+ * @brief   Straight-line sequences of the LEDs and buttons, by protothread macros or C++20 coroutines
+ * @author  Yunhui Fu (yhfudev@gmail.com)
+ * @version 1.0
+ * @date    2016-07-14
+ * @copyright GPL
+ */
+/**
+ * Usage:
+ *   A sequence like "blink 6 times, then fade, then wait for the host with a 180 s timeout"
+ *   can be written as the straight-line code instead of the callbacks and the state machine.
+ *
+ *   1) The Task is a protothread: the update(now) of the subclass is wrapped by TASK_BEGIN()
+ *   and TASK_END(), and returns at each TASK_WAIT_xxx() until the condition is true.
+ *   The position is stored as the line number, so there should be only one TASK_xxx() in one line,
+ *   and the local variables are lost between the calls of update(), use the members instead.
+ *   A task takes 7 bytes of RAM on AVR. The update(now) returns false when the task finished, so it can be
+ *   added to the Scheduler by add_task(&task, true).
+ *
+ *   Example:
+ *     LEDBlink led;
+ *     TaskSignal sig_ready; // set by the button or the host
+ *     class BootSequence : public Task {
+ *     public:
+ *         bool update(unsigned long now) {
+ *             TASK_BEGIN();
+ *             led.start_blink (200, 6, now);
+ *             TASK_WAIT_UNTIL(! led.is_busy());
+ *             led.start_fade (1000, 0, 255, now);
+ *             TASK_WAIT_UNTIL(! led.is_busy());
+ *             TASK_WAIT_UNTIL_TIMEOUT(sig_ready.take(), 180000, now);
+ *             if (this->task_timed_out()) {
+ *                 led.start_blink (100, 10, now);
+ *             }
+ *             TASK_DELAY(500, now);
+ *             TASK_END();
+ *         }
+ *     };
+ *     BootSequence boot;
+ *     void loop(void) {
+ *         unsigned long now = millis();
+ *         led.update(now);
+ *         boot.update(now);
+ *     }
+ *
+ *   2) If the compiler supports the C++20 coroutines (TASK_USE_COROUTINE is 1), the function returning
+ *   CoTask can co_await task_sleep(ms), task_until(pred, timeout_ms) and task_wait(signal, timeout_ms).
+ *   The frame of the coroutine is allocated once when the function is called, and takes more RAM than the Task.
+ *
+ *   Example:
+ *     CoTask boot_sequence(void) {
+ *         led.start_blink (200, 6);
+ *         co_await task_until ([]{ return ! led.is_busy(); });
+ *         if (! co_await task_wait (sig_ready, 180000)) {
+ *             // timeout
+ *         }
+ *     }
+ *     CoTask boot = boot_sequence();
+ *     void loop(void) {
+ *         unsigned long now = millis();
+ *         led.update(now);
+ *         boot.update(now);
+ *     }
+ */
+
+#ifndef _TASK_SEQUENCE_H
+#define _TASK_SEQUENCE_H 1
+
+#include "sysport.h"
+
+// the event to be waited by the tasks, such as the callback of a button
+class TaskSignal {
+public:
+    TaskSignal () : num(0) {}
+    // can be bound to the callbacks: Delegate<void()>::from_method<TaskSignal, &TaskSignal::signal>(&sig)
+    inline void signal (void) { if (this->num < 255) { this->num = this->num + 1; } }
+    // same as above, for the clicks of the Button: Delegate<void(unsigned int)>
+    inline void signal_times (unsigned int times) { this->signal(); }
+    // consume one signal, return false if not signaled
+    inline bool take (void) { if (this->num < 1) { return false; } this->num = this->num - 1; return true; }
+    inline bool is_set (void) const { return (this->num > 0); }
+    inline void clear (void) { this->num = 0; }
+private:
+    volatile uint8_t num; // the number of the signals not taken
+};
+
+#define TASK_LC_DONE 0xFFFF
+
+// the flags of the timeout
+#define TASK_FLAG_ARMED    0x01
+#define TASK_FLAG_TIMEOUT  0x02
+
+class Task {
+public:
+    Task () : task_lc(0), task_flags(0), task_deadline(0) {}
+    // restart the task from the beginning
+    inline void task_reset (void) { this->task_lc = 0; this->task_flags = 0; }
+    inline bool task_is_done (void) const { return (TASK_LC_DONE == this->task_lc); }
+    // the time(millis) of the timeout being waited, return false if not waiting the time
+    inline bool next_deadline (unsigned long & deadline) {
+        if (! (this->task_flags & TASK_FLAG_ARMED)) {
+            return false;
+        }
+        deadline = this->task_deadline;
+        return true;
+    }
+    // if the last TASK_WAIT_UNTIL_TIMEOUT() was finished by the timeout
+    inline bool task_timed_out (void) const { return (this->task_flags & TASK_FLAG_TIMEOUT); }
+
+protected:
+    uint16_t task_lc; // the line of the current wait
+    uint8_t task_flags;
+    unsigned long task_deadline;
+
+    inline void task_arm (unsigned long ms, unsigned long now) {
+        this->task_deadline = now + ms;
+        this->task_flags = TASK_FLAG_ARMED;
+    }
+    // check the timeout armed by task_arm()
+    inline bool task_check_timeout (unsigned long now) {
+        if ((long)(now - this->task_deadline) < 0) {
+            return false;
+        }
+        this->task_flags |= TASK_FLAG_TIMEOUT;
+        return true;
+    }
+    inline void task_disarm (void) { this->task_flags &= ~TASK_FLAG_ARMED; }
+};
+
+// the body of bool update(unsigned long now)
+#define TASK_BEGIN() \
+    if (TASK_LC_DONE == this->task_lc) { return false; } \
+    switch (this->task_lc) { case 0:
+
+#define TASK_END() \
+    } \
+    this->task_lc = TASK_LC_DONE; \
+    return false
+
+// return and continue from here in the next update()
+#define TASK_YIELD() \
+    do { this->task_lc = __LINE__; return true; case __LINE__:; } while (0)
+
+#define TASK_WAIT_UNTIL(cond) \
+    do { this->task_lc = __LINE__; case __LINE__: if (! (cond)) { return true; } } while (0)
+
+// wait until the condition or the timeout(ms), check task_timed_out() after it
+#define TASK_WAIT_UNTIL_TIMEOUT(cond, ms, now) \
+    do { this->task_arm ((ms), (now)); TASK_WAIT_UNTIL ((cond) || this->task_check_timeout (now)); this->task_disarm (); } while (0)
+
+#define TASK_DELAY(ms, now) \
+    do { this->task_arm ((ms), (now)); TASK_WAIT_UNTIL (this->task_check_timeout (now)); this->task_disarm (); } while (0)
+
+// finish the task, update() returns false
+#define TASK_EXIT() \
+    do { this->task_lc = TASK_LC_DONE; this->task_disarm (); return false; } while (0)
+
+// start over in the next update()
+#define TASK_RESTART() \
+    do { this->task_reset (); return true; } while (0)
+
+#ifndef TASK_USE_COROUTINE
+#if defined(__cpp_impl_coroutine) && defined(__has_include)
+#if __has_include(<coroutine>)
+#define TASK_USE_COROUTINE 1
+#endif
+#endif
+#endif
+#ifndef TASK_USE_COROUTINE
+#define TASK_USE_COROUTINE 0
+#endif
+
+#if TASK_USE_COROUTINE
+#include <coroutine>
+
+class CoTask {
+public:
+    class promise_type {
+    public:
+        unsigned long now; // the time of the current update()
+        unsigned long deadline;
+        bool armed;
+        // the condition of the current co_await, nullptr if not waiting
+        bool (* check)(void * awaiter, promise_type & promise);
+        void * awaiter;
+
+        promise_type () : now(0), deadline(0), armed(false), check(nullptr), awaiter(nullptr) {}
+        CoTask get_return_object () { return CoTask (std::coroutine_handle<promise_type>::from_promise (*this)); }
+        std::suspend_always initial_suspend () noexcept { return {}; }
+        std::suspend_always final_suspend () noexcept { return {}; }
+        void return_void () {}
+        void unhandled_exception () {}
+
+        inline void arm (unsigned long ms) { this->deadline = this->now + ms; this->armed = true; }
+        inline bool is_expired (void) const { return this->armed && ((long)(this->now - this->deadline) >= 0); }
+    };
+    typedef std::coroutine_handle<promise_type> handle_t;
+
+    CoTask () : h(nullptr) {}
+    CoTask (CoTask && rhs) : h(rhs.h) { rhs.h = nullptr; }
+    CoTask & operator= (CoTask && rhs) {
+        if (this != &rhs) {
+            if (this->h) {
+                this->h.destroy ();
+            }
+            this->h = rhs.h;
+            rhs.h = nullptr;
+        }
+        return *this;
+    }
+    CoTask (const CoTask &) = delete;
+    CoTask & operator= (const CoTask &) = delete;
+    ~CoTask () { if (this->h) { this->h.destroy (); } }
+
+    // resume the coroutine if the condition of its co_await is met, return false if it finished
+    bool update (unsigned long now) {
+        if ((! this->h) || this->h.done ()) {
+            return false;
+        }
+        promise_type & p = this->h.promise ();
+        p.now = now;
+        if (p.check && (! p.check (p.awaiter, p))) {
+            return true;
+        }
+        p.check = nullptr;
+        this->h.resume ();
+        return ! this->h.done ();
+    }
+    inline bool is_done (void) const { return (! this->h) || this->h.done (); }
+    // the time(millis) of the timeout being waited, return false if not waiting the time
+    bool next_deadline (unsigned long & deadline) {
+        if (this->is_done () || (! this->h.promise ().armed)) {
+            return false;
+        }
+        deadline = this->h.promise ().deadline;
+        return true;
+    }
+
+private:
+    explicit CoTask (handle_t h1) : h(h1) {}
+    handle_t h;
+};
+
+// co_await task_sleep(ms)
+class task_sleep {
+public:
+    explicit task_sleep (unsigned long ms1) : ms(ms1), promise(nullptr) {}
+    bool await_ready () const noexcept { return (this->ms < 1); }
+    void await_suspend (CoTask::handle_t h) {
+        this->promise = &(h.promise ());
+        this->promise->arm (this->ms);
+        this->promise->check = &task_sleep::check;
+        this->promise->awaiter = this;
+    }
+    void await_resume () { if (this->promise) { this->promise->armed = false; } }
+private:
+    unsigned long ms;
+    CoTask::promise_type * promise;
+    static bool check (void * awaiter, CoTask::promise_type & p) { return p.is_expired (); }
+};
+
+// co_await task_until(pred, timeout_ms), return false if timeout, no timeout if timeout_ms is 0
+template <typename P>
+class TaskUntil {
+public:
+    TaskUntil (P pred1, unsigned long timeout1) : pred(pred1), timeout(timeout1), promise(nullptr), result(true) {}
+    bool await_ready () { return this->pred (); }
+    void await_suspend (CoTask::handle_t h) {
+        this->promise = &(h.promise ());
+        if (this->timeout > 0) {
+            this->promise->arm (this->timeout);
+        }
+        this->promise->check = &TaskUntil::check;
+        this->promise->awaiter = this;
+    }
+    bool await_resume () {
+        if (this->promise) {
+            this->promise->armed = false;
+        }
+        return this->result;
+    }
+private:
+    P pred;
+    unsigned long timeout;
+    CoTask::promise_type * promise;
+    bool result;
+    static bool check (void * awaiter, CoTask::promise_type & p) {
+        TaskUntil * self = (TaskUntil *)awaiter;
+        if (self->pred ()) {
+            return true;
+        }
+        if (p.is_expired ()) {
+            self->result = false;
+            return true;
+        }
+        return false;
+    }
+};
+
+template <typename P>
+inline TaskUntil<P> task_until (P pred, unsigned long timeout_ms = 0) { return TaskUntil<P> (pred, timeout_ms); }
+
+// co_await task_wait(signal, timeout_ms), return false if timeout
+inline auto task_wait (TaskSignal & sig, unsigned long timeout_ms = 0) { return task_until ([&sig]() { return sig.take (); }, timeout_ms); }
+
+#endif // TASK_USE_COROUTINE
+
+#endif // _TASK_SEQUENCE_H
@@ -0,0 +1,67 @@
+/**
+ * @file    tick.h
+ * @brief   Compact wrap-safe time type for the timing of the objects
+ * @author  Yunhui Fu (yhfudev@gmail.com)
+ * @version 1.0
+ * @date    2016-07-14
+ * @copyright GPL
+ */
+/**
+ * Usage:
+ *   The tick_t is the lower TICK_BITS bits of millis(), 16 bits by default, which is
+ *   faster and smaller on 8-bit AVR than the 32-bit unsigned long.
+ *   The ticks wrap around (every 65.536 seconds for 16 bits), so they should only be
+ *   compared by the modular helpers, and the intervals should not be longer than TICK_MAX_SPAN
+ *   (32767 ms for 16 bits). Define TICK_BITS to 32 for the longer intervals.
+ *
+ *   Example:
+ *     tick_t start = tick_from (millis());
+ *     ...
+ *     if (tick_elapsed (tick_from (millis()), start) >= 500) {
+ *         // 500 ms passed
+ *     }
+ *     tick_t deadline = start + 500;
+ *     if (tick_reached (tick_from (millis()), deadline)) {
+ *         // same as above
+ *     }
+ */
+
+#ifndef _TICK_MODULAR_H
+#define _TICK_MODULAR_H 1
+
+#include "sysport.h"
+
+#ifndef TICK_BITS
+#define TICK_BITS 16
+#endif
+
+#if TICK_BITS == 16
+typedef uint16_t tick_t;
+typedef int16_t tick_diff_t;
+#elif TICK_BITS == 32
+typedef uint32_t tick_t;
+typedef int32_t tick_diff_t;
+#else
+#error "TICK_BITS should be 16 or 32"
+#endif
+
+// the longest interval which can be compared
+#define TICK_MAX_SPAN ((tick_t)(((tick_t)~(tick_t)0) >> 1))
+
+// the tick of the time(millis)
+inline tick_t tick_from (unsigned long ms) { return (tick_t)ms; }
+// the interval(ms) limited to TICK_MAX_SPAN
+inline tick_t tick_span (unsigned long ms) { return (ms > TICK_MAX_SPAN)?TICK_MAX_SPAN:(tick_t)ms; }
+// the signed difference a - b
+inline tick_diff_t tick_diff (tick_t a, tick_t b) { return (tick_diff_t)(tick_t)(a - b); }
+// the time from since to now, now should not be earlier than since
+inline tick_t tick_elapsed (tick_t now, tick_t since) { return (tick_t)(now - since); }
+// if a is earlier than b
+inline bool tick_before (tick_t a, tick_t b) { return (tick_diff (a, b) < 0); }
+// if the deadline is reached at now
+inline bool tick_reached (tick_t now, tick_t deadline) { return (tick_diff (now, deadline) >= 0); }
+// the full time(millis) of the tick, near the full time now
+inline unsigned long tick_to_ms (tick_t t, unsigned long now) { return now + (long)tick_diff (t, tick_from (now)); }
+
+#endif // _TICK_MODULAR_H
+
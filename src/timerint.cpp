@@ -7,41 +7,657 @@
  * @copyright GPL
  */
 
-#if defined(ARDUINO)
-// https://github.com/andysworkshop/avr-stl.git
-//#include <avr_config.h> // compile error
-//https://github.com/vancegroup/stlport-avr.git
-//#include <stlport.h> // compile error
+#include "sysport.h"
+#include "timerint.h"
+
+#if defined(__AVR__)
+#include <avr/interrupt.h>
+#elif ! defined(ARDUINO)
+#include <pthread.h>
+#include <time.h>
+#endif
 
-// uclibc
-// https://github.com/maniacbug/StandardCplusplus.git
-#include <StandardCplusplus.h>
+#ifndef TRACE
+#define TRACE(...)
 #endif
 
-#include <algorithm>    // std::make_heap, std::pop_heap, std::push_heap, std::sort_heap
-#include <vector>       // std::vector
+// 0 -- verbose, 1 -- info, 2 -- warning, 3 -- error
+#define TRACE0 TRACE
+#define TRACE1 TRACE
+#define TRACE2 TRACE
+#define TRACE3 TRACE
 
-#include "timerint.h"
+#if 1
+#undef TRACE0
+#define TRACE0(...)
+#undef TRACE1
+#define TRACE1(...)
+#endif
+
+/**
+ * The wheel has TIMERINT_WHEEL_LEVELS levels, each level has TIMERINT_WHEEL_SLOTS slots.
+ * A slot of level n covers (1 << (n * TIMERINT_WHEEL_BITS)) ticks.
+ * The timer is linked to the slot of the lowest level which can hold its expire time,
+ * and it's moved (cascaded) to the lower level when the wheel of the lower level wraps.
+ * The slot of level 0 is the list of the timers which expire at that tick.
+ *
+ * When driven by the hardware, the wheel is shared by the ISR and the loop(),
+ * the loop() side disables the interrupt (locks the mutex on PC) when it changes the wheel.
+ * The free list is only used by the loop() side.
+ */
+
+#if defined(__AVR__)
+#define TIMERINT_LOCK()   uint8_t sreg_saved = SREG; cli()
+#define TIMERINT_UNLOCK() SREG = sreg_saved
+#elif defined(ARDUINO)
+#define TIMERINT_LOCK()   noInterrupts()
+#define TIMERINT_UNLOCK() interrupts()
+#else
+static pthread_mutex_t g_timerint_mutex = PTHREAD_MUTEX_INITIALIZER;
+#define TIMERINT_LOCK()   if (this->hw_attached) { pthread_mutex_lock (&g_timerint_mutex); }
+#define TIMERINT_UNLOCK() if (this->hw_attached) { pthread_mutex_unlock (&g_timerint_mutex); }
+#endif
 
 TimerInt::TimerInt()
 {
+    unsigned int j;
+
+    for (j = 0; j < sizeof(this->heads)/sizeof(this->heads[0]); j ++) {
+        this->heads[j] = TIMERINT_NIL;
+    }
+    this->free_head = TIMERINT_NIL;
+    this->num_pending = 0;
+    this->time_cur = 0;
+    this->hw_attached = false;
+    this->reset_stats ();
+}
+
+// pick the time in [expires, expires + slack] with the most trailing zero bits,
+// so the timers with overlapped windows tend to pick the same tick
+static unsigned long
+apply_slack (unsigned long expires, unsigned long slack)
+{
+    unsigned long limit = expires + slack;
+    unsigned long mask = expires ^ limit;
+    uint8_t bit = 0;
+
+    if ((slack < 1) || (0 == mask)) {
+        return expires;
+    }
+    while (mask >>= 1) {
+        bit ++;
+    }
+    return limit & ~((1UL << bit) - 1);
 }
 
+// return the index of the pending or fired item, -1 if the id is not valid
 int
-TimerInt::start (unsigned long time_ms, void * userdata, void (*function)(void * userdata))
+TimerInt::id2idx (int id)
 {
-    Item item_new;
-    item_new.userdata = userdata;
-    item_new.cb_expired = function;
-    this->lst.push_back (item_new);
-    std::push_heap (this->lst.begin(), this->lst.end());
-    return -1;
+    if (id < 0) {
+        return -1;
+    }
+    unsigned int idx = id % TIMERINT_MAX_ITEMS;
+    if (idx >= this->items.size()) {
+        return -1;
+    }
+    if ((TIMERINT_ST_PENDING != this->items[idx].state) && (TIMERINT_ST_FIRED != this->items[idx].state)) {
+        return -1;
+    }
+    if (this->items[idx].gen != (uint8_t)(id / TIMERINT_MAX_ITEMS)) {
+        TRACE2 ("TimerInt: stale id %d", id);
+        return -1;
+    }
+    return idx;
+}
+
+// link the item to the slot by its expire time
+void
+TimerInt::link (timerint_idx_t idx)
+{
+    Item & it = this->items[idx];
+    unsigned long expires = it.expires;
+    long delta = (long)(expires - this->time_cur);
+    uint8_t lvl;
+
+    if (delta < 0) {
+        // overdue, the slot of time_cur was processed, expire on the next tick
+        expires = this->time_cur + 1;
+        delta = 1;
+    }
+    for (lvl = 0; lvl < TIMERINT_WHEEL_LEVELS - 1; lvl ++) {
+        if (delta < (1L << ((lvl + 1) * TIMERINT_WHEEL_BITS))) {
+            break;
+        }
+    }
+    if (delta >= (1L << (TIMERINT_WHEEL_LEVELS * TIMERINT_WHEEL_BITS))) {
+        // park the item at the far end of the wheel, it'll be re-linked when cascaded
+        expires = this->time_cur + (1L << (TIMERINT_WHEEL_LEVELS * TIMERINT_WHEEL_BITS)) - 1;
+    }
+    timerint_slot_t slot = lvl * TIMERINT_WHEEL_SLOTS + ((expires >> (lvl * TIMERINT_WHEEL_BITS)) & TIMERINT_WHEEL_MASK);
+
+    it.slot = slot;
+    it.prev = TIMERINT_NIL;
+    it.next = this->heads[slot];
+    if (it.next != TIMERINT_NIL) {
+        this->items[it.next].prev = idx;
+    }
+    this->heads[slot] = idx;
+}
+
+void
+TimerInt::unlink (timerint_idx_t idx)
+{
+    Item & it = this->items[idx];
+    if (it.prev == TIMERINT_NIL) {
+        this->heads[it.slot] = it.next;
+    } else {
+        this->items[it.prev].next = it.next;
+    }
+    if (it.next != TIMERINT_NIL) {
+        this->items[it.next].prev = it.prev;
+    }
+    it.next = TIMERINT_NIL;
+    it.prev = TIMERINT_NIL;
+}
+
+// put the unlinked item back to the free list, the ids of the item become stale
+void
+TimerInt::release (timerint_idx_t idx)
+{
+    Item & it = this->items[idx];
+    it.state = TIMERINT_ST_FREE;
+    it.gen = (it.gen + 1) & 0x7F;
+    it.next = this->free_head;
+    this->free_head = idx;
+}
+
+int
+TimerInt::start (unsigned long time_ms, void * userdata, void (*function)(void * userdata), unsigned long slack_ms)
+{
+    return this->add (time_ms, slack_ms, 0, TIMERINT_CATCHUP_SKIP, userdata, function);
+}
+
+int
+TimerInt::start_periodic (unsigned long period_ms, void * userdata, void (*function)(void * userdata), uint8_t catchup)
+{
+    if (period_ms < 1) {
+        return -1;
+    }
+    return this->add (period_ms, 0, period_ms, catchup, userdata, function);
+}
+
+int
+TimerInt::add (unsigned long time_ms, unsigned long slack_ms, unsigned long period_ms, uint8_t catchup, void * userdata, void (*function)(void * userdata))
+{
+    if (nullptr == function) {
+        return -1;
+    }
+    timerint_idx_t idx = this->free_head;
+    if (TIMERINT_NIL != idx) {
+        this->free_head = this->items[idx].next;
+    } else {
+        // no item released, take a new one from the pool
+        Item it_new;
+        it_new.gen = 0;
+        it_new.state = TIMERINT_ST_FREE;
+        if (! this->items.push_back (it_new)) {
+            TRACE3 ("TimerInt: no free item!");
+            return -1;
+        }
+        idx = this->items.size() - 1;
+    }
+    Item & it = this->items[idx];
+
+    if (time_ms < 1) {
+        time_ms = 1;
+    }
+    it.userdata = userdata;
+    it.cb_expired = function;
+    it.period = period_ms;
+    it.catchup = catchup;
+    it.overrun = 0;
+    it.calls = 0;
+#if TIMERINT_JITTER
+    memset (&(it.jitter), 0, sizeof(it.jitter));
+#endif
+    TIMERINT_LOCK();
+    it.expires = apply_slack (this->time_cur + time_ms, slack_ms);
+    it.state = TIMERINT_ST_PENDING;
+    this->link (idx);
+    this->num_pending ++;
+    TIMERINT_UNLOCK();
+    TRACE0 ("TimerInt: start id=%d expires=%lu", idx2id(idx), it.expires);
+    return idx2id(idx);
+}
+
+int
+TimerInt::restart (int id, unsigned long time_ms, unsigned long slack_ms)
+{
+    int ret = -1;
+    if (time_ms < 1) {
+        time_ms = 1;
+    }
+    TIMERINT_LOCK();
+    int idx = this->id2idx (id);
+    // the fired item is not in the wheel any more
+    if ((idx >= 0) && (TIMERINT_ST_PENDING == this->items[idx].state)) {
+        this->unlink (idx);
+        this->items[idx].expires = apply_slack (this->time_cur + time_ms, slack_ms);
+        this->link (idx);
+        ret = id;
+    }
+    TIMERINT_UNLOCK();
+    return ret;
 }
 
 int
 TimerInt::cancel (int id)
 {
-    return -1;
+    int ret = -1;
+    TIMERINT_LOCK();
+    int idx = this->id2idx (id);
+    if (idx >= 0) {
+        Item & it = this->items[idx];
+        ret = 0;
+        if (TIMERINT_ST_PENDING == it.state) {
+            this->unlink (idx);
+            this->num_pending --;
+        }
+        if (it.calls > 0) {
+            // it's in the queue, released by dispatch()
+            it.state = TIMERINT_ST_CANCELED;
+        } else {
+            this->release (idx);
+        }
+    }
+    TIMERINT_UNLOCK();
+    return ret;
+}
+
+bool
+TimerInt::is_pending (int id)
+{
+    int idx = this->id2idx (id);
+    return ((idx >= 0) && (TIMERINT_ST_PENDING == this->items[idx].state));
+}
+
+uint8_t
+TimerInt::get_overrun (int id)
+{
+    int idx = this->id2idx (id);
+    if (idx < 0) {
+        return 0;
+    }
+    return this->items[idx].overrun;
+}
+
+// the slots are not sorted, and the wheel is only scanned when the loop is going to sleep,
+// so it's simpler to check the items of the pool
+bool
+TimerInt::next_deadline (unsigned long & deadline)
+{
+    bool ret = false;
+    unsigned int i;
+    TIMERINT_LOCK();
+    if (! this->fired.empty()) {
+        // the callbacks from ISR are waiting for dispatch()
+        deadline = this->time_cur;
+        ret = true;
+    } else {
+        for (i = 0; i < this->items.size(); i ++) {
+            if (TIMERINT_ST_PENDING != this->items[i].state) {
+                continue;
+            }
+            if ((! ret) || ((long)(this->items[i].expires - deadline) < 0)) {
+                deadline = this->items[i].expires;
+                ret = true;
+            }
+        }
+    }
+    TIMERINT_UNLOCK();
+    return ret;
+}
+
+#if TIMERINT_JITTER
+int
+TimerInt::get_jitter (int id, TimerInt::Jitter & jitter)
+{
+    int idx = this->id2idx (id);
+    if (idx < 0) {
+        return -1;
+    }
+    TIMERINT_LOCK();
+    jitter = this->items[idx].jitter;
+    TIMERINT_UNLOCK();
+    return 0;
+}
+#endif
+
+// move the items of the upper levels down when the lower level wraps
+void
+TimerInt::cascade (void)
+{
+    unsigned long t = this->time_cur;
+    uint8_t lvl;
+    for (lvl = 1; lvl < TIMERINT_WHEEL_LEVELS; lvl ++) {
+        if (t & TIMERINT_WHEEL_MASK) {
+            break;
+        }
+        t >>= TIMERINT_WHEEL_BITS;
+        timerint_slot_t slot = lvl * TIMERINT_WHEEL_SLOTS + (t & TIMERINT_WHEEL_MASK);
+        timerint_idx_t idx = this->heads[slot];
+        this->heads[slot] = TIMERINT_NIL;
+        while (idx != TIMERINT_NIL) {
+            timerint_idx_t next = this->items[idx].next;
+            this->link (idx);
+            idx = next;
+        }
+    }
+}
+
+// call the callback of the periodic timer, late is the time from the deadline,
+// missed is the number of the periods dropped or merged
+void
+TimerInt::call_periodic (Item & it, unsigned long late, unsigned long missed)
+{
+#if TIMERINT_JITTER
+    it.jitter.count ++;
+    it.jitter.late_sum += late;
+    if (late > it.jitter.late_max) {
+        it.jitter.late_max = late;
+    }
+    it.jitter.missed += missed;
+#endif
+    it.overrun = 0;
+    if (TIMERINT_CATCHUP_COALESCE == it.catchup) {
+        it.overrun = (missed > 255)?255:missed;
+    }
+    // the item may be canceled and reused by the callback
+    it.cb_expired (it.userdata);
+}
+
+// expire the items in the slot of level 0
+// call the callbacks directly, or queue the items if it's called by ISR
+void
+TimerInt::run_slot (timerint_slot_t slot, bool is_isr)
+{
+    if (this->heads[slot] != TIMERINT_NIL) {
+        this->num_wakeups ++;
+    }
+    // the callback may start or cancel the other timers, so the list is walked from the head each time
+    while (this->heads[slot] != TIMERINT_NIL) {
+        timerint_idx_t idx = this->heads[slot];
+        Item & it = this->items[idx];
+
+        this->unlink (idx);
+        this->num_expired ++;
+        TRACE0 ("TimerInt: expired idx=%d at %lu", idx, this->time_cur);
+        if (it.period > 0) {
+            // re-arm the periodic timer from the deadline before the callback, so the callback can cancel it
+            unsigned long deadline = it.expires;
+            unsigned long missed = 0;
+            if ((! is_isr) && (TIMERINT_CATCHUP_BURST != it.catchup)) {
+                // the periods passed in this tick() are not called
+                missed = (this->time_target - deadline) / it.period;
+            }
+            it.expires = deadline + it.period * (missed + 1);
+            this->link (idx);
+#if TIMERINT_JITTER
+            it.deadline = deadline;
+#endif
+            if (is_isr) {
+                // queue once, the following expirations are counted until dispatch()
+                if (it.calls < 255) {
+                    if (0 == it.calls ++) {
+                        this->fired.push (idx);
+                    }
+                }
+            } else {
+                this->call_periodic (it, this->time_target - deadline, missed);
+            }
+            continue;
+        }
+        this->num_pending --;
+        if (is_isr) {
+            // the queue is large enough to hold all of the items
+            it.state = TIMERINT_ST_FIRED;
+            it.calls = 1;
+            this->fired.push (idx);
+        } else {
+            void * userdata = it.userdata;
+            void (* cb_expired)(void * userdata) = it.cb_expired;
+            this->release (idx);
+            cb_expired (userdata);
+        }
+    }
+}
+
+void
+TimerInt::advance (unsigned long now, bool is_isr)
+{
+    this->time_target = now;
+    if (this->num_pending < 1) {
+        // nothing to do, jump to the time directly
+        this->time_cur = now;
+        return;
+    }
+    while ((long)(now - this->time_cur) > 0) {
+        this->time_cur ++;
+        this->cascade ();
+        this->run_slot (this->time_cur & TIMERINT_WHEEL_MASK, is_isr);
+        if (this->num_pending < 1) {
+            this->time_cur = now;
+            break;
+        }
+    }
+}
+
+void
+TimerInt::tick (unsigned long now)
+{
+    this->advance (now, false);
+}
+
+void
+TimerInt::isr_tick (unsigned long now)
+{
+    this->advance (now, true);
+}
+
+unsigned int
+TimerInt::dispatch (void)
+{
+    unsigned int cnt = 0;
+    timerint_idx_t idx;
+    while (this->fired.pop (idx)) {
+        Item & it = this->items[idx];
+        uint8_t gen = it.gen;
+        uint8_t calls;
+        uint8_t state;
+        unsigned long late = 0;
+
+        TIMERINT_LOCK();
+        calls = it.calls;
+        it.calls = 0;
+        state = it.state;
+        if (TIMERINT_ST_PENDING != state) {
+            // one-shot or canceled
+            this->release (idx);
+        }
+#if TIMERINT_JITTER
+        late = this->time_cur - it.deadline;
+#endif
+        TIMERINT_UNLOCK();
+        if (TIMERINT_ST_CANCELED == state) {
+            continue;
+        }
+        cnt ++;
+        if (TIMERINT_ST_FIRED == state) {
+            it.cb_expired (it.userdata);
+            continue;
+        }
+        if (TIMERINT_CATCHUP_BURST != it.catchup) {
+            this->call_periodic (it, late, calls - 1);
+            continue;
+        }
+        while (calls -- > 0) {
+            this->call_periodic (it, late, 0);
+            if ((gen != it.gen) || (TIMERINT_ST_PENDING != it.state)) {
+                // canceled by the callback
+                break;
+            }
+        }
+    }
+    return cnt;
+}
+
+#if defined(__AVR__) && ((TIMERINT_HW_TIMER == 0 && defined(OCR0B)) || (TIMERINT_HW_TIMER == 1 && defined(OCR1A)) || (TIMERINT_HW_TIMER == 2 && defined(OCR2A)))
+static TimerInt * volatile g_timerint_hw = nullptr;
+
+#if TIMERINT_DEFINE_ISR
+// the wheel is advanced to millis(), so the time of the timers is the same as the one of the pins
+#if TIMERINT_HW_TIMER == 0
+// once per overflow of Timer0 (1.024 ms), whatever OCR0B is set to by analogWrite()
+ISR(TIMER0_COMPB_vect)
+#elif TIMERINT_HW_TIMER == 1
+ISR(TIMER1_COMPA_vect)
+#else
+ISR(TIMER2_COMPA_vect)
+#endif
+{
+    if (g_timerint_hw) {
+        g_timerint_hw->isr_tick (millis());
+    }
+}
+#endif // TIMERINT_DEFINE_ISR
+
+int
+TimerInt::attach_hw (void)
+{
+    if (g_timerint_hw) {
+        return -1;
+    }
+    uint8_t sreg_saved = SREG;
+    cli();
+    g_timerint_hw = this;
+    this->hw_attached = true;
+#if TIMERINT_HW_TIMER == 0
+    // Timer0 is set up by the Arduino core for millis()
+    TIMSK0 |= _BV(OCIE0B);
+#elif TIMERINT_HW_TIMER == 1
+    // CTC mode, clk/64, compare match A at 1 kHz
+    TCCR1A = 0;
+    TCCR1B = _BV(WGM12) | _BV(CS11) | _BV(CS10);
+    TCNT1 = 0;
+    OCR1A = (F_CPU / 64 / 1000) - 1;
+    TIMSK1 |= _BV(OCIE1A);
+#else
+    // CTC mode, compare match A at 1 kHz
+    TCCR2A = _BV(WGM21);
+#if F_CPU / 64 / 1000 > 256
+    TCCR2B = _BV(CS22) | _BV(CS20); // clk/128
+    OCR2A = (F_CPU / 128 / 1000) - 1;
+#else
+    TCCR2B = _BV(CS22); // clk/64
+    OCR2A = (F_CPU / 64 / 1000) - 1;
+#endif
+    TCNT2 = 0;
+    TIMSK2 |= _BV(OCIE2A);
+#endif
+    SREG = sreg_saved;
+    return 0;
+}
+
+void
+TimerInt::detach_hw (void)
+{
+    if (g_timerint_hw != this) {
+        return;
+    }
+    uint8_t sreg_saved = SREG;
+    cli();
+#if TIMERINT_HW_TIMER == 0
+    TIMSK0 &= ~_BV(OCIE0B);
+#elif TIMERINT_HW_TIMER == 1
+    TIMSK1 &= ~_BV(OCIE1A);
+#else
+    TIMSK2 &= ~_BV(OCIE2A);
+#endif
+    g_timerint_hw = nullptr;
+    SREG = sreg_saved;
+    this->dispatch ();
+    this->hw_attached = false;
+}
+
+#elif ! defined(ARDUINO)
+// the POSIX thread stands in for the timer interrupt on PC
+static TimerInt * volatile g_timerint_hw = nullptr;
+static pthread_t g_timerint_thread;
+
+static void *
+timerint_hw_thread (void * arg)
+{
+    TimerInt * ptm = (TimerInt *)arg;
+    unsigned long now = ptm->get_time();
+    struct timespec ts;
+
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+    while (g_timerint_hw == ptm) {
+        // sleep to the next ms
+        ts.tv_nsec += 1000000;
+        if (ts.tv_nsec >= 1000000000) {
+            ts.tv_nsec -= 1000000000;
+            ts.tv_sec ++;
+        }
+        clock_nanosleep (CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL);
+        now ++;
+        pthread_mutex_lock (&g_timerint_mutex);
+        ptm->isr_tick (now);
+        pthread_mutex_unlock (&g_timerint_mutex);
+    }
+    return NULL;
+}
+
+int
+TimerInt::attach_hw (void)
+{
+    if (g_timerint_hw) {
+        return -1;
+    }
+    g_timerint_hw = this;
+    this->hw_attached = true;
+    if (0 != pthread_create (&g_timerint_thread, NULL, timerint_hw_thread, this)) {
+        TRACE3 ("TimerInt: create thread failed!");
+        g_timerint_hw = nullptr;
+        this->hw_attached = false;
+        return -1;
+    }
+    return 0;
 }
 
+void
+TimerInt::detach_hw (void)
+{
+    if (g_timerint_hw != this) {
+        return;
+    }
+    g_timerint_hw = nullptr;
+    pthread_join (g_timerint_thread, NULL);
+    this->dispatch ();
+    this->hw_attached = false;
+}
 
+#else
+int
+TimerInt::attach_hw (void)
+{
+    TRACE3 ("TimerInt: no hardware timer supported!");
+    return -1;
+}
+
+void
+TimerInt::detach_hw (void)
+{
+}
+#endif
@@ -6,45 +6,272 @@
  * @date    2016-07-14
  * @copyright GPL
  */
+/**
+ * Usage:
+ *   The TimerInt class is a hierarchical timing wheel:
+ *     1) start, cancel and restart a timer are O(1)
+ *     2) the timer id returned by start() is stable until the timer expired or canceled
+ *     3) the callbacks of the expired timers are called from tick()/expire()
+ *   The items are allocated from a fixed pool, no dynamic memory is used.
+ *
+ *   The wheel can also be driven by the hardware timer interrupt (Timer0, Timer1 or Timer2 compare match,
+ *   a POSIX thread on PC) after attach_hw() is called, see TIMERINT_HW_TIMER. The ISR only pushes the ids of
+ *   the expired timers to a lock-free queue, and the callbacks are called by expire()/dispatch()
+ *   in the loop(), so the timeout doesn't depend on how often the loop() polls millis().
+ *   On AVR the ISR advances the wheel to millis(), so tick() should also be given millis(),
+ *   then get_time() and the times of the pin changes (millis()) are on the same time base.
+ *   On AVR the sketch defines the ISR of the timer, which calls isr_tick(millis()),
+ *   so the vector is free for the other libraries when attach_hw() is not used;
+ *   or build with TIMERINT_DEFINE_ISR=1 to define it in the library:
+ *     ISR(TIMER0_COMPB_vect) { // TIMER1_COMPA_vect or TIMER2_COMPA_vect, see TIMERINT_HW_TIMER
+ *         timers.isr_tick (millis());
+ *     }
+ *
+ *   A timer can be started with a slack: it may expire up to slack_ms later than time_ms,
+ *   the wheel aligns it to the tick in the window which is shared with the most of the other timers,
+ *   so the nearby timers expire in one batch and the number of wakeups is reduced.
+ *
+ *   The periodic timer is re-armed from its ideal deadline (deadline += period), not from the time
+ *   the callback is called, so it doesn't drift. If the loop() stalls over several periods,
+ *   the catch-up policy decides what to do with the missed periods:
+ *     TIMERINT_CATCHUP_BURST    -- call the callback once for each missed period
+ *     TIMERINT_CATCHUP_SKIP     -- call the callback once, drop the missed periods
+ *     TIMERINT_CATCHUP_COALESCE -- call the callback once, get_overrun() returns the number of the missed periods
+ *   The phase of the timer is kept in all cases.
+ *
+ *   Example:
+ *     TimerInt timers;
+ *     void
+ *     cb_timeout(void * userdata)
+ *     {
+ *         digitalWrite(LED_BUILTIN, LOW);
+ *     }
+ *     void setup(void) {
+ *         timers.tick(millis());
+ *         digitalWrite(LED_BUILTIN, HIGH);
+ *         timers.start(500, nullptr, cb_timeout);
+ *     }
+ *     void loop(void) {
+ *         timers.expire();
+ *     }
+ */
 
 #ifndef _TIMER_INTERRUPTION_ARDUINO_H
 #define _TIMER_INTERRUPTION_ARDUINO_H
 
+#include "sysport.h"
+#include "ringbuffer.h"
+#include "staticvector.h"
+#include "delegate.h"
+
+// the max number of the pending timers
+#ifndef TIMERINT_MAX_ITEMS
+#if defined(__AVR__)
+#define TIMERINT_MAX_ITEMS     16
+#else
+#define TIMERINT_MAX_ITEMS    512
+#endif
+#endif
+
+// the number of slots of each level of the wheel is (1 << TIMERINT_WHEEL_BITS)
+#ifndef TIMERINT_WHEEL_BITS
+#if defined(__AVR__)
+#define TIMERINT_WHEEL_BITS     4
+#else
+#define TIMERINT_WHEEL_BITS     6
+#endif
+#endif
+
+// the number of levels of the wheel,
+// the timers longer than (1 << (TIMERINT_WHEEL_BITS * TIMERINT_WHEEL_LEVELS)) ms are parked at the last level
+#ifndef TIMERINT_WHEEL_LEVELS
+#define TIMERINT_WHEEL_LEVELS   4
+#endif
+
+// the size of the queue of the expired timers from ISR, a power of 2 and not less than TIMERINT_MAX_ITEMS
+#ifndef TIMERINT_FIRED_SIZE
+#if defined(__AVR__)
+#define TIMERINT_FIRED_SIZE    16
+#else
+#define TIMERINT_FIRED_SIZE   512
+#endif
+#endif
+
+#if TIMERINT_FIRED_SIZE < TIMERINT_MAX_ITEMS
+#error "TimerInt: TIMERINT_FIRED_SIZE is less than TIMERINT_MAX_ITEMS"
+#endif
+
+// keep the jitter statistics of the periodic timers
+#ifndef TIMERINT_JITTER
+#if defined(__AVR__)
+#define TIMERINT_JITTER         0
+#else
+#define TIMERINT_JITTER         1
+#endif
+#endif
+
+// the hardware timer used by attach_hw():
+//   0 -- the compare match B of Timer0, shared with millis(), the PWM of analogWrite() is kept
+//   1 -- Timer1 in CTC mode, analogWrite() on the pins of Timer1 (9, 10 on UNO) doesn't work
+//   2 -- Timer2 in CTC mode, analogWrite() on the pins of Timer2 (3, 11 on UNO) doesn't work
+#ifndef TIMERINT_HW_TIMER
+#define TIMERINT_HW_TIMER       0
+#endif
+
+// 1 -- the library defines the ISR of TIMERINT_HW_TIMER, 0 -- the sketch defines it
+#ifndef TIMERINT_DEFINE_ISR
+#define TIMERINT_DEFINE_ISR     0
+#endif
+
+#if TIMERINT_WHEEL_BITS * TIMERINT_WHEEL_LEVELS > 30
+#error "TimerInt: the wheel is larger than the range of the time"
+#endif
+
+#define TIMERINT_WHEEL_SLOTS  (1 << TIMERINT_WHEEL_BITS)
+#define TIMERINT_WHEEL_MASK   (TIMERINT_WHEEL_SLOTS - 1)
+
+#if TIMERINT_MAX_ITEMS < 255
+typedef uint8_t timerint_idx_t;
+#define TIMERINT_NIL 0xFF
+#else
+typedef uint16_t timerint_idx_t;
+#define TIMERINT_NIL 0xFFFF
+#endif
+
+#if TIMERINT_WHEEL_SLOTS * TIMERINT_WHEEL_LEVELS <= 256
+typedef uint8_t timerint_slot_t;
+#else
+typedef uint16_t timerint_slot_t;
+#endif
+
 class TimerInt {
 public:
     TimerInt ();
 
-    // start a timer and return the timer id
-    int start (unsigned long time_ms, void * userdata, void (*function)(void * userdata));
+    // start a timer and return the timer id, -1 on error
+    // the time is relative to the time of the last tick(), the minimal timeout is 1 tick
+    // the timer expires in [time_ms, time_ms + slack_ms]
+    int start (unsigned long time_ms, void * userdata, void (*function)(void * userdata), unsigned long slack_ms = 0);
+    // same as above, the callback is a member function, a functor or a free function
+    inline int start (unsigned long time_ms, const Delegate<void()> & dg, unsigned long slack_ms = 0) { return this->start (time_ms, dg.get_obj(), dg.get_stub(), slack_ms); }
+    // re-arm a pending timer with a new timeout, keep the id. return the id, -1 on error
+    int restart (int id, unsigned long time_ms, unsigned long slack_ms = 0);
+    // cancel a pending timer, return 0 on success, -1 if the id is not pending
     int cancel (int id);
+    bool is_pending (int id);
+
+#define TIMERINT_CATCHUP_BURST    0 /* call the callback for each missed period */
+#define TIMERINT_CATCHUP_SKIP     1 /* call the callback once, drop the missed periods */
+#define TIMERINT_CATCHUP_COALESCE 2 /* call the callback once, get_overrun() returns the number of the missed periods */
+    // start a periodic timer which expires every period_ms, the first expiration is after period_ms
+    int start_periodic (unsigned long period_ms, void * userdata, void (*function)(void * userdata), uint8_t catchup = TIMERINT_CATCHUP_SKIP);
+    inline int start_periodic (unsigned long period_ms, const Delegate<void()> & dg, uint8_t catchup = TIMERINT_CATCHUP_SKIP) { return this->start_periodic (period_ms, dg.get_obj(), dg.get_stub(), catchup); }
+    // the number of the periods merged into the current callback, called by the callback of the COALESCE timer
+    uint8_t get_overrun (int id);
+
+#if TIMERINT_JITTER
+    class Jitter {
+    public:
+        unsigned long count;    // the number of the callbacks
+        unsigned long late_sum; // the sum of the time(ms) from the deadline to the callback
+        unsigned long late_max;
+        unsigned long missed;   // the number of the dropped or merged periods
+    };
+    // get the jitter statistics of a periodic timer, return 0 on success, -1 on error
+    int get_jitter (int id, TimerInt::Jitter & jitter);
+#endif
+
+    // advance the wheel to the time now(ms), and call the callbacks of the expired timers
+    void tick (unsigned long now);
+    // call the callbacks of the expired timers: from the queue if driven by hardware, otherwise by millis()
+    inline void expire (void) { if (this->hw_attached) { this->dispatch(); } else { this->tick (millis()); } }
+    // same as expire(), for the task of Scheduler, return true if there are pending timers
+    inline bool update (void) { this->expire(); return (this->num_pending > 0); }
+    inline bool update (unsigned long now) { if (this->hw_attached) { this->dispatch(); } else { this->tick (now); } return (this->num_pending > 0); }
+
+    // drive the wheel by the hardware timer interrupt at 1 ms, return 0 on success, -1 on error
+    // on AVR the ISR calling isr_tick() is defined by the sketch, unless TIMERINT_DEFINE_ISR
+    int attach_hw (void);
+    void detach_hw (void);
+    // called by the ISR: advance the wheel and queue the expired timers
+    void isr_tick (unsigned long now);
+    // called by the loop(): call the callbacks of the timers queued by the ISR, return the number of the callbacks
+    unsigned int dispatch (void);
+
+    // the earliest expiration of the pending timers, return false if there's no pending timer
+    bool next_deadline (unsigned long & deadline);
+
+    // the number of the pending timers
+    inline unsigned int size (void) { return this->num_pending; }
+    // the time of the last tick, the time base of tick(): millis() for expire() and the ISR on AVR
+    inline unsigned long get_time (void) {
+#if defined(__AVR__)
+        // written by the ISR
+        uint8_t sreg_saved = SREG;
+        cli();
+        unsigned long t = this->time_cur;
+        SREG = sreg_saved;
+        return t;
+#else
+        return this->time_cur;
+#endif
+    }
+
+    // statistics: the number of the expired timers, and the number of the batches(wakeups) they expired in
+    inline unsigned long get_num_expired (void) { return this->num_expired; }
+    inline unsigned long get_num_wakeups (void) { return this->num_wakeups; }
+    inline unsigned long get_wakeups_saved (void) { return this->num_expired - this->num_wakeups; }
+    inline void reset_stats (void) { this->num_expired = 0; this->num_wakeups = 0; }
 
     class Item {
     public:
         //Item();
-        int id;
-        unsigned long time_left;
+        unsigned long expires; // the absolute expire time
         void * userdata;
         void (* cb_expired)(void * userdata);
+        timerint_idx_t next;   // the next item in the same slot or in the free list
+        timerint_idx_t prev;   // the previous item in the same slot, TIMERINT_NIL if it's the head
+        timerint_slot_t slot;  // the slot which the item is linked to
+        uint8_t gen;           // the generation of the item, to detect the stale ids
+        volatile uint8_t state;
+        unsigned long period;  // the period of the periodic timer, 0 for one-shot
+        uint8_t catchup;       // the catch-up policy of the periodic timer
+        uint8_t overrun;       // the number of the periods merged into the current callback
+        volatile uint8_t calls; // the number of the expirations queued by ISR
+#if TIMERINT_JITTER
+        unsigned long deadline; // the last deadline expired
+        TimerInt::Jitter jitter;
+#endif
     };
+
+#define TIMERINT_ST_FREE     0
+#define TIMERINT_ST_PENDING  1 /* linked to the wheel */
+#define TIMERINT_ST_FIRED    2 /* expired by ISR, waiting in the queue */
+#define TIMERINT_ST_CANCELED 3 /* canceled after fired, waiting in the queue */
+
 private:
-    std::vector<TimerInt::Item> lst;
-};
+    static_vector<Item, TIMERINT_MAX_ITEMS> items; // the pool of the items, grows up to TIMERINT_MAX_ITEMS
+    timerint_idx_t heads[TIMERINT_WHEEL_SLOTS * TIMERINT_WHEEL_LEVELS];
+    timerint_idx_t free_head;
+    volatile unsigned int num_pending;
+    volatile unsigned long time_cur; // the current time of the wheel, the slots up to this time were processed
+    unsigned long time_target; // the time passed to tick()
+    ring_buffer<timerint_idx_t, TIMERINT_FIRED_SIZE> fired; // the expired items queued by ISR
+    bool hw_attached;
+    unsigned long num_expired;
+    unsigned long num_wakeups;
 
-//inline bool operator==(const X& lhs, const X& rhs){ /* do actual comparison */ }
-//inline bool operator!=(const X& lhs, const X& rhs){ return !(lhs == rhs); }
-//inline bool operator< (const X& lhs, const X& rhs){ /* do actual comparison */ }
-//inline bool operator> (const X& lhs, const X& rhs){ return rhs < lhs; }
-//inline bool operator<=(const X& lhs, const X& rhs){ return !(lhs > rhs); }
-//inline bool operator>=(const X& lhs, const X& rhs){ return !(lhs < rhs); }
-inline bool operator< (const TimerInt::Item & lhs, const TimerInt::Item & rhs)
-{
-    return (lhs.time_left < rhs.time_left);
-}
-
-inline bool operator== (const TimerInt::Item & lhs, const TimerInt::Item & rhs)
-{
-    return (lhs.time_left == rhs.time_left);
-}
+    int id2idx (int id);
+    int add (unsigned long time_ms, unsigned long slack_ms, unsigned long period_ms, uint8_t catchup, void * userdata, void (*function)(void * userdata));
+    inline int idx2id (timerint_idx_t idx) { return (int)(this->items[idx].gen) * TIMERINT_MAX_ITEMS + idx; }
+    void link (timerint_idx_t idx);
+    void unlink (timerint_idx_t idx);
+    void release (timerint_idx_t idx);
+    void cascade (void);
+    void run_slot (timerint_slot_t slot, bool is_isr);
+    void advance (unsigned long now, bool is_isr);
+    void call_periodic (Item & it, unsigned long late, unsigned long missed);
+};
 
 #endif // _TIMER_INTERRUPTION_ARDUINO_H
 
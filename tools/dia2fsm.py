@@ -0,0 +1,211 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+@file    dia2fsm.py
+@brief   Generate the transitions of the button state machine from the UML diagram
+@author  Yunhui Fu (yhfudev@gmail.com)
+@version 1.0
+@date    2016-07-14
+@copyright GPL
+
+Usage:
+  python3 tools/dia2fsm.py doc/button.dia > src/buttonfsm_table.h
+
+The states of the diagram are BUTSW_STATE_<name>. Each transition is:
+  trigger: PRESSED, RELEASED or TIMEOUT
+  guard:   empty, hold==1, hold==0, clicks>0
+  action:  ';' separated items:
+             hold=0, hold=1, clicks=0,
+             timer=DBOUNCE|LONG|VLONG|2CLICK|CANCEL,
+             click            -- if(dclick)clicks++;else{clicks=0;onEnd();onClick(1)}
+             onClick(clicks)  -- report the clicks and clear them
+             onStart(), onEnd(), onLong(), onVLong(),
+             if(dclick&&clicks>0)<item> -- the item is applied if the guard is true
+  A transition with one end connected is a self loop.
+  The (state, event) without transition keeps the state without action.
+  The output is included by src/buttonfsm.cpp, see there for the bits of the rows:
+    buttonfsm_rows[]   the distinct rows, the self loops use BUTSW_STATE_SAME,
+                       the row of a guard being true follows the row of it being false
+    buttonfsm_trans[]  the guard and the first row of each (state, event)
+  The debounced mode of buttonfsm_step() (the debounce states skipped) is not in the diagram,
+  it is applied by the code after the table.
+"""
+
+import gzip
+import sys
+import xml.etree.ElementTree as ET
+
+D = '{http://www.lysator.liu.se/~alla/dia/}'
+
+# the order of the states, same as BUTSW_STATE_xxx
+STATES = ['READY', 'DEBOUNCE', '1CLICK', 'LONGPRESS', 'VLONGPRESS', 'DEBOUNCE2']
+EVENTS = ['PRESSED', 'RELEASED', 'TIMEOUT']
+GUARDS = {'': 'ALWAYS', 'hold==1': 'HOLD', 'hold==0': 'HOLD', 'clicks>0': 'CLICKS', 'dclick&&clicks>0': 'MULTI_CLICKS'}
+# the C expression of each guard
+GUARD_EXPR = {'HOLD': 'fsm->hold', 'CLICKS': 'fsm->clicks > 0', 'MULTI_CLICKS': 'multiple_click && (fsm->clicks > 0)'}
+TIMERS = ['DBOUNCE', 'LONG', 'VLONG', '2CLICK', 'CANCEL']
+CALLBACKS = {'onStart()': 'START', 'onEnd()': 'END', 'onLong()': 'LONG', 'onVLong()': 'VLONG'}
+
+
+def error(msg):
+    sys.stderr.write('dia2fsm: %s\n' % msg)
+    sys.exit(1)
+
+
+def get_string(obj, name):
+    for a in obj.findall(D + 'attribute'):
+        if a.get('name') == name:
+            s = a.find('.//' + D + 'string')
+            if s is not None and s.text:
+                return s.text.strip('#').strip()
+    return ''
+
+
+class Row:
+    def __init__(self, state):
+        self.next = state
+        self.timer = 'KEEP'
+        self.cb = []
+        self.hold = 'KEEP'
+        self.clicks = 'KEEP'
+
+    def apply(self, item, where):
+        if item in ('hold=0', 'hold=1'):
+            self.hold = 'CLEAR' if item == 'hold=0' else 'SET'
+        elif item == 'clicks=0':
+            self.clicks = 'CLEAR'
+        elif item == 'click':
+            self.clicks = 'CLICK'
+        elif item == 'onClick(clicks)':
+            self.clicks = 'EMIT'
+            self.cb.append('CLICK')
+        elif item.startswith('timer='):
+            if item[6:] not in TIMERS:
+                error('%s: unknown timer "%s"' % (where, item))
+            self.timer = item[6:]
+        elif item in CALLBACKS:
+            self.cb.append(CALLBACKS[item])
+        else:
+            error('%s: unknown action "%s"' % (where, item))
+
+    def encode(self, state):
+        nxt = 'SAME' if self.next == state else self.next
+        cb = ' | '.join('BUTSW_CB_' + c for c in self.cb) or '0'
+        return 'BUTSW_ROW(BUTSW_STATE_%s, BUTSW_TIMER_%s, %s, BUTSW_HOLD_%s, BUTSW_CLICKS_%s)' % (
+            nxt, self.timer, cb, self.hold, self.clicks)
+
+
+def main():
+    if len(sys.argv) != 2:
+        error('usage: dia2fsm.py <button.dia>')
+    with gzip.open(sys.argv[1], 'rb') as f:
+        root = ET.fromstring(f.read())
+
+    names = {}
+    transitions = []
+    for obj in root.iter(D + 'object'):
+        if obj.get('type') == 'UML - State':
+            names[obj.get('id')] = get_string(obj, 'text')
+        elif obj.get('type') == 'UML - Transition':
+            transitions.append(obj)
+    for n in names.values():
+        if n not in STATES:
+            error('unknown state "%s"' % n)
+
+    # (state, event) -> [guard, row of false, row of true]
+    table = {}
+    for obj in transitions:
+        ends = {}
+        for c in obj.iter(D + 'connection'):
+            ends[c.get('handle')] = names[c.get('to')]
+        if '0' not in ends:
+            error('transition %s is not connected' % obj.get('id'))
+        src = ends['0']
+        dst = ends.get('1', src)
+        trigger = get_string(obj, 'trigger')
+        guard = get_string(obj, 'guard').replace(' ', '')
+        where = '%s on %s [%s]' % (src, trigger, guard)
+        if trigger not in EVENTS:
+            error('%s: unknown trigger' % where)
+        if guard not in GUARDS:
+            error('%s: unknown guard' % where)
+
+        key = (src, trigger)
+        if key not in table:
+            table[key] = [None, Row(src), Row(src)]
+        ent = table[key]
+        rows = [1, 2]
+        if guard:
+            rows = [1 if guard == 'hold==0' else 2]
+        cond = None
+        for item in get_string(obj, 'action').replace(' ', '').split(';'):
+            if item.startswith('if('):
+                c, item = item[3:].split(')', 1)
+                if c not in GUARDS:
+                    error('%s: unknown condition "%s"' % (where, c))
+                cond = GUARDS[c]
+                ent[2].apply(item, where)
+                continue
+            if item:
+                for r in rows:
+                    ent[r].apply(item, where)
+        for r in rows:
+            ent[r].next = dst
+        g = GUARDS[guard] if guard else cond
+        if g and ent[0] and ent[0] != g:
+            error('%s: two guards %s and %s' % (where, ent[0], g))
+        ent[0] = g or ent[0] or 'ALWAYS'
+
+    # the distinct rows, the guarded pairs first, so that each pair is two adjacent rows
+    rows = []
+    trans = {}
+    for s in STATES:
+        for e in EVENTS:
+            if (s, e) not in table:
+                continue
+            guard, row_false, row_true = table[(s, e)]
+            if guard != 'ALWAYS' and row_false.encode(s) != row_true.encode(s):
+                pair = [row_false.encode(s), row_true.encode(s)]
+                for i in range(len(rows) - 1):
+                    if rows[i:i + 2] == pair:
+                        break
+                else:
+                    i = len(rows)
+                    rows += pair
+                trans[(s, e)] = (guard, i)
+    for s in STATES:
+        for e in EVENTS:
+            if (s, e) in trans:
+                continue
+            # the event without transition keeps the state
+            r = table[(s, e)][2].encode(s) if (s, e) in table else Row(s).encode(s)
+            if r not in rows:
+                rows.append(r)
+            trans[(s, e)] = ('ALWAYS', rows.index(r))
+    if len(rows) > 16:
+        error('%d rows, more than the 4 bits of the index' % len(rows))
+
+    out = sys.stdout
+    out.write('/**\n')
+    out.write(' * @file    buttonfsm_table.h\n')
+    out.write(' * @brief   The transitions of the button state machine, generated by tools/dia2fsm.py from doc/button.dia, do not edit\n')
+    out.write(' * @author  Yunhui Fu (yhfudev@gmail.com)\n')
+    out.write(' * @version 1.0\n')
+    out.write(' * @date    2016-07-14\n')
+    out.write(' * @copyright GPL\n')
+    out.write(' */\n\n')
+    out.write('// the distinct transitions\n')
+    out.write('static const uint16_t buttonfsm_rows[%d] PROGMEM = {\n' % len(rows))
+    for i, r in enumerate(rows):
+        out.write('    /* %2d */ %s,\n' % (i, r))
+    out.write('};\n\n')
+    out.write('// the guard and the row of each (state, event), the events are PRESSED, RELEASED, TIMEOUT\n')
+    out.write('static const uint8_t buttonfsm_trans[BUTSW_NUM_STATES][3] PROGMEM = {\n')
+    for s in STATES:
+        items = ['BUTSW_TRANS(BUTSW_GUARD_%s, %d)' % trans[(s, e)] for e in EVENTS]
+        out.write('    /* %-10s */ { %s },\n' % (s, ', '.join(items)))
+    out.write('};\n')
+
+
+if __name__ == '__main__':
+    main()